@@ -0,0 +1,221 @@
+#ifndef _EVENT_LOOP_H_
+#define _EVENT_LOOP_H_
+
+/*
+ * Command line options and event loop shared by the OpenGL samples. The loop sleeps until the
+ * window is damaged, resized, exposed or sent input, and only then redraws, unless it is told to
+ * poll or to animate on a fixed tick. A frame limit also redraws on that tick, so a run with
+ * --frames always finishes. Redraws are traced as "frame" spans and the loop's CPU cost is
+ * reported through loop_statistics.h at the end.
+ *
+ * C++ only. Include it after the OpenGL loader, which has to come before GLFW. extension_listing
+ * includes it after GLFW for the frame limit validation alone.
+ */
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "loop_statistics.h"
+#include "sample_trace.h"
+
+struct event_loop_options
+{
+    // Exits after this many redrawn frames, zero runs until the window closes
+    unsigned long frame_limit = 0;
+
+    // Turns vsync off
+    bool uncapped = false;
+
+    // Polls and redraws every iteration instead of sleeping until the window is damaged
+    bool busy = false;
+
+    // Redraws at up to max_fps while waiting for events
+    bool animate = false;
+    double max_fps = 60.0;
+};
+
+// Frame limits are whole, non-zero counts, so a limit can never turn into "run forever"
+static inline bool event_loop_parse_frame_limit(const std::string& argument, size_t prefix_length, unsigned long& frame_limit)
+{
+    const std::string value = argument.substr(prefix_length);
+
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return false;
+    }
+
+    try
+    {
+        size_t parsed_length = 0;
+        frame_limit = std::stoul(value, &parsed_length);
+        return parsed_length == value.size() && frame_limit > 0;
+    }
+    catch (const std::out_of_range&)
+    {
+        return false;
+    }
+}
+
+static inline bool event_loop_parse_rate(const std::string& argument, size_t prefix_length, double& rate)
+{
+    const std::string value = argument.substr(prefix_length);
+
+    if (value.empty() || value.find_first_not_of("0123456789.") != std::string::npos)
+    {
+        return false;
+    }
+
+    // A lone "." is rejected by std::stod, "1.2.3" stops parsing early
+    try
+    {
+        size_t parsed_length = 0;
+        rate = std::stod(value, &parsed_length);
+        return parsed_length == value.size() && rate > 0.0;
+    }
+    catch (const std::logic_error&)
+    {
+        return false;
+    }
+}
+
+// Reports the first unknown or invalid option on stderr and returns false
+static inline bool event_loop_parse_arguments(int argc, char** argv, event_loop_options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        bool valid = true;
+
+        if (argument.rfind("--frames=", 0) == 0)
+        {
+            valid = event_loop_parse_frame_limit(argument, 9, options.frame_limit);
+        }
+        else if (argument == "--uncapped")
+        {
+            options.uncapped = true;
+        }
+        else if (argument == "--busy")
+        {
+            options.busy = true;
+        }
+        else if (argument == "--animate")
+        {
+            options.animate = true;
+        }
+        else if (argument.rfind("--max-fps=", 0) == 0)
+        {
+            valid = event_loop_parse_rate(argument, 10, options.max_fps);
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Unknown or invalid option: " << argument << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Anything that changes what the window shows, or could in a sample that reacts to input
+static inline void event_loop_mark_damaged(GLFWwindow* window)
+{
+    *static_cast<bool*>(glfwGetWindowUserPointer(window)) = true;
+}
+
+/*
+ * Runs until the window closes or the frame limit is reached. draw(now) renders one frame into
+ * the current context, given the GLFW time the frame starts at, and the loop swaps buffers after
+ * it. Takes over the window's user pointer and its refresh, resize and input callbacks.
+ */
+template <typename Draw>
+void event_loop_run(GLFWwindow* window, const event_loop_options& options, Draw draw)
+{
+    if (options.uncapped)
+    {
+        glfwSwapInterval(0);
+    }
+
+    // The first frame is drawn before any event arrives
+    bool damaged = true;
+    glfwSetWindowUserPointer(window, &damaged);
+    glfwSetWindowRefreshCallback(window, event_loop_mark_damaged);
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* resized, int, int) { event_loop_mark_damaged(resized); });
+    glfwSetKeyCallback(window, [](GLFWwindow* focused, int, int, int, int) { event_loop_mark_damaged(focused); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* focused, int, int, int) { event_loop_mark_damaged(focused); });
+    glfwSetCursorPosCallback(window, [](GLFWwindow* hovered, double, double) { event_loop_mark_damaged(hovered); });
+    glfwSetScrollCallback(window, [](GLFWwindow* focused, double, double) { event_loop_mark_damaged(focused); });
+
+    // Without the tick, a frame limit would wait forever for damage once the first frame is drawn
+    const bool ticking = options.animate || options.frame_limit != 0;
+    const double frame_interval = 1.0 / options.max_fps;
+    double next_tick = glfwGetTime();
+
+    loop_statistics statistics;
+    loop_statistics_start(&statistics);
+
+    for (unsigned long frame = 0; !glfwWindowShouldClose(window) && (options.frame_limit == 0 || frame < options.frame_limit);)
+    {
+        const double now = glfwGetTime();
+
+        // Ticks fall on a fixed grid, a late frame skips the ticks it missed
+        if (ticking && now >= next_tick)
+        {
+            damaged = true;
+            next_tick = std::max(next_tick + frame_interval, now);
+        }
+
+        if (damaged || options.busy)
+        {
+            SAMPLE_TRACE_SCOPE("frame");
+            damaged = false;
+            draw(now);
+
+            const uint64_t swap_trace_start = sample_trace_begin();
+            glfwSwapBuffers(window);
+            sample_trace_end("swap_buffers", swap_trace_start);
+
+            ++statistics.redraws;
+            ++frame;
+        }
+
+        // Sleeps until an event arrives, or until the next tick
+        const uint64_t wait_trace_start = sample_trace_begin();
+
+        if (options.busy)
+        {
+            glfwPollEvents();
+        }
+        else if (ticking)
+        {
+            const double timeout = next_tick - glfwGetTime();
+
+            if (timeout > 0.0)
+            {
+                glfwWaitEventsTimeout(timeout);
+            }
+            else
+            {
+                glfwPollEvents();
+            }
+        }
+        else
+        {
+            glfwWaitEvents();
+        }
+
+        sample_trace_end("wait_events", wait_trace_start);
+        ++statistics.wakeups;
+    }
+
+    loop_statistics_report(&statistics, options.busy ? "Busy" : "Event driven", stdout);
+}
+
+#endif
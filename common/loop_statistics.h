@@ -0,0 +1,72 @@
+#ifndef _LOOP_STATISTICS_H_
+#define _LOOP_STATISTICS_H_
+
+/*
+ * CPU cost of an event loop, for comparing a loop that waits for events against one that polls.
+ * Reports the process' CPU time as a share of one core over the wall time, along with how often
+ * the loop woke up, how often it redrew and how often the process gave up the CPU voluntarily.
+ * CPU time covers every thread, including any the driver renders on.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+
+struct loop_statistics
+{
+    uint64_t start_ns;
+    uint64_t start_cpu_ns;
+    long start_voluntary_switches;
+
+    /* Counted by the loop */
+    uint64_t wakeups;
+    uint64_t redraws;
+};
+
+static inline uint64_t loop_statistics_wall_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+static inline uint64_t loop_statistics_cpu_ns(const struct rusage* usage)
+{
+    return ((uint64_t) usage->ru_utime.tv_sec + (uint64_t) usage->ru_stime.tv_sec) * 1000000000ull +
+        ((uint64_t) usage->ru_utime.tv_usec + (uint64_t) usage->ru_stime.tv_usec) * 1000ull;
+}
+
+static inline void loop_statistics_start(struct loop_statistics* statistics)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    statistics->start_ns = loop_statistics_wall_ns();
+    statistics->start_cpu_ns = loop_statistics_cpu_ns(&usage);
+    statistics->start_voluntary_switches = usage.ru_nvcsw;
+    statistics->wakeups = 0;
+    statistics->redraws = 0;
+}
+
+static inline void loop_statistics_report(const struct loop_statistics* statistics, const char* mode, FILE* output)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    const double seconds = (loop_statistics_wall_ns() - statistics->start_ns) / 1e9;
+    const double cpu_seconds = (loop_statistics_cpu_ns(&usage) - statistics->start_cpu_ns) / 1e9;
+
+    if (seconds <= 0.0)
+    {
+        return;
+    }
+
+    fprintf(output, "%s loop: %.2f s, CPU %.1f%% of one core, %.1f wakeups/s, %.1f redraws/s, "
+        "%.1f voluntary context switches/s\n", mode, seconds, cpu_seconds / seconds * 100.0,
+        statistics->wakeups / seconds, statistics->redraws / seconds,
+        (usage.ru_nvcsw - statistics->start_voluntary_switches) / seconds);
+}
+
+#endif
@@ -0,0 +1,361 @@
+#ifndef _SAMPLE_TRACE_H_
+#define _SAMPLE_TRACE_H_
+
+/*
+ * Scoped span tracer shared by the samples, usable from C and C++ and written out as Chrome
+ * trace event JSON at exit, which chrome://tracing and ui.perfetto.dev both open.
+ *
+ * sample_trace_start(path) enables tracing when path, or else the SAMPLE_TRACE environment
+ * variable, names an output file. Until then every span costs one load and one branch, and
+ * defining SAMPLE_TRACE_DISABLED before including this header turns every call into a no-op,
+ * with sample_trace_begin() returning zero.
+ *
+ * Each thread appends to a buffer of its own, registered once in a lock free list, so recording
+ * never takes a lock. The buffer is allocated on the thread's first span and holds
+ * SAMPLE_TRACE_CAPACITY spans, 24 bytes each, about 1.5 MiB at the default. Timestamps come from
+ * CLOCK_MONOTONIC. Span names are stored by pointer and must be string literals or otherwise
+ * outlive the process. A forked child drops its parent's spans and writes its own file, the path
+ * with ".<pid>" appended, on the same timeline.
+ *
+ * The shared state is defined weak, so every translation unit including this header links
+ * against the same copy without a separate implementation file. GCC or Clang in their default
+ * GNU dialects is required.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Spans recorded per thread, later ones are counted and dropped */
+#ifndef SAMPLE_TRACE_CAPACITY
+#define SAMPLE_TRACE_CAPACITY 65536
+#endif
+
+struct sample_trace_event
+{
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+struct sample_trace_buffer
+{
+    struct sample_trace_buffer* next;
+    pid_t tid;
+    const char* thread_name;
+
+    /* Written by the owning thread alone, published with release stores */
+    uint32_t count;
+    uint32_t dropped;
+    struct sample_trace_event events[SAMPLE_TRACE_CAPACITY];
+};
+
+struct sample_trace_state
+{
+    int enabled;
+    pid_t pid;
+    pid_t parent_pid;
+    uint64_t origin_ns;
+    struct sample_trace_buffer* threads;
+    char path[4096];
+};
+
+__attribute__((weak)) struct sample_trace_state sample_trace_global;
+__attribute__((weak)) __thread struct sample_trace_buffer* sample_trace_local;
+
+static inline uint64_t sample_trace_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+static inline int sample_trace_enabled(void)
+{
+    return __atomic_load_n(&sample_trace_global.enabled, __ATOMIC_RELAXED);
+}
+
+static inline struct sample_trace_buffer* sample_trace_thread_buffer(void)
+{
+    struct sample_trace_buffer* buffer = sample_trace_local;
+
+    if (buffer)
+    {
+        return buffer;
+    }
+
+    buffer = (struct sample_trace_buffer*) calloc(1, sizeof(struct sample_trace_buffer));
+
+    if (!buffer)
+    {
+        return NULL;
+    }
+
+    buffer->tid = (pid_t) syscall(SYS_gettid);
+    buffer->next = __atomic_load_n(&sample_trace_global.threads, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&sample_trace_global.threads, &buffer->next, buffer, 1, __ATOMIC_RELEASE,
+        __ATOMIC_RELAXED))
+    {
+    }
+
+    sample_trace_local = buffer;
+    return buffer;
+}
+
+/* Timestamp a span starts at, zero while tracing is disabled */
+static inline uint64_t sample_trace_begin(void)
+{
+    return sample_trace_enabled() ? sample_trace_now() : 0;
+}
+
+static inline void sample_trace_end(const char* name, uint64_t start_ns)
+{
+    if (start_ns == 0 || !sample_trace_enabled())
+    {
+        return;
+    }
+
+    const uint64_t end_ns = sample_trace_now();
+    struct sample_trace_buffer* buffer = sample_trace_thread_buffer();
+
+    if (!buffer)
+    {
+        return;
+    }
+
+    const uint32_t count = buffer->count;
+
+    if (count == SAMPLE_TRACE_CAPACITY)
+    {
+        ++buffer->dropped;
+        return;
+    }
+
+    buffer->events[count].name = name;
+    buffer->events[count].start_ns = start_ns;
+    buffer->events[count].duration_ns = end_ns - start_ns;
+    __atomic_store_n(&buffer->count, count + 1, __ATOMIC_RELEASE);
+}
+
+/* Labels the calling thread in the trace viewer, name must outlive the process */
+static inline void sample_trace_thread_name(const char* name)
+{
+    if (!sample_trace_enabled())
+    {
+        return;
+    }
+
+    struct sample_trace_buffer* buffer = sample_trace_thread_buffer();
+
+    if (buffer)
+    {
+        buffer->thread_name = name;
+    }
+}
+
+static inline void sample_trace_write_string(FILE* file, const char* text)
+{
+    fputc('"', file);
+
+    for (; *text; ++text)
+    {
+        if (*text == '"' || *text == '\\')
+        {
+            fputc('\\', file);
+        }
+
+        fputc((unsigned char) *text < 0x20 ? ' ' : *text, file);
+    }
+
+    fputc('"', file);
+}
+
+/* Stops recording and writes every thread's spans, called at exit once tracing has started */
+static inline void sample_trace_stop(void)
+{
+    if (!__atomic_exchange_n(&sample_trace_global.enabled, 0, __ATOMIC_ACQ_REL))
+    {
+        return;
+    }
+
+    char path[sizeof(sample_trace_global.path) + 16];
+
+    if (sample_trace_global.pid == sample_trace_global.parent_pid)
+    {
+        snprintf(path, sizeof(path), "%s", sample_trace_global.path);
+    }
+    else
+    {
+        snprintf(path, sizeof(path), "%s.%d", sample_trace_global.path, (int) sample_trace_global.pid);
+    }
+
+    FILE* file = fopen(path, "w");
+
+    if (!file)
+    {
+        perror("Unable to write trace");
+        return;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    const char* separator = "";
+    uint64_t dropped = 0;
+
+    for (struct sample_trace_buffer* buffer = __atomic_load_n(&sample_trace_global.threads, __ATOMIC_ACQUIRE);
+        buffer; buffer = buffer->next)
+    {
+        const uint32_t count = __atomic_load_n(&buffer->count, __ATOMIC_ACQUIRE);
+
+        if (buffer->thread_name)
+        {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                separator, (int) sample_trace_global.pid, (int) buffer->tid);
+            sample_trace_write_string(file, buffer->thread_name);
+            fprintf(file, "}}");
+            separator = ",\n";
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const struct sample_trace_event* event = &buffer->events[i];
+
+            fprintf(file, "%s{\"name\":", separator);
+            sample_trace_write_string(file, event->name);
+            fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+                (event->start_ns - sample_trace_global.origin_ns) / 1000.0, event->duration_ns / 1000.0,
+                (int) sample_trace_global.pid, (int) buffer->tid);
+            separator = ",\n";
+        }
+
+        dropped += buffer->dropped;
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    if (dropped > 0)
+    {
+        fprintf(stderr, "Trace buffers were full, %llu spans were dropped\n", (unsigned long long) dropped);
+    }
+}
+
+static inline void sample_trace_exit_handler(void)
+{
+    sample_trace_stop();
+}
+
+/* The child continues on the parent's timeline, recording only its own spans */
+static inline void sample_trace_fork_child(void)
+{
+    sample_trace_global.pid = getpid();
+
+    /* Only the forking thread exists in the child */
+    for (struct sample_trace_buffer* buffer = sample_trace_global.threads; buffer; buffer = buffer->next)
+    {
+        buffer->count = 0;
+        buffer->dropped = 0;
+
+        if (buffer != sample_trace_local)
+        {
+            buffer->thread_name = NULL;
+        }
+    }
+
+    if (sample_trace_local)
+    {
+        sample_trace_local->tid = (pid_t) syscall(SYS_gettid);
+    }
+}
+
+/*
+ * Enables tracing into path, or into the file named by SAMPLE_TRACE when path is NULL or empty,
+ * and writes the trace at exit. Does nothing when neither names a file or tracing already runs.
+ * Call it from main before any other thread starts.
+ */
+static inline void sample_trace_start(const char* path)
+{
+    if (!path || !*path)
+    {
+        path = getenv("SAMPLE_TRACE");
+    }
+
+    if (!path || !*path || sample_trace_enabled() || sample_trace_global.origin_ns != 0)
+    {
+        return;
+    }
+
+    snprintf(sample_trace_global.path, sizeof(sample_trace_global.path), "%s", path);
+    sample_trace_global.pid = getpid();
+    sample_trace_global.parent_pid = sample_trace_global.pid;
+    sample_trace_global.origin_ns = sample_trace_now();
+
+    atexit(sample_trace_exit_handler);
+    pthread_atfork(NULL, NULL, sample_trace_fork_child);
+
+    __atomic_store_n(&sample_trace_global.enabled, 1, __ATOMIC_RELEASE);
+}
+
+#define SAMPLE_TRACE_CONCAT_INNER(a, b) a##b
+#define SAMPLE_TRACE_CONCAT(a, b) SAMPLE_TRACE_CONCAT_INNER(a, b)
+
+#ifdef __cplusplus
+
+/* Records a span from construction to the end of the enclosing scope */
+struct sample_trace_scope
+{
+    explicit sample_trace_scope(const char* span_name) : name(span_name), start_ns(sample_trace_begin())
+    {
+    }
+
+    ~sample_trace_scope()
+    {
+        sample_trace_end(name, start_ns);
+    }
+
+    sample_trace_scope(const sample_trace_scope&) = delete;
+    sample_trace_scope& operator=(const sample_trace_scope&) = delete;
+
+    const char* name;
+    uint64_t start_ns;
+};
+
+#define SAMPLE_TRACE_SCOPE(name) sample_trace_scope SAMPLE_TRACE_CONCAT(sample_trace_scope_, __LINE__)(name)
+
+#else
+
+struct sample_trace_scope
+{
+    const char* name;
+    uint64_t start_ns;
+};
+
+static inline void sample_trace_scope_end(struct sample_trace_scope* scope)
+{
+    sample_trace_end(scope->name, scope->start_ns);
+}
+
+/* The cleanup attribute ends the span when the variable leaves scope, exit() skips it */
+#define SAMPLE_TRACE_SCOPE(name) \
+    struct sample_trace_scope SAMPLE_TRACE_CONCAT(sample_trace_scope_, __LINE__) \
+        __attribute__((cleanup(sample_trace_scope_end))) = {(name), sample_trace_begin()}
+
+#endif
+
+#ifdef SAMPLE_TRACE_DISABLED
+#undef SAMPLE_TRACE_SCOPE
+#define SAMPLE_TRACE_SCOPE(name) ((void) 0)
+#define sample_trace_start(path) ((void) (path))
+#define sample_trace_begin() ((uint64_t) 0)
+#define sample_trace_end(name, start_ns) ((void) (name), (void) (start_ns))
+#define sample_trace_thread_name(name) ((void) (name))
+#endif
+
+#endif
@@ -0,0 +1,248 @@
+#! /usr/bin/env python3
+
+"""Runs the graphics samples for a fixed number of frames and reports their startup phase times
+and frame throughput as JSON, optionally comparing them against a stored baseline.
+
+Timings come from the Chrome trace every sample writes through common/sample_trace.h when
+SAMPLE_TRACE is set. Spans that end before the first "frame" span are startup phases, and the
+"frame" spans give the frame rate and frame time distribution.
+"""
+
+import argparse
+import glob
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+
+LINUX_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Name, project directory under graphics/linux, binary within it, arguments besides --frames.
+# The small samples only redraw on damage by default and are run busy to measure throughput.
+SAMPLES = [
+    ("context_creation", "opengl/context_creation", "src/context_creation", ["--busy", "--uncapped"]),
+    ("extension_loading", "opengl/extension_loading", "src/extension_loading", ["--busy", "--uncapped"]),
+    ("extension_listing", "vulkan/extenson_listing", "extension_listing", ["--busy"]),
+    ("initial_primitive", "vulkan/initial_primitive", "initial_primitive",
+        ["--uncapped", "--no-validation", "--no-pipeline-cache"]),
+    ("initial_primitive_headless", "vulkan/initial_primitive", "initial_primitive",
+        ["--headless", "--no-validation", "--no-pipeline-cache"]),
+]
+
+# Metrics compared against the baseline and whether a larger value is better
+COMPARED_METRICS = {
+    "frames_per_second": True,
+    "frame_ms_p50": False,
+    "startup_ms": False,
+}
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def summarize_trace(path):
+    with open(path) as trace_file:
+        events = [event for event in json.load(trace_file)["traceEvents"] if event.get("ph") == "X"]
+
+    frames = sorted((event for event in events if event["name"] == "frame"), key=lambda event: event["ts"])
+
+    if not frames:
+        raise RuntimeError("trace has no frame spans")
+
+    first_frame = frames[0]["ts"]
+    frame_ms = [event["dur"] / 1000.0 for event in frames]
+    elapsed_ms = (frames[-1]["ts"] + frames[-1]["dur"] - first_frame) / 1000.0
+
+    # Phases nested in one another are each reported, a phase run repeatedly is summed
+    phases = {}
+
+    for event in events:
+        if event["name"] != "frame" and event["ts"] + event["dur"] <= first_frame:
+            phases[event["name"]] = phases.get(event["name"], 0.0) + event["dur"] / 1000.0
+
+    return {
+        "startup_ms": first_frame / 1000.0,
+        "phases_ms": phases,
+        "frames": len(frames),
+        "frames_per_second": len(frames) / elapsed_ms * 1000.0 if elapsed_ms > 0.0 else 0.0,
+        "frame_ms_mean": statistics.mean(frame_ms),
+        "frame_ms_p50": percentile(frame_ms, 0.5),
+        "frame_ms_p99": percentile(frame_ms, 0.99),
+    }
+
+
+def software_environment():
+    """Forces Mesa's llvmpipe for OpenGL and lavapipe for Vulkan when its ICD is installed"""
+    environment = {"LIBGL_ALWAYS_SOFTWARE": "1", "GALLIUM_DRIVER": "llvmpipe"}
+    icds = sorted(glob.glob("/usr/share/vulkan/icd.d/lvp_icd*.json"))
+
+    if icds:
+        environment["VK_ICD_FILENAMES"] = ":".join(icds)
+        environment["VK_DRIVER_FILES"] = environment["VK_ICD_FILENAMES"]
+
+    return environment
+
+
+def run_sample(binary, arguments, frames, environment, timeout):
+    command = [binary, "--frames=%d" % frames] + arguments
+
+    # Windowed samples need a display, a virtual one is used when there is none
+    if not os.environ.get("DISPLAY") and not os.environ.get("WAYLAND_DISPLAY") and "--headless" not in arguments:
+        if not shutil.which("xvfb-run"):
+            raise RuntimeError("no display and xvfb-run is not installed")
+
+        command = ["xvfb-run", "-a", "-s", "-screen 0 1280x1024x24"] + command
+
+    with tempfile.TemporaryDirectory() as directory:
+        trace_path = os.path.join(directory, "trace.json")
+        process = subprocess.run(command, env=dict(os.environ, SAMPLE_TRACE=trace_path, **environment),
+            cwd=os.path.dirname(binary), stdout=subprocess.PIPE, stderr=subprocess.STDOUT, timeout=timeout,
+            universal_newlines=True)
+
+        if process.returncode != 0 or not os.path.exists(trace_path):
+            raise RuntimeError("exited with status %d:\n%s" % (process.returncode, process.stdout))
+
+        return summarize_trace(trace_path)
+
+
+def median_of_runs(runs):
+    """Each metric is the median over the runs, which keeps one noisy run from deciding a comparison"""
+    phases = sorted(set(name for run in runs for name in run["phases_ms"]))
+
+    result = {key: statistics.median(run[key] for run in runs) for key in runs[0] if key != "phases_ms"}
+    result["phases_ms"] = {name: statistics.median(run["phases_ms"].get(name, 0.0) for run in runs) for name in phases}
+    result["runs"] = len(runs)
+
+    return result
+
+
+def compare(results, baseline, threshold):
+    """Prints each compared metric against the baseline and returns the regressions beyond threshold percent"""
+    regressions = []
+
+    print("\n%-28s %-18s %12s %12s %9s" % ("sample", "metric", "baseline", "current", "change"))
+
+    for name, result in sorted(results.items()):
+        if name not in baseline:
+            print("%-28s not in baseline" % name)
+            continue
+
+        for metric, higher_is_better in COMPARED_METRICS.items():
+            before = baseline[name].get(metric)
+            after = result.get(metric)
+
+            if not before or after is None:
+                continue
+
+            change = (after - before) / before * 100.0
+            regressed = (-change if higher_is_better else change) > threshold
+            print("%-28s %-18s %12.3f %12.3f %+8.1f%%%s" % (name, metric, before, after, change,
+                "  REGRESSION" if regressed else ""))
+
+            if regressed:
+                regressions.append("%s %s" % (name, metric))
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("samples", nargs="*", help="samples to run, all of them by default")
+    parser.add_argument("--binary", help="path of the sample binary, for samples of one project built out of tree")
+    parser.add_argument("--frames", type=int, default=500, help="frames rendered per run (default 500)")
+    parser.add_argument("--runs", type=int, default=3, help="runs per sample, metrics are their median (default 3)")
+    parser.add_argument("--output", default="bench.json", help="file the results are written to")
+    parser.add_argument("--baseline", default=os.path.join(LINUX_DIR, "bench", "baseline.json"),
+        help="results to compare against, skipped when the file does not exist")
+    parser.add_argument("--threshold", type=float, default=10.0,
+        help="percentage a compared metric may worsen by before it counts as a regression (default 10)")
+    parser.add_argument("--update-baseline", action="store_true", help="write the results to the baseline file")
+    parser.add_argument("--software", action="store_true", help="force llvmpipe and lavapipe, as on CI")
+    parser.add_argument("--timeout", type=float, default=300.0, help="seconds a single run may take")
+    arguments = parser.parse_args()
+
+    known = {sample[0]: sample for sample in SAMPLES}
+    selected = arguments.samples or [sample[0] for sample in SAMPLES]
+
+    for name in selected:
+        if name not in known:
+            parser.error("unknown sample %s, expected one of %s" % (name, ", ".join(known)))
+
+    if arguments.binary and len(set((known[name][1], known[name][2]) for name in selected)) != 1:
+        parser.error("--binary needs samples that all run the same binary")
+
+    environment = software_environment() if arguments.software else {}
+    results = {}
+    failures = []
+
+    for name in selected:
+        _, project, binary, sample_arguments = known[name]
+        binary = os.path.abspath(arguments.binary or os.path.join(LINUX_DIR, project, binary))
+
+        if not os.path.exists(binary):
+            failures.append(name)
+            print("%s: %s is not built" % (name, binary), file=sys.stderr)
+            continue
+
+        try:
+            runs = [run_sample(binary, sample_arguments, arguments.frames, environment, arguments.timeout)
+                for _ in range(arguments.runs)]
+        except (RuntimeError, subprocess.TimeoutExpired) as error:
+            failures.append(name)
+            print("%s: %s" % (name, error), file=sys.stderr)
+            continue
+
+        results[name] = median_of_runs(runs)
+        print("%s: %.1f frames/s, %.3f ms median frame, %.1f ms to the first frame" % (name,
+            results[name]["frames_per_second"], results[name]["frame_ms_p50"], results[name]["startup_ms"]))
+
+    report = {
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "software_rendering": arguments.software,
+        "frames": arguments.frames,
+        "samples": results,
+    }
+
+    with open(arguments.output, "w") as output:
+        json.dump(report, output, indent=2, sort_keys=True)
+
+    if arguments.update_baseline:
+        # Samples not run this time keep their recorded entries, so one project can update its own
+        baseline = dict(report)
+
+        if os.path.exists(arguments.baseline):
+            with open(arguments.baseline) as baseline_file:
+                baseline["samples"] = dict(json.load(baseline_file).get("samples", {}), **results)
+
+        with open(arguments.baseline, "w") as output:
+            json.dump(baseline, output, indent=2, sort_keys=True)
+
+        print("Baseline for %s written to %s" % (", ".join(sorted(results)), arguments.baseline))
+    elif os.path.exists(arguments.baseline):
+        with open(arguments.baseline) as baseline_file:
+            baseline = json.load(baseline_file)
+
+        if baseline.get("frames") != arguments.frames:
+            print("Baseline was taken at %s frames, comparing anyway" % baseline.get("frames"), file=sys.stderr)
+
+        regressions = compare(results, baseline["samples"], arguments.threshold)
+
+        if regressions:
+            print("\n%d metric(s) regressed by more than %.1f%%: %s" % (len(regressions), arguments.threshold,
+                ", ".join(regressions)), file=sys.stderr)
+            return 1
+    else:
+        print("No baseline at %s, run with --update-baseline to record one" % arguments.baseline)
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,7 +1,11 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <cmath>
 #include <iostream>
 
+#include "event_loop.h"
+#include "sample_trace.h"
+
 static void error_callback(int error, const char* description)
 {
 	std::cerr << "Error: " << description << "\n";
@@ -9,13 +13,26 @@ static void error_callback(int error, const char* description)
 
 int main (int argc, char** argv)
 {
+	event_loop_options options;
+
+	if (!event_loop_parse_arguments(argc, argv, options))
+	{
+		exit(EXIT_FAILURE);
+	}
+
+	sample_trace_start(nullptr);
 	glfwSetErrorCallback(error_callback);
 
+	const uint64_t init_trace_start = sample_trace_begin();
+
 	if (!glfwInit())
 	{
 		exit(EXIT_FAILURE);
 	}
 
+	sample_trace_end("glfw_init", init_trace_start);
+
+	const uint64_t window_trace_start = sample_trace_begin();
 	GLFWwindow* window = glfwCreateWindow(640, 480, "Context", nullptr, nullptr);
 
 	if (!window)
@@ -25,28 +42,38 @@ int main (int argc, char** argv)
 	}
 
 	glfwMakeContextCurrent(window);
+	sample_trace_end("create_context", window_trace_start);
+
+	const uint64_t load_trace_start = sample_trace_begin();
 	
 	if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
 	{
 		exit(EXIT_FAILURE);
 	}
 
+	sample_trace_end("load_gl_functions", load_trace_start);
+
 	std::cout << "OpenGL Version: " << GLVersion.major << "." << GLVersion.minor << "\n";
 
-	while (!glfwWindowShouldClose(window))
+	event_loop_run(window, options, [&](double now)
 	{
 		int width, height;
 
 		glfwGetFramebufferSize(window, &width, &height);
 		glViewport(0, 0, width, height);
-		glClear(GL_COLOR_BUFFER_BIT);
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
-	}
+		if (options.animate)
+		{
+			glClearColor(0.5f + 0.5f * static_cast<float>(std::sin(now * 2.0)), 0.2f, 0.4f, 1.0f);
+		}
+
+		glClear(GL_COLOR_BUFFER_BIT);
+	});
 
+	const uint64_t shutdown_trace_start = sample_trace_begin();
 	glfwDestroyWindow(window);
 	glfwTerminate();
+	sample_trace_end("shutdown", shutdown_trace_start);
 	return 0;
 }
 
@@ -2,22 +2,80 @@
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include <string>
+
+#include "event_loop.h"
+#include "loop_statistics.h"
+#include "sample_trace.h"
 
 int main(int argc, char** argv) 
 {
+    // --frames=N exits after N event loop iterations, so the benchmark driver can run the sample to
+    // completion, and --busy polls for events instead of sleeping until one arrives
+    unsigned long frame_limit = 0;
+    bool busy = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+
+        if (argument == "--busy")
+        {
+            busy = true;
+        }
+        else if (argument.rfind("--frames=", 0) != 0 || !event_loop_parse_frame_limit(argument, 9, frame_limit))
+        {
+            std::cerr << "Unknown or invalid option: " << argument << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    sample_trace_start(nullptr);
+
+    uint64_t trace_start = sample_trace_begin();
     glfwInit();
+    sample_trace_end("glfw_init", trace_start);
+
+    trace_start = sample_trace_begin();
     GLFWwindow* window = glfwCreateWindow(800, 600, "Vulkan", nullptr, nullptr);
+    sample_trace_end("create_window", trace_start);
 
+    trace_start = sample_trace_begin();
     uint32_t extension_count = 0;
     vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
+    sample_trace_end("enumerate_extensions", trace_start);
 
     std::cout << extension_count << " extension(s) found to be supported by the local GPU" << std::endl;
 
-    while (!glfwWindowShouldClose(window))
+    // Nothing is drawn, so the loop only has to wake up for events such as the window closing
+    loop_statistics statistics;
+    loop_statistics_start(&statistics);
+
+    for (unsigned long frame = 0; !glfwWindowShouldClose(window) && (frame_limit == 0 || frame < frame_limit); ++frame)
     {
-        glfwPollEvents();
+        SAMPLE_TRACE_SCOPE("frame");
+
+        if (busy)
+        {
+            glfwPollEvents();
+        }
+        else if (frame_limit != 0)
+        {
+            // Wakes up on its own, a run with a frame limit would otherwise wait for input to finish
+            glfwWaitEventsTimeout(1.0 / 60.0);
+        }
+        else
+        {
+            glfwWaitEvents();
+        }
+
+        ++statistics.wakeups;
     }
 
+    loop_statistics_report(&statistics, busy ? "Busy" : "Event driven", stdout);
+
+    trace_start = sample_trace_begin();
     glfwDestroyWindow(window);
     glfwTerminate();
+    sample_trace_end("shutdown", trace_start);
 }
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "async_uploader.hpp"
+
+#include <stdexcept>
+
+static VkCommandPool create_resettable_command_pool(VkDevice logical_device, uint32_t queue_family_index)
+{
+    VkCommandPool command_pool;
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    command_pool_create_info.queueFamilyIndex = queue_family_index;
+
+    if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create upload command pool");
+    }
+
+    return command_pool;
+}
+
+static VkCommandBuffer allocate_command_buffer(VkDevice logical_device, VkCommandPool command_pool)
+{
+    VkCommandBuffer command_buffer;
+    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocation_info.commandPool = command_pool;
+    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocation_info.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, &command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate upload command buffer");
+    }
+
+    return command_buffer;
+}
+
+static void begin_one_time(VkCommandBuffer command_buffer)
+{
+    vkResetCommandBuffer(command_buffer, 0);
+
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to begin recording upload command buffer");
+    }
+}
+
+void async_uploader::create(const device_context& device, memory_allocator& memory, uint32_t slot_count,
+    VkDeviceSize slot_capacity)
+{
+    allocator = &memory;
+    logical_device = device.logical_device;
+    transfer_queue = device.transfer_queue;
+    transfer_queue_index = device.transfer_queue_index;
+    graphics_queue_index = device.graphics_queue_index;
+
+    transfer_command_pool = create_resettable_command_pool(logical_device, transfer_queue_index);
+
+    if (dedicated())
+    {
+        acquire_command_pool = create_resettable_command_pool(logical_device, graphics_queue_index);
+    }
+
+    slots.resize(slot_count);
+
+    for (slot_state& slot : slots)
+    {
+        slot.staging = create_buffer(memory, slot_capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        slot.transfer_command_buffer = allocate_command_buffer(logical_device, transfer_command_pool);
+
+        if (dedicated())
+        {
+            slot.acquire_command_buffer = allocate_command_buffer(logical_device, acquire_command_pool);
+        }
+
+        VkSemaphoreCreateInfo semaphore_create_info{};
+        semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        if (vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &slot.copied) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create upload semaphore");
+        }
+    }
+}
+
+void async_uploader::destroy()
+{
+    for (slot_state& slot : slots)
+    {
+        vkDestroySemaphore(logical_device, slot.copied, nullptr);
+        destroy_buffer(*allocator, slot.staging);
+    }
+
+    if (acquire_command_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(logical_device, acquire_command_pool, nullptr);
+    }
+
+    if (transfer_command_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(logical_device, transfer_command_pool, nullptr);
+    }
+
+    slots.clear();
+    acquire_command_pool = VK_NULL_HANDLE;
+    transfer_command_pool = VK_NULL_HANDLE;
+}
+
+bool async_uploader::dedicated() const
+{
+    return transfer_queue_index != graphics_queue_index;
+}
+
+void* async_uploader::staging(uint32_t slot) const
+{
+    return slots[slot].staging.allocation.mapped;
+}
+
+void async_uploader::copy(uint32_t slot_index, VkDeviceSize staging_offset, VkBuffer destination,
+    VkDeviceSize destination_offset, VkDeviceSize size, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    slot_state& slot = slots[slot_index];
+
+    if (!slot.recording)
+    {
+        begin_one_time(slot.transfer_command_buffer);
+        slot.recording = true;
+    }
+
+    // The destination's previous contents are discarded, so the graphics queue never has to
+    // release it back before the copy
+    VkBufferCopy copy_region{};
+    copy_region.srcOffset = staging_offset;
+    copy_region.dstOffset = destination_offset;
+    copy_region.size = size;
+    vkCmdCopyBuffer(slot.transfer_command_buffer, slot.staging.buffer, destination, 1, &copy_region);
+
+    slot.dst_stages |= dst_stage;
+
+    if (dedicated())
+    {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = dst_access;
+        barrier.srcQueueFamilyIndex = transfer_queue_index;
+        barrier.dstQueueFamilyIndex = graphics_queue_index;
+        barrier.buffer = destination;
+        barrier.offset = destination_offset;
+        barrier.size = size;
+
+        slot.ownership_barriers.push_back(barrier);
+    }
+}
+
+void async_uploader::submit(uint32_t slot_index, VkSemaphore& wait_semaphore, VkPipelineStageFlags& wait_stage,
+    VkCommandBuffer& acquire_command_buffer)
+{
+    slot_state& slot = slots[slot_index];
+
+    wait_semaphore = VK_NULL_HANDLE;
+    wait_stage = 0;
+    acquire_command_buffer = VK_NULL_HANDLE;
+
+    if (!slot.recording)
+    {
+        return;
+    }
+
+    // Release half of the ownership transfer, its destination access is ignored on this queue
+    if (dedicated())
+    {
+        std::vector<VkBufferMemoryBarrier> release_barriers = slot.ownership_barriers;
+
+        for (VkBufferMemoryBarrier& barrier : release_barriers)
+        {
+            barrier.dstAccessMask = 0;
+        }
+
+        vkCmdPipelineBarrier(slot.transfer_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, 0, nullptr, static_cast<uint32_t>(release_barriers.size()), release_barriers.data(), 0, nullptr);
+    }
+
+    if (vkEndCommandBuffer(slot.transfer_command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to record upload command buffer");
+    }
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &slot.transfer_command_buffer;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &slot.copied;
+
+    if (vkQueueSubmit(transfer_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to submit upload");
+    }
+
+    // Acquire half, recorded for the graphics queue and ordered after the semaphore wait
+    if (dedicated())
+    {
+        begin_one_time(slot.acquire_command_buffer);
+
+        for (VkBufferMemoryBarrier& barrier : slot.ownership_barriers)
+        {
+            barrier.srcAccessMask = 0;
+        }
+
+        vkCmdPipelineBarrier(slot.acquire_command_buffer, slot.dst_stages, slot.dst_stages, 0, 0, nullptr,
+            static_cast<uint32_t>(slot.ownership_barriers.size()), slot.ownership_barriers.data(), 0, nullptr);
+
+        if (vkEndCommandBuffer(slot.acquire_command_buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to record upload acquire command buffer");
+        }
+
+        acquire_command_buffer = slot.acquire_command_buffer;
+    }
+
+    wait_semaphore = slot.copied;
+    wait_stage = slot.dst_stages;
+
+    slot.ownership_barriers.clear();
+    slot.dst_stages = 0;
+    slot.recording = false;
+}
@@ -0,0 +1,60 @@
+#ifndef _ASYNC_UPLOADER_HPP_
+#define _ASYNC_UPLOADER_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+#include "geometry.hpp"
+#include "memory_allocator.hpp"
+
+#include <vector>
+
+// Copies from persistently mapped staging buffers on the transfer queue so uploads do not
+// serialize with rendering. Each slot is reused only after the graphics submission that consumed
+// its previous upload has finished, which also guarantees the copy itself is done.
+class async_uploader
+{
+public:
+    void create(const device_context& device, memory_allocator& allocator, uint32_t slot_count, VkDeviceSize slot_capacity);
+    void destroy();
+
+    // True when copies run on a queue family other than graphics and need ownership transfers
+    bool dedicated() const;
+
+    // Host address of the slot's staging buffer
+    void* staging(uint32_t slot) const;
+
+    // Records a copy out of the slot's staging buffer, dst_stage and dst_access describe how the
+    // graphics queue reads the destination
+    void copy(uint32_t slot, VkDeviceSize staging_offset, VkBuffer destination, VkDeviceSize destination_offset,
+        VkDeviceSize size, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+
+    // Submits the slot's copies. The graphics submission consuming them must wait on the semaphore
+    // at wait_stage and execute the acquire command buffer, when not VK_NULL_HANDLE, before its own.
+    void submit(uint32_t slot, VkSemaphore& wait_semaphore, VkPipelineStageFlags& wait_stage,
+        VkCommandBuffer& acquire_command_buffer);
+
+private:
+    struct slot_state
+    {
+        gpu_buffer staging;
+        VkCommandBuffer transfer_command_buffer = VK_NULL_HANDLE;
+        VkCommandBuffer acquire_command_buffer = VK_NULL_HANDLE;
+        VkSemaphore copied = VK_NULL_HANDLE;
+        std::vector<VkBufferMemoryBarrier> ownership_barriers;
+        VkPipelineStageFlags dst_stages = 0;
+        bool recording = false;
+    };
+
+    memory_allocator* allocator = nullptr;
+    VkDevice logical_device = VK_NULL_HANDLE;
+    VkQueue transfer_queue = VK_NULL_HANDLE;
+    uint32_t transfer_queue_index = 0;
+    uint32_t graphics_queue_index = 0;
+    VkCommandPool transfer_command_pool = VK_NULL_HANDLE;
+    VkCommandPool acquire_command_pool = VK_NULL_HANDLE;
+    std::vector<slot_state> slots;
+};
+
+#endif
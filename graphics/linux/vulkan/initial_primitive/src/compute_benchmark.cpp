@@ -0,0 +1,774 @@
+#include "compute_benchmark.hpp"
+
+#include "frame_statistics.hpp"
+#include "geometry.hpp"
+#include "memory_allocator.hpp"
+#include "renderer.hpp"
+#include "sample_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Specialized into every kernel, the reduction and scan need a power of two
+static const uint32_t compute_workgroup_size = 256;
+
+// Elements each scan invocation handles sequentially, itemsPerInvocation in scan.comp
+static const uint32_t scan_items_per_invocation = 4;
+static const uint32_t scan_block_size = compute_workgroup_size * scan_items_per_invocation;
+
+// Workgroups of the first reduction pass, the second pass sums their partials in one workgroup
+static const uint32_t reduce_groups = 1024;
+
+static const VkDeviceSize smallest_buffer = 1ull << 20;
+static const VkDeviceSize staging_size = 64ull << 20;
+
+// Enough for the deepest scan, one set per level
+static const uint32_t max_descriptor_sets = 8;
+
+// Push constants shared by the kernels, the Kernel block of each shader
+struct kernel_constants
+{
+    uint32_t count = 0;
+    uint32_t phase = 0;
+    float a = 0.0f;
+};
+
+struct benchmark_context
+{
+    VkDevice logical_device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    memory_allocator allocator;
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    gpu_buffer staging;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+    uint32_t max_group_count = 65535;
+
+    // VK_NULL_HANDLE when the queue has no timestamps, kernels are then timed on the host
+    VkQueryPool query_pool = VK_NULL_HANDLE;
+    double timestamp_period = 1.0;
+    uint64_t timestamp_mask = 0;
+};
+
+struct kernel_result
+{
+    double milliseconds = 0.0;
+    bool valid = true;
+    std::string failure;
+};
+
+// Deterministic inputs the host reference can regenerate element by element. SAXPY's values are
+// small multiples of one half, so a * x + y is exact with or without a fused multiply add.
+static float saxpy_x(uint64_t i)
+{
+    return static_cast<float>(i % 1024) * 0.5f;
+}
+
+static float saxpy_y(uint64_t i)
+{
+    return static_cast<float>(i % 7);
+}
+
+static const float saxpy_a = 2.0f;
+
+static uint32_t integer_input(uint64_t i)
+{
+    return (static_cast<uint32_t>(i) * 2654435761u) >> 24;
+}
+
+static void begin_commands(benchmark_context& context)
+{
+    vkResetCommandBuffer(context.command_buffer, 0);
+
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(context.command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to begin recording compute benchmark commands");
+    }
+}
+
+// Submits the recorded commands and waits for them, returning the host side time
+static double submit_and_wait(benchmark_context& context)
+{
+    if (vkEndCommandBuffer(context.command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to record compute benchmark commands");
+    }
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &context.command_buffer;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (vkQueueSubmit(context.queue, 1, &submit_info, context.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to submit compute benchmark commands");
+    }
+
+    vkWaitForFences(context.logical_device, 1, &context.fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(context.logical_device, 1, &context.fence);
+
+    return milliseconds_between(start, std::chrono::steady_clock::now());
+}
+
+// Kernel writes made visible to the next dispatch or copy
+static void kernel_barrier(VkCommandBuffer command_buffer)
+{
+    VkMemoryBarrier memory_barrier{};
+    memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+}
+
+// Fills a device local buffer through the staging buffer, one chunk at a time so the host never
+// holds a copy of the whole buffer
+static void upload(benchmark_context& context, const gpu_buffer& target,
+    const std::function<void(void* chunk, VkDeviceSize first_byte, VkDeviceSize size)>& fill)
+{
+    for (VkDeviceSize offset = 0; offset < target.size; offset += staging_size)
+    {
+        const VkDeviceSize size = std::min(staging_size, target.size - offset);
+        fill(context.staging.allocation.mapped, offset, size);
+
+        begin_commands(context);
+
+        const VkBufferCopy region = {0, offset, size};
+        vkCmdCopyBuffer(context.command_buffer, context.staging.buffer, target.buffer, 1, &region);
+
+        submit_and_wait(context);
+    }
+}
+
+// Reads the first size bytes of a device local buffer back a chunk at a time
+static void download(benchmark_context& context, const gpu_buffer& source, VkDeviceSize size,
+    const std::function<void(const void* chunk, VkDeviceSize first_byte, VkDeviceSize size)>& check)
+{
+    for (VkDeviceSize offset = 0; offset < size; offset += staging_size)
+    {
+        const VkDeviceSize chunk_size = std::min(staging_size, size - offset);
+
+        begin_commands(context);
+
+        const VkBufferCopy region = {offset, 0, chunk_size};
+        vkCmdCopyBuffer(context.command_buffer, source.buffer, context.staging.buffer, 1, &region);
+
+        submit_and_wait(context);
+        check(context.staging.allocation.mapped, offset, chunk_size);
+    }
+}
+
+static VkDescriptorSet bind_buffers(benchmark_context& context, VkBuffer first, VkBuffer second)
+{
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = context.descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = 1;
+    descriptor_set_allocate_info.pSetLayouts = &context.set_layout;
+
+    VkDescriptorSet descriptor_set;
+
+    if (vkAllocateDescriptorSets(context.logical_device, &descriptor_set_allocate_info, &descriptor_set) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate compute benchmark descriptor set");
+    }
+
+    const VkDescriptorBufferInfo buffer_infos[] = {
+        {first, 0, VK_WHOLE_SIZE},
+        {second, 0, VK_WHOLE_SIZE}
+    };
+
+    VkWriteDescriptorSet writes[2]{};
+
+    for (uint32_t binding = 0; binding < 2; ++binding)
+    {
+        writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet = descriptor_set;
+        writes[binding].dstBinding = binding;
+        writes[binding].descriptorCount = 1;
+        writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[binding].pBufferInfo = &buffer_infos[binding];
+    }
+
+    vkUpdateDescriptorSets(context.logical_device, 2, writes, 0, nullptr);
+
+    return descriptor_set;
+}
+
+// Workgroups beyond the limit of the first dimension are dispatched along the second
+static void dispatch(benchmark_context& context, VkPipeline pipeline, VkDescriptorSet descriptor_set,
+    const kernel_constants& constants, uint32_t group_count)
+{
+    const uint32_t width = std::min(group_count, context.max_group_count);
+
+    vkCmdBindPipeline(context.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(context.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, context.pipeline_layout, 0, 1,
+        &descriptor_set, 0, nullptr);
+    vkCmdPushConstants(context.command_buffer, context.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+        sizeof(constants), &constants);
+    vkCmdDispatch(context.command_buffer, width, (group_count + width - 1) / width, 1);
+}
+
+// Grid stride kernels need no more workgroups than cover the elements once
+static uint32_t strided_groups(const benchmark_context& context, uint64_t count)
+{
+    return static_cast<uint32_t>(std::min<uint64_t>((count + compute_workgroup_size - 1) / compute_workgroup_size,
+        context.max_group_count));
+}
+
+// Records iterations of a kernel between two timestamps and returns the time of one iteration,
+// measured on the GPU when the queue has timestamps
+static double time_iterations(benchmark_context& context, uint32_t iterations, const std::function<void()>& record)
+{
+    begin_commands(context);
+
+    if (context.query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(context.command_buffer, context.query_pool, 0, 2);
+        vkCmdWriteTimestamp(context.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, context.query_pool, 0);
+    }
+
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        record();
+        kernel_barrier(context.command_buffer);
+    }
+
+    if (context.query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(context.command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, context.query_pool, 1);
+    }
+
+    const double host_milliseconds = submit_and_wait(context);
+
+    if (context.query_pool == VK_NULL_HANDLE)
+    {
+        return host_milliseconds / iterations;
+    }
+
+    uint64_t timestamps[2];
+
+    if (vkGetQueryPoolResults(context.logical_device, context.query_pool, 0, 2, sizeof(timestamps), timestamps,
+            sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+    {
+        return host_milliseconds / iterations;
+    }
+
+    return ((timestamps[1] - timestamps[0]) & context.timestamp_mask) * context.timestamp_period / 1e6 / iterations;
+}
+
+static kernel_result run_saxpy(benchmark_context& context, VkPipeline pipeline, VkDeviceSize bytes, uint32_t iterations)
+{
+    const uint32_t count = static_cast<uint32_t>(bytes / sizeof(float));
+    const VkBufferUsageFlags usage =
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    gpu_buffer x = create_buffer(context.allocator, bytes, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    gpu_buffer y = create_buffer(context.allocator, bytes, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    upload(context, x, [](void* chunk, VkDeviceSize first_byte, VkDeviceSize size) {
+        float* values = static_cast<float*>(chunk);
+
+        for (VkDeviceSize i = 0; i < size / sizeof(float); ++i)
+        {
+            values[i] = saxpy_x(first_byte / sizeof(float) + i);
+        }
+    });
+
+    upload(context, y, [](void* chunk, VkDeviceSize first_byte, VkDeviceSize size) {
+        float* values = static_cast<float*>(chunk);
+
+        for (VkDeviceSize i = 0; i < size / sizeof(float); ++i)
+        {
+            values[i] = saxpy_y(first_byte / sizeof(float) + i);
+        }
+    });
+
+    vkResetDescriptorPool(context.logical_device, context.descriptor_pool, 0);
+    const VkDescriptorSet descriptor_set = bind_buffers(context, x.buffer, y.buffer);
+
+    kernel_constants constants;
+    constants.count = count;
+    constants.a = saxpy_a;
+
+    auto record = [&]() {
+        dispatch(context, pipeline, descriptor_set, constants, strided_groups(context, count));
+    };
+
+    // The first run is checked, the timed runs then keep accumulating into y
+    begin_commands(context);
+    record();
+    kernel_barrier(context.command_buffer);
+    submit_and_wait(context);
+
+    kernel_result result;
+
+    download(context, y, bytes, [&](const void* chunk, VkDeviceSize first_byte, VkDeviceSize size) {
+        const float* values = static_cast<const float*>(chunk);
+
+        for (VkDeviceSize i = 0; i < size / sizeof(float) && result.valid; ++i)
+        {
+            const uint64_t index = first_byte / sizeof(float) + i;
+
+            if (values[i] != saxpy_a * saxpy_x(index) + saxpy_y(index))
+            {
+                result.valid = false;
+                result.failure = "element " + std::to_string(index) + " is " + std::to_string(values[i]);
+            }
+        }
+    });
+
+    result.milliseconds = time_iterations(context, iterations, record);
+
+    destroy_buffer(context.allocator, y);
+    destroy_buffer(context.allocator, x);
+
+    return result;
+}
+
+static kernel_result run_reduction(benchmark_context& context, VkPipeline pipeline, VkDeviceSize bytes, uint32_t iterations)
+{
+    const uint32_t count = static_cast<uint32_t>(bytes / sizeof(uint32_t));
+    const uint32_t first_pass_groups = std::min(reduce_groups, strided_groups(context, count));
+    const VkBufferUsageFlags usage =
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    gpu_buffer source = create_buffer(context.allocator, bytes, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    gpu_buffer partials = create_buffer(context.allocator, first_pass_groups * sizeof(uint32_t), usage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    gpu_buffer total = create_buffer(context.allocator, sizeof(uint32_t), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    uint32_t expected = 0;
+
+    upload(context, source, [&](void* chunk, VkDeviceSize first_byte, VkDeviceSize size) {
+        uint32_t* values = static_cast<uint32_t*>(chunk);
+
+        for (VkDeviceSize i = 0; i < size / sizeof(uint32_t); ++i)
+        {
+            values[i] = integer_input(first_byte / sizeof(uint32_t) + i);
+            expected += values[i];
+        }
+    });
+
+    vkResetDescriptorPool(context.logical_device, context.descriptor_pool, 0);
+    const VkDescriptorSet first_pass_set = bind_buffers(context, source.buffer, partials.buffer);
+    const VkDescriptorSet second_pass_set = bind_buffers(context, partials.buffer, total.buffer);
+
+    auto record = [&]() {
+        kernel_constants constants;
+        constants.count = count;
+        dispatch(context, pipeline, first_pass_set, constants, first_pass_groups);
+        kernel_barrier(context.command_buffer);
+
+        constants.count = first_pass_groups;
+        dispatch(context, pipeline, second_pass_set, constants, 1);
+    };
+
+    begin_commands(context);
+    record();
+    kernel_barrier(context.command_buffer);
+    submit_and_wait(context);
+
+    kernel_result result;
+
+    download(context, total, sizeof(uint32_t), [&](const void* chunk, VkDeviceSize, VkDeviceSize) {
+        uint32_t sum;
+        std::memcpy(&sum, chunk, sizeof(sum));
+
+        if (sum != expected)
+        {
+            result.valid = false;
+            result.failure = "sum is " + std::to_string(sum) + ", expected " + std::to_string(expected);
+        }
+    });
+
+    result.milliseconds = time_iterations(context, iterations, record);
+
+    destroy_buffer(context.allocator, total);
+    destroy_buffer(context.allocator, partials);
+    destroy_buffer(context.allocator, source);
+
+    return result;
+}
+
+static kernel_result run_scan(benchmark_context& context, VkPipeline pipeline, VkDeviceSize bytes, uint32_t iterations)
+{
+    const VkBufferUsageFlags usage =
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    // Level 0 is the data, every further level holds the block totals of the one before, down to a
+    // level of a single block whose total lands in a one element buffer
+    std::vector<uint32_t> counts = {static_cast<uint32_t>(bytes / sizeof(uint32_t))};
+
+    while (counts.back() > 1)
+    {
+        counts.push_back((counts.back() + scan_block_size - 1) / scan_block_size);
+    }
+
+    if (counts.size() - 1 > max_descriptor_sets)
+    {
+        throw std::runtime_error("Scan needs more levels than the benchmark has descriptor sets for");
+    }
+
+    std::vector<gpu_buffer> levels;
+
+    for (uint32_t count : counts)
+    {
+        levels.push_back(create_buffer(context.allocator, count * sizeof(uint32_t), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+    }
+
+    vkResetDescriptorPool(context.logical_device, context.descriptor_pool, 0);
+    std::vector<VkDescriptorSet> level_sets;
+
+    for (size_t level = 0; level + 1 < levels.size(); ++level)
+    {
+        level_sets.push_back(bind_buffers(context, levels[level].buffer, levels[level + 1].buffer));
+    }
+
+    upload(context, levels[0], [](void* chunk, VkDeviceSize first_byte, VkDeviceSize size) {
+        uint32_t* values = static_cast<uint32_t*>(chunk);
+
+        for (VkDeviceSize i = 0; i < size / sizeof(uint32_t); ++i)
+        {
+            values[i] = integer_input(first_byte / sizeof(uint32_t) + i);
+        }
+    });
+
+    auto record = [&]() {
+        kernel_constants constants;
+
+        // Scan each level's blocks and collect their totals in the next level
+        for (size_t level = 0; level < level_sets.size(); ++level)
+        {
+            constants.count = counts[level];
+            constants.phase = 0;
+            dispatch(context, pipeline, level_sets[level], constants, counts[level + 1]);
+            kernel_barrier(context.command_buffer);
+        }
+
+        // Then add the scanned totals back from the coarsest level down
+        for (size_t level = level_sets.size() - 1; level-- > 0;)
+        {
+            constants.count = counts[level];
+            constants.phase = 1;
+            dispatch(context, pipeline, level_sets[level], constants, counts[level + 1]);
+            kernel_barrier(context.command_buffer);
+        }
+    };
+
+    begin_commands(context);
+    record();
+    submit_and_wait(context);
+
+    kernel_result result;
+    uint32_t running = 0;
+
+    download(context, levels[0], bytes, [&](const void* chunk, VkDeviceSize first_byte, VkDeviceSize size) {
+        const uint32_t* values = static_cast<const uint32_t*>(chunk);
+
+        for (VkDeviceSize i = 0; i < size / sizeof(uint32_t) && result.valid; ++i)
+        {
+            const uint64_t index = first_byte / sizeof(uint32_t) + i;
+            running += integer_input(index);
+
+            if (values[i] != running)
+            {
+                result.valid = false;
+                result.failure = "element " + std::to_string(index) + " is " + std::to_string(values[i]) +
+                    ", expected " + std::to_string(running);
+            }
+        }
+    });
+
+    result.milliseconds = time_iterations(context, iterations, record);
+
+    for (gpu_buffer& level : levels)
+    {
+        destroy_buffer(context.allocator, level);
+    }
+
+    return result;
+}
+
+static VkPipeline create_kernel_pipeline(VkDevice logical_device, VkPipelineLayout pipeline_layout, const std::string& name,
+    const std::string& shader_directory)
+{
+    VkShaderModule compute_shader_module = load_shader_module(logical_device, name, shader_directory);
+
+    const VkSpecializationMapEntry workgroup_size_entry = {0, 0, sizeof(compute_workgroup_size)};
+
+    VkSpecializationInfo specialization_info{};
+    specialization_info.mapEntryCount = 1;
+    specialization_info.pMapEntries = &workgroup_size_entry;
+    specialization_info.dataSize = sizeof(compute_workgroup_size);
+    specialization_info.pData = &compute_workgroup_size;
+
+    VkComputePipelineCreateInfo pipeline_create_info{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = compute_shader_module;
+    pipeline_create_info.stage.pName = "main";
+    pipeline_create_info.stage.pSpecializationInfo = &specialization_info;
+    pipeline_create_info.layout = pipeline_layout;
+
+    VkPipeline pipeline;
+
+    if (vkCreateComputePipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create compute benchmark pipeline for " + name);
+    }
+
+    vkDestroyShaderModule(logical_device, compute_shader_module, nullptr);
+
+    return pipeline;
+}
+
+// Largest buffer the benchmark uses, a whole number of MiB that fits a storage buffer descriptor
+// and leaves room in the largest device local heap for SAXPY's two buffers
+static VkDeviceSize largest_buffer(const device_context& device, VkDeviceSize requested)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.physical_device, &properties);
+
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(device.physical_device, &memory_properties);
+
+    VkDeviceSize heap_size = 0;
+
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i)
+    {
+        if (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            heap_size = std::max(heap_size, memory_properties.memoryHeaps[i].size);
+        }
+    }
+
+    const VkDeviceSize limit = std::min<VkDeviceSize>({requested, properties.limits.maxStorageBufferRange, heap_size / 4});
+
+    return std::max(smallest_buffer, limit / smallest_buffer * smallest_buffer);
+}
+
+bool run_compute_benchmark(const options& settings, const device_context& device)
+{
+    benchmark_context context;
+    context.logical_device = device.logical_device;
+    context.queue = device.graphics_queue;
+    context.allocator.create(device.physical_device, device.logical_device);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.physical_device, &properties);
+    context.max_group_count = properties.limits.maxComputeWorkGroupCount[0];
+
+    // Command buffer and fence every submission goes through
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    command_pool_create_info.queueFamilyIndex = device.graphics_queue_index;
+
+    if (vkCreateCommandPool(context.logical_device, &command_pool_create_info, nullptr, &context.command_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create compute benchmark command pool");
+    }
+
+    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocation_info.commandPool = context.command_pool;
+    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocation_info.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(context.logical_device, &command_buffer_allocation_info, &context.command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate compute benchmark command buffer");
+    }
+
+    VkFenceCreateInfo fence_create_info{};
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(context.logical_device, &fence_create_info, nullptr, &context.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create compute benchmark fence");
+    }
+
+    context.staging = create_buffer(context.allocator, staging_size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Timestamps, when the queue family writes them
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device.physical_device, &queue_family_count, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device.physical_device, &queue_family_count, queue_families.data());
+
+    const uint32_t valid_bits = queue_families.at(device.graphics_queue_index).timestampValidBits;
+
+    if (valid_bits > 0)
+    {
+        context.timestamp_period = properties.limits.timestampPeriod;
+        context.timestamp_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+        VkQueryPoolCreateInfo query_pool_create_info{};
+        query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_create_info.queryCount = 2;
+
+        if (vkCreateQueryPool(context.logical_device, &query_pool_create_info, nullptr, &context.query_pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create compute benchmark query pool");
+        }
+    }
+
+    // Every kernel reads one storage buffer at binding 0 and writes one at binding 1
+    VkDescriptorSetLayoutBinding bindings[2]{};
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = 2;
+    descriptor_set_layout_create_info.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(context.logical_device, &descriptor_set_layout_create_info, nullptr, &context.set_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create compute benchmark descriptor set layout");
+    }
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(kernel_constants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &context.set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(context.logical_device, &pipeline_layout_create_info, nullptr, &context.pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create compute benchmark pipeline layout");
+    }
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = max_descriptor_sets * 2;
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = max_descriptor_sets;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(context.logical_device, &descriptor_pool_create_info, nullptr, &context.descriptor_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create compute benchmark descriptor pool");
+    }
+
+    const VkPipeline saxpy_pipeline = create_kernel_pipeline(context.logical_device, context.pipeline_layout, "saxpy.spv",
+        settings.shader_directory);
+    const VkPipeline reduce_pipeline = create_kernel_pipeline(context.logical_device, context.pipeline_layout, "reduce.spv",
+        settings.shader_directory);
+    const VkPipeline scan_pipeline = create_kernel_pipeline(context.logical_device, context.pipeline_layout, "scan.spv",
+        settings.shader_directory);
+
+    // Buffer sizes grow fourfold from 1 MiB, ending at the largest size allowed
+    const VkDeviceSize largest = largest_buffer(device, settings.compute_benchmark_mib << 20);
+    std::vector<VkDeviceSize> sizes;
+
+    for (VkDeviceSize size = smallest_buffer; size < largest; size *= 4)
+    {
+        sizes.push_back(size);
+    }
+
+    sizes.push_back(largest);
+
+    std::cout << "Compute benchmark on " << properties.deviceName << ", times from "
+              << (context.query_pool != VK_NULL_HANDLE ? "GPU timestamps" : "host submission") << ", buffers up to "
+              << (largest >> 20) << " MiB\n";
+    std::cout << std::fixed << std::setprecision(3);
+
+    // Bytes each kernel has to move per element at the least, reads plus writes
+    struct kernel
+    {
+        const char* name;
+        VkPipeline pipeline;
+        uint32_t bytes_per_element;
+        kernel_result (*run)(benchmark_context&, VkPipeline, VkDeviceSize, uint32_t);
+    };
+
+    const kernel kernels[] = {
+        {"saxpy", saxpy_pipeline, 12, run_saxpy},
+        {"reduction", reduce_pipeline, 4, run_reduction},
+        {"scan", scan_pipeline, 8, run_scan}
+    };
+
+    bool valid = true;
+
+    for (const kernel& benchmarked : kernels)
+    {
+        for (VkDeviceSize size : sizes)
+        {
+            SAMPLE_TRACE_SCOPE(benchmarked.name);
+
+            // Small buffers run often enough that the timestamps resolve them
+            const uint32_t iterations = static_cast<uint32_t>(std::clamp<VkDeviceSize>((1ull << 30) / size, 1, 64));
+            const uint64_t elements = size / sizeof(uint32_t);
+            const kernel_result result = benchmarked.run(context, benchmarked.pipeline, size, iterations);
+            const double seconds = result.milliseconds / 1000.0;
+
+            std::cout << "  " << std::left << std::setw(10) << benchmarked.name << std::right << std::setw(6) << (size >> 20)
+                      << " MiB: " << std::setw(10) << result.milliseconds << " ms, "
+                      << std::setw(9) << (seconds > 0.0 ? elements * benchmarked.bytes_per_element / seconds / 1e9 : 0.0)
+                      << " GB/s, " << std::setw(9) << (seconds > 0.0 ? elements / seconds / 1e9 : 0.0) << " Gelements/s, "
+                      << (result.valid ? "matches host" : "MISMATCH, " + result.failure) << "\n";
+
+            valid = valid && result.valid;
+        }
+    }
+
+    std::cout << std::defaultfloat;
+
+    vkDestroyPipeline(context.logical_device, scan_pipeline, nullptr);
+    vkDestroyPipeline(context.logical_device, reduce_pipeline, nullptr);
+    vkDestroyPipeline(context.logical_device, saxpy_pipeline, nullptr);
+    vkDestroyDescriptorPool(context.logical_device, context.descriptor_pool, nullptr);
+    vkDestroyPipelineLayout(context.logical_device, context.pipeline_layout, nullptr);
+    vkDestroyDescriptorSetLayout(context.logical_device, context.set_layout, nullptr);
+
+    if (context.query_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(context.logical_device, context.query_pool, nullptr);
+    }
+
+    destroy_buffer(context.allocator, context.staging);
+    vkDestroyFence(context.logical_device, context.fence, nullptr);
+    vkDestroyCommandPool(context.logical_device, context.command_pool, nullptr);
+    context.allocator.destroy();
+
+    return valid;
+}
@@ -0,0 +1,13 @@
+#ifndef _COMPUTE_BENCHMARK_HPP_
+#define _COMPUTE_BENCHMARK_HPP_
+
+#include "device.hpp"
+#include "options.hpp"
+
+// Runs SAXPY, a two pass reduction and a multi-level prefix scan over buffers from 1 MiB up to
+// settings.compute_benchmark_mib, capped by the device's storage buffer range and local heap,
+// and reports the time, bandwidth and element rate of each. Every kernel's first run is read back
+// and checked against a reference computed on the host. Returns false when any check failed.
+bool run_compute_benchmark(const options& settings, const device_context& device);
+
+#endif
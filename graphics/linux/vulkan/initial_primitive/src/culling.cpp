@@ -0,0 +1,361 @@
+#include "culling.hpp"
+
+#include "renderer.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// Specialized into cull.comp's local_size_x
+static const uint32_t cull_workgroup_size = 64;
+
+// Distance of the triangle's furthest vertex from its center, rounded up, matching cull.comp
+static const float triangle_radius = 0.7072f;
+
+struct cull_push_constants
+{
+    uint32_t instance_count;
+    uint32_t index_count;
+    uint32_t per_object;
+};
+
+cull_mode cull_mode_from_name(const std::string& name)
+{
+    if (name == "none")
+    {
+        return cull_mode::none;
+    }
+    else if (name == "cpu")
+    {
+        return cull_mode::cpu;
+    }
+    else if (name == "gpu")
+    {
+        return cull_mode::gpu;
+    }
+
+    throw std::runtime_error("Unknown cull mode: " + name);
+}
+
+void instance_culler::create(const device_context& device, memory_allocator& memory, VkPipelineCache pipeline_cache,
+    cull_mode culling, const scene_geometry& geometry, const std::vector<VkBuffer>& sources,
+    const std::string& shader_directory)
+{
+    mode = culling;
+    allocator = &memory;
+    logical_device = device.logical_device;
+    slots.resize(sources.size());
+
+    if (mode == cull_mode::cpu)
+    {
+        instances.resize(geometry.instance_count);
+        layout_instances(instances.data(), geometry.instance_count, geometry.world_scale, 0.0f);
+
+        for (slot_state& slot : slots)
+        {
+            slot.visible = create_buffer(memory, geometry.instances.size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        }
+    }
+    else if (mode == cull_mode::gpu)
+    {
+        create_gpu_resources(device, pipeline_cache, geometry, sources, shader_directory);
+    }
+}
+
+void instance_culler::create_gpu_resources(const device_context& device, VkPipelineCache pipeline_cache,
+    const scene_geometry& geometry, const std::vector<VkBuffer>& sources, const std::string& shader_directory)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.physical_device, &properties);
+
+    if (geometry.draw_per_object)
+    {
+        if (!device.enabled_features.multiDrawIndirect || !device.enabled_features.drawIndirectFirstInstance)
+        {
+            throw std::runtime_error("GPU culling with one draw per object needs multiDrawIndirect and drawIndirectFirstInstance");
+        }
+
+        if (geometry.instance_count > properties.limits.maxDrawIndirectCount)
+        {
+            throw std::runtime_error("Instance count exceeds maxDrawIndirectCount");
+        }
+
+        if (has_extension(device, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+        {
+            draw_indexed_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                vkGetDeviceProcAddr(logical_device, "vkCmdDrawIndexedIndirectCountKHR"));
+        }
+    }
+
+    // Descriptor set layout, source, visible, commands and count
+    std::vector<VkDescriptorSetLayoutBinding> bindings(4);
+
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    descriptor_set_layout_create_info.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &descriptor_set_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create culling descriptor set layout");
+    }
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(cull_push_constants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create culling pipeline layout");
+    }
+
+    // Compute pipeline
+    VkShaderModule compute_shader_module = load_shader_module(logical_device, "cull.spv", shader_directory);
+
+    const VkSpecializationMapEntry workgroup_size_entry = {0, 0, sizeof(cull_workgroup_size)};
+
+    VkSpecializationInfo specialization_info{};
+    specialization_info.mapEntryCount = 1;
+    specialization_info.pMapEntries = &workgroup_size_entry;
+    specialization_info.dataSize = sizeof(cull_workgroup_size);
+    specialization_info.pData = &cull_workgroup_size;
+
+    VkComputePipelineCreateInfo pipeline_create_info{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = compute_shader_module;
+    pipeline_create_info.stage.pName = "main";
+    pipeline_create_info.stage.pSpecializationInfo = &specialization_info;
+    pipeline_create_info.layout = pipeline_layout;
+
+    if (vkCreateComputePipelines(logical_device, pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create culling pipeline");
+    }
+
+    vkDestroyShaderModule(logical_device, compute_shader_module, nullptr);
+
+    // Descriptor sets and command buffers, one per slot
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = static_cast<uint32_t>(slots.size() * bindings.size());
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = static_cast<uint32_t>(slots.size());
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &descriptor_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create culling descriptor pool");
+    }
+
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.queueFamilyIndex = device.graphics_queue_index;
+
+    if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create culling command pool");
+    }
+
+    const VkDeviceSize command_stride = sizeof(VkDrawIndexedIndirectCommand);
+    const VkDeviceSize commands_size = geometry.draw_per_object ? command_stride * geometry.instance_count : command_stride;
+
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        slot_state& slot = slots[i];
+
+        slot.visible = create_buffer(*allocator, geometry.instances.size,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        slot.commands = create_buffer(*allocator, commands_size,
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        slot.count = create_buffer(*allocator, sizeof(uint32_t),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptor_set_allocate_info.descriptorPool = descriptor_pool;
+        descriptor_set_allocate_info.descriptorSetCount = 1;
+        descriptor_set_allocate_info.pSetLayouts = &descriptor_set_layout;
+
+        if (vkAllocateDescriptorSets(logical_device, &descriptor_set_allocate_info, &slot.descriptor_set) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to allocate culling descriptor set");
+        }
+
+        const VkDescriptorBufferInfo buffer_infos[] = {
+            {sources[i], 0, VK_WHOLE_SIZE},
+            {slot.visible.buffer, 0, VK_WHOLE_SIZE},
+            {slot.commands.buffer, 0, VK_WHOLE_SIZE},
+            {slot.count.buffer, 0, VK_WHOLE_SIZE}
+        };
+
+        std::vector<VkWriteDescriptorSet> writes(bindings.size());
+
+        for (uint32_t binding = 0; binding < writes.size(); ++binding)
+        {
+            writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet = slot.descriptor_set;
+            writes[binding].dstBinding = binding;
+            writes[binding].descriptorCount = 1;
+            writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[binding].pBufferInfo = &buffer_infos[binding];
+        }
+
+        vkUpdateDescriptorSets(logical_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        // The culling work never changes, so each slot's command buffer is recorded once
+        VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+        command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        command_buffer_allocation_info.commandPool = command_pool;
+        command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        command_buffer_allocation_info.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, &slot.command_buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to allocate culling command buffer");
+        }
+
+        VkCommandBufferBeginInfo command_buffer_begin_info{};
+        command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        if (vkBeginCommandBuffer(slot.command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to begin recording culling command buffer");
+        }
+
+        // Reset the visible count and commands, culled per object commands stay at zero instances
+        vkCmdFillBuffer(slot.command_buffer, slot.count.buffer, 0, sizeof(uint32_t), 0);
+
+        if (geometry.draw_per_object)
+        {
+            vkCmdFillBuffer(slot.command_buffer, slot.commands.buffer, 0, VK_WHOLE_SIZE, 0);
+        }
+        else
+        {
+            const VkDrawIndexedIndirectCommand initial_command = {geometry.index_count, 0, 0, 0, 0};
+            vkCmdUpdateBuffer(slot.command_buffer, slot.commands.buffer, 0, sizeof(initial_command), &initial_command);
+        }
+
+        VkMemoryBarrier reset_barrier{};
+        reset_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(slot.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &reset_barrier, 0, nullptr, 0, nullptr);
+
+        const cull_push_constants push_constants = {geometry.instance_count, geometry.index_count,
+            geometry.draw_per_object ? 1u : 0u};
+
+        vkCmdBindPipeline(slot.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(slot.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1,
+            &slot.descriptor_set, 0, nullptr);
+        vkCmdPushConstants(slot.command_buffer, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants),
+            &push_constants);
+        vkCmdDispatch(slot.command_buffer, (geometry.instance_count + cull_workgroup_size - 1) / cull_workgroup_size, 1, 1);
+
+        // The frame submitted after this buffer reads the results as draw parameters and vertices
+        VkMemoryBarrier cull_barrier{};
+        cull_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cull_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        cull_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+        vkCmdPipelineBarrier(slot.command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &cull_barrier, 0, nullptr, 0, nullptr);
+
+        if (vkEndCommandBuffer(slot.command_buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to record culling command buffer");
+        }
+    }
+}
+
+void instance_culler::destroy()
+{
+    for (slot_state& slot : slots)
+    {
+        destroy_buffer(*allocator, slot.count);
+        destroy_buffer(*allocator, slot.commands);
+        destroy_buffer(*allocator, slot.visible);
+    }
+
+    // Destroying the pools frees the command buffers and descriptor sets
+    if (command_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(logical_device, command_pool, nullptr);
+        vkDestroyDescriptorPool(logical_device, descriptor_pool, nullptr);
+        vkDestroyPipeline(logical_device, pipeline, nullptr);
+        vkDestroyPipelineLayout(logical_device, pipeline_layout, nullptr);
+        vkDestroyDescriptorSetLayout(logical_device, descriptor_set_layout, nullptr);
+    }
+
+    slots.clear();
+    command_pool = VK_NULL_HANDLE;
+}
+
+scene_geometry instance_culler::cull(uint32_t slot_index, const scene_geometry& geometry, VkCommandBuffer& compute_command_buffer)
+{
+    slot_state& slot = slots[slot_index];
+    scene_geometry culled = geometry;
+    compute_command_buffer = VK_NULL_HANDLE;
+
+    if (mode == cull_mode::cpu)
+    {
+        instance_attributes* visible = static_cast<instance_attributes*>(slot.visible.allocation.mapped);
+        uint32_t visible_count = 0;
+
+        for (const instance_attributes& candidate : instances)
+        {
+            // Bounding circle of the triangle, which may be rotated by the frame uniforms
+            const float extent = triangle_radius * candidate.scale;
+
+            if (std::fabs(candidate.offset[0]) <= 1.0f + extent && std::fabs(candidate.offset[1]) <= 1.0f + extent)
+            {
+                visible[visible_count++] = candidate;
+            }
+        }
+
+        culled.instances = slot.visible;
+        culled.instance_count = visible_count;
+        culled_frames += 1;
+        visible_total += visible_count;
+    }
+    else if (mode == cull_mode::gpu)
+    {
+        culled.instances = slot.visible;
+        culled.indirect_commands = slot.commands.buffer;
+        culled.indirect_count = slot.count.buffer;
+        culled.draw_indexed_indirect_count = draw_indexed_indirect_count;
+        compute_command_buffer = slot.command_buffer;
+    }
+
+    return culled;
+}
+
+double instance_culler::average_visible() const
+{
+    return culled_frames > 0 ? static_cast<double>(visible_total) / culled_frames : 0.0;
+}
@@ -0,0 +1,75 @@
+#ifndef _CULLING_HPP_
+#define _CULLING_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+#include "geometry.hpp"
+#include "memory_allocator.hpp"
+
+#include <string>
+#include <vector>
+
+// Removes instances outside the framebuffer before they reach the vertex shader
+enum class cull_mode
+{
+    none,
+    cpu,
+    gpu
+};
+
+cull_mode cull_mode_from_name(const std::string& name);
+
+// CPU culling tests every instance on the host and writes the visible ones to a mapped buffer.
+// GPU culling runs a compute pass that compacts the visible instances and writes the indirect
+// draw commands, recorded once per slot and submitted ahead of the frame's command buffer.
+class instance_culler
+{
+public:
+    // sources holds the instance buffer each slot culls, they need storage buffer usage for GPU culling.
+    // An empty shader_directory uses the embedded cull shader.
+    void create(const device_context& device, memory_allocator& allocator, VkPipelineCache pipeline_cache,
+        cull_mode mode, const scene_geometry& geometry, const std::vector<VkBuffer>& sources,
+        const std::string& shader_directory);
+    void destroy();
+
+    // Returns the geometry the slot's frame should draw. For GPU culling, compute_command_buffer is
+    // set to the buffer that must be submitted before the frame in the same batch.
+    scene_geometry cull(uint32_t slot, const scene_geometry& geometry, VkCommandBuffer& compute_command_buffer);
+
+    // Average number of instances drawn per frame, only known for CPU culling
+    double average_visible() const;
+
+private:
+    void create_gpu_resources(const device_context& device, VkPipelineCache pipeline_cache,
+        const scene_geometry& geometry, const std::vector<VkBuffer>& sources, const std::string& shader_directory);
+
+    struct slot_state
+    {
+        gpu_buffer visible;
+        gpu_buffer commands;
+        gpu_buffer count;
+        VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    };
+
+    cull_mode mode = cull_mode::none;
+    memory_allocator* allocator = nullptr;
+    VkDevice logical_device = VK_NULL_HANDLE;
+    std::vector<slot_state> slots;
+
+    // Host copy of the instances for CPU culling
+    std::vector<instance_attributes> instances;
+    uint64_t culled_frames = 0;
+    uint64_t visible_total = 0;
+
+    VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    PFN_vkCmdDrawIndexedIndirectCountKHR draw_indexed_indirect_count = nullptr;
+};
+
+#endif
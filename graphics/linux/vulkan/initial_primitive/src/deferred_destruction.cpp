@@ -0,0 +1,69 @@
+#include "deferred_destruction.hpp"
+
+void deferred_destruction::create(VkDevice device, uint32_t fence_count)
+{
+    logical_device = device;
+    submission_counts.assign(fence_count, 0);
+    retired_counts.assign(fence_count, 0);
+}
+
+void deferred_destruction::destroy()
+{
+    for (retired_swapchain& retired : queue)
+    {
+        destroy_swapchain(logical_device, retired.swapchain);
+    }
+
+    queue.clear();
+    submission_counts.clear();
+    retired_counts.clear();
+}
+
+void deferred_destruction::submitted(uint32_t fence_index)
+{
+    submission_counts[fence_index] += 1;
+}
+
+void deferred_destruction::waited(uint32_t fence_index)
+{
+    retired_counts[fence_index] = submission_counts[fence_index];
+}
+
+void deferred_destruction::retire(swapchain_context& swapchain)
+{
+    retired_swapchain retired;
+    retired.swapchain = swapchain;
+    retired.submissions = submission_counts;
+    queue.push_back(retired);
+    swapchain = swapchain_context{};
+}
+
+size_t deferred_destruction::collect()
+{
+    size_t destroyed = 0;
+
+    // Swapchains are retired in order, so once one is still in use so are the ones behind it
+    while (!queue.empty())
+    {
+        const retired_swapchain& oldest = queue.front();
+
+        for (size_t i = 0; i < retired_counts.size(); ++i)
+        {
+            if (retired_counts[i] < oldest.submissions[i])
+            {
+                return destroyed;
+            }
+        }
+
+        destroy_swapchain(logical_device, queue.front().swapchain);
+        queue.pop_front();
+        ++destroyed;
+    }
+
+    return destroyed;
+}
+
+size_t deferred_destruction::pending() const
+{
+    return queue.size();
+}
@@ -0,0 +1,52 @@
+#ifndef _DEFERRED_DESTRUCTION_HPP_
+#define _DEFERRED_DESTRUCTION_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "swapchain.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Holds swapchains replaced by a resize until every frame that may still use them has retired,
+// so a resize never waits on the device. Submissions are counted per frame fence, and a
+// swapchain is destroyed once each fence has been waited on past the submissions made before it
+// was retired. Fences are only reset after a wait, so no fence status ever has to be queried.
+class deferred_destruction
+{
+public:
+    void create(VkDevice logical_device, uint32_t fence_count);
+
+    // Destroys everything still queued, every fence must have been waited on
+    void destroy();
+
+    // Called after each submission signalling the fence and after each wait on it
+    void submitted(uint32_t fence_index);
+    void waited(uint32_t fence_index);
+
+    // Queues the swapchain behind every submission made so far
+    void retire(swapchain_context& swapchain);
+
+    // Destroys the swapchains whose frames have all retired, returning how many were destroyed
+    size_t collect();
+
+    size_t pending() const;
+
+private:
+    struct retired_swapchain
+    {
+        swapchain_context swapchain;
+
+        // Per fence submission count that has to be waited on before destruction
+        std::vector<uint64_t> submissions;
+    };
+
+    VkDevice logical_device = VK_NULL_HANDLE;
+    std::vector<uint64_t> submission_counts;
+    std::vector<uint64_t> retired_counts;
+    std::deque<retired_swapchain> queue;
+};
+
+#endif
@@ -0,0 +1,497 @@
+#include "device.hpp"
+
+#include "sample_trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+// Environment variable overriding the scored device choice, by index or name substring
+static const char* device_override_variable = "INITIAL_PRIMITIVE_DEVICE";
+
+static const char* device_type_name(VkPhysicalDeviceType type)
+{
+    switch (type)
+    {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            return "discrete";
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            return "integrated";
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            return "virtual";
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            return "cpu";
+        default:
+            return "other";
+    }
+}
+
+// Ranks a physical device, negative when it cannot run the sample at all. Device type dominates
+// (discrete > integrated > virtual > cpu), then device local heap size, then dedicated transfer
+// and compute families and the optional extensions present.
+static int64_t score_device(VkPhysicalDevice device, VkSurfaceKHR surface, const std::vector<const char*>& optional_extensions)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, queue_families.data());
+
+    bool graphics_supported = false;
+    bool present_supported = surface == VK_NULL_HANDLE;
+    int64_t queue_score = 0;
+
+    for (uint32_t i = 0; i < queue_family_count; ++i)
+    {
+        const VkQueueFlags flags = queue_families[i].queueFlags;
+
+        if (flags & VK_QUEUE_GRAPHICS_BIT)
+        {
+            graphics_supported = true;
+        }
+        else if (flags & (VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT))
+        {
+            // Async compute or transfer family usable by the streaming path
+            queue_score += 1;
+        }
+
+        if (surface != VK_NULL_HANDLE)
+        {
+            VkBool32 present_support = false;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+            present_supported = present_supported || present_support;
+        }
+    }
+
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
+
+    auto extension_available = [&](const char* name) {
+        return std::any_of(available_extensions.begin(), available_extensions.end(),
+            [&](const VkExtensionProperties& extension) { return std::strcmp(extension.extensionName, name) == 0; });
+    };
+
+    if (!graphics_supported || !present_supported ||
+        (surface != VK_NULL_HANDLE && !extension_available(VK_KHR_SWAPCHAIN_EXTENSION_NAME)))
+    {
+        return -1;
+    }
+
+    int64_t extension_score = 0;
+
+    for (const char* optional_extension : optional_extensions)
+    {
+        extension_score += extension_available(optional_extension) ? 1 : 0;
+    }
+
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(device, &memory_properties);
+
+    int64_t local_heap_mib = 0;
+
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i)
+    {
+        if (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            local_heap_mib = std::max<int64_t>(local_heap_mib, memory_properties.memoryHeaps[i].size >> 20);
+        }
+    }
+
+    int64_t type_score = 0;
+
+    switch (properties.deviceType)
+    {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            type_score = 4;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            type_score = 3;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            type_score = 2;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            type_score = 1;
+            break;
+        default:
+            break;
+    }
+
+    // Each term stays below the weight of the term before it
+    return (type_score << 40) + (std::min<int64_t>(local_heap_mib, (1 << 24) - 1) << 16) + (queue_score << 8) + extension_score;
+}
+
+VkInstance create_instance(const std::vector<const char*>& extensions, bool enable_validation)
+{
+    SAMPLE_TRACE_SCOPE("create_instance");
+
+    // Application information
+    VkApplicationInfo app_info{};
+    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_info.pApplicationName = "Initial Vulkan Primitive";
+    app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.pEngineName = "None";
+    app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.apiVersion = VK_API_VERSION_1_1;
+
+    // Create information
+    VkInstanceCreateInfo instance_create_info{};
+    instance_create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_create_info.pApplicationInfo = &app_info;
+
+    const std::vector<const char*> validation_layers = {
+        "VK_LAYER_KHRONOS_validation"
+    };
+
+    if (enable_validation)
+    {
+        uint32_t available_layers_count;
+        vkEnumerateInstanceLayerProperties(&available_layers_count, nullptr);
+
+        std::vector<VkLayerProperties> available_layers(available_layers_count);
+        vkEnumerateInstanceLayerProperties(&available_layers_count, available_layers.data());
+
+        std::set<std::string> required_layers(validation_layers.begin(), validation_layers.end());
+
+        for (const auto& layer : available_layers)
+        {
+            required_layers.erase(layer.layerName);
+        }
+
+        if (!required_layers.empty())
+        {
+            throw std::runtime_error("Required layers are unavailable");
+        }
+
+        instance_create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
+        instance_create_info.ppEnabledLayerNames = validation_layers.data();
+    }
+
+    instance_create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    instance_create_info.ppEnabledExtensionNames = extensions.data();
+
+    // Instance creation
+    VkInstance instance;
+
+    if (vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Vulkan instance");
+    }
+
+    return instance;
+}
+
+device_context create_device(VkInstance instance, VkSurfaceKHR surface,
+    const std::vector<const char*>& optional_extensions)
+{
+    SAMPLE_TRACE_SCOPE("create_device");
+    device_context context{};
+
+    // Physical device enumeration
+    uint32_t device_count = 0;
+    vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
+
+    if (device_count == 0)
+    {
+        throw std::runtime_error("No devices with Vulkan support found");
+    }
+
+    std::vector<VkPhysicalDevice> devices(device_count);
+    vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
+
+    // Physical device selection, the override is a device index or part of the device name
+    const char* device_override = std::getenv(device_override_variable);
+    const bool has_override = device_override != nullptr && *device_override != '\0';
+    std::optional<uint32_t> override_index;
+
+    if (has_override && std::string(device_override).find_first_not_of("0123456789") == std::string::npos)
+    {
+        // strtoull saturates on overflow, which is out of range as well
+        const unsigned long long requested = std::strtoull(device_override, nullptr, 10);
+
+        if (requested >= device_count)
+        {
+            throw std::runtime_error(std::string(device_override_variable) + "=" + device_override +
+                " is not a device index, " + std::to_string(device_count) + " device(s) found");
+        }
+
+        override_index = static_cast<uint32_t>(requested);
+    }
+
+    int64_t best_score = -1;
+
+    for (uint32_t i = 0; i < device_count; ++i)
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(devices[i], &properties);
+
+        const int64_t score = score_device(devices[i], surface, optional_extensions);
+
+        if (has_override)
+        {
+            if (override_index.has_value() ? override_index.value() != i :
+                std::strstr(properties.deviceName, device_override) == nullptr)
+            {
+                continue;
+            }
+
+            if (score < 0)
+            {
+                throw std::runtime_error(std::string("Device selected by ") + device_override_variable + " is unsuitable: " +
+                    properties.deviceName);
+            }
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            context.physical_device = devices[i];
+        }
+    }
+
+    if (context.physical_device == VK_NULL_HANDLE)
+    {
+        throw std::runtime_error(has_override
+            ? std::string("No device matches ") + device_override_variable + "=" + device_override
+            : std::string("No suitable GPU found"));
+    }
+
+    VkPhysicalDeviceProperties selected_properties;
+    vkGetPhysicalDeviceProperties(context.physical_device, &selected_properties);
+    std::cout << "Device: " << selected_properties.deviceName << " (" << device_type_name(selected_properties.deviceType)
+              << ", score " << best_score << ")\n";
+
+    // Swapchain extension validation, only needed when presenting
+    if (surface != VK_NULL_HANDLE)
+    {
+        context.enabled_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
+
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(context.physical_device, nullptr, &extension_count, nullptr);
+
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(context.physical_device, nullptr, &extension_count, available_extensions.data());
+    std::set<std::string> required_extensions(context.enabled_extensions.begin(), context.enabled_extensions.end());
+
+    for (const auto& extension : available_extensions)
+    {
+        required_extensions.erase(extension.extensionName);
+    }
+
+    if (!required_extensions.empty())
+    {
+        throw std::runtime_error("One or more required device extensions are unavailable");
+    }
+
+    for (const char* optional_extension : optional_extensions)
+    {
+        for (const auto& extension : available_extensions)
+        {
+            if (std::strcmp(extension.extensionName, optional_extension) == 0)
+            {
+                context.enabled_extensions.push_back(optional_extension);
+                break;
+            }
+        }
+    }
+
+    // Present wait needs both extensions and their features, which are only queryable on 1.1 devices
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(context.physical_device, &device_properties);
+
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+    present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features{};
+    present_id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    present_id_features.pNext = &present_wait_features;
+
+    if (has_extension(context, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+        has_extension(context, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) &&
+        device_properties.apiVersion >= VK_API_VERSION_1_1)
+    {
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &present_id_features;
+        vkGetPhysicalDeviceFeatures2(context.physical_device, &features);
+
+        context.present_wait_supported = present_id_features.presentId && present_wait_features.presentWait;
+    }
+
+    if (!context.present_wait_supported)
+    {
+        context.enabled_extensions.erase(std::remove_if(context.enabled_extensions.begin(), context.enabled_extensions.end(),
+            [](const char* extension) {
+                return std::strcmp(extension, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0 ||
+                       std::strcmp(extension, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0;
+            }), context.enabled_extensions.end());
+    }
+
+    // Queue family enumeration
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context.physical_device, &queue_family_count, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(context.physical_device, &queue_family_count, queue_families.data());
+
+    uint32_t index = 0;
+    std::optional<uint32_t> graphics_queue_index;
+    std::optional<uint32_t> graphics_present_queue_index;
+    std::optional<uint32_t> transfer_only_queue_index;
+    std::optional<uint32_t> async_compute_queue_index;
+
+    for (const auto& queue_family : queue_families)
+    {
+        VkBool32 present_support = false;
+
+        if (surface != VK_NULL_HANDLE)
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(context.physical_device, index, surface, &present_support);
+
+            if (present_support && !context.present_queue_index.has_value())
+            {
+                context.present_queue_index = index;
+            }
+        }
+
+        if (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        {
+            if (!graphics_queue_index.has_value())
+            {
+                graphics_queue_index = index;
+            }
+
+            if (present_support && !graphics_present_queue_index.has_value())
+            {
+                graphics_present_queue_index = index;
+            }
+        }
+        else if ((queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT) && !async_compute_queue_index.has_value())
+        {
+            // Compute queues support transfers whether or not they advertise the bit
+            async_compute_queue_index = index;
+        }
+        else if ((queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT) && !transfer_only_queue_index.has_value())
+        {
+            transfer_only_queue_index = index;
+        }
+
+        ++index;
+    }
+
+    if (!graphics_queue_index.has_value())
+    {
+        throw std::runtime_error("No queue family with graphics command support found");
+    }
+
+    if (surface != VK_NULL_HANDLE && !context.present_queue_index.has_value())
+    {
+        throw std::runtime_error("No queue family with present support found");
+    }
+
+    // One family for both avoids transferring swapchain images between queues, else the first of each
+    if (graphics_present_queue_index.has_value())
+    {
+        graphics_queue_index = graphics_present_queue_index;
+        context.present_queue_index = graphics_present_queue_index;
+    }
+
+    context.graphics_queue_index = graphics_queue_index.value();
+    context.transfer_queue_index = transfer_only_queue_index.value_or(
+        async_compute_queue_index.value_or(context.graphics_queue_index));
+
+    // Logical device creation
+    std::vector<VkDeviceQueueCreateInfo> queue_creation_infos;
+    std::set<uint32_t> unique_queue_indicies = {context.graphics_queue_index, context.transfer_queue_index};
+
+    if (context.present_queue_index.has_value())
+    {
+        unique_queue_indicies.insert(context.present_queue_index.value());
+    }
+
+    float queue_priority = 1.0f;
+
+    for (const auto& queue_index : unique_queue_indicies)
+    {
+        VkDeviceQueueCreateInfo queue_create_info{};
+        queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queue_create_info.queueFamilyIndex = queue_index;
+        queue_create_info.queueCount = 1;
+        queue_create_info.pQueuePriorities = &queue_priority;
+
+        queue_creation_infos.push_back(queue_create_info);
+    }
+
+    // Indirect draws with many commands and non-zero first instances, used by GPU culling
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(context.physical_device, &supported_features);
+    context.enabled_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+    context.enabled_features.drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance;
+
+    VkPhysicalDeviceFeatures logical_device_features = context.enabled_features;
+    VkDeviceCreateInfo device_create_info{};
+    device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_create_info.pNext = context.present_wait_supported ? &present_id_features : nullptr;
+    device_create_info.pQueueCreateInfos = queue_creation_infos.data();
+    device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_creation_infos.size());
+    device_create_info.pEnabledFeatures = &logical_device_features;
+    device_create_info.enabledExtensionCount = static_cast<uint32_t>(context.enabled_extensions.size());
+    device_create_info.ppEnabledExtensionNames = context.enabled_extensions.data();
+    device_create_info.enabledLayerCount = 0;
+
+    if (vkCreateDevice(context.physical_device, &device_create_info, nullptr, &context.logical_device) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create logical device");
+    }
+
+    // Queue handle retrieval
+    vkGetDeviceQueue(context.logical_device, context.graphics_queue_index, 0, &context.graphics_queue);
+    vkGetDeviceQueue(context.logical_device, context.transfer_queue_index, 0, &context.transfer_queue);
+
+    if (context.present_queue_index.has_value())
+    {
+        vkGetDeviceQueue(context.logical_device, context.present_queue_index.value(), 0, &context.present_queue);
+    }
+
+    return context;
+}
+
+bool has_extension(const device_context& device, const char* extension)
+{
+    for (const char* enabled_extension : device.enabled_extensions)
+    {
+        if (std::strcmp(enabled_extension, extension) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t find_memory_type(VkPhysicalDevice physical_device, uint32_t type_bits, VkMemoryPropertyFlags properties)
+{
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+    {
+        if ((type_bits & (1u << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("No suitable memory type found");
+}
@@ -0,0 +1,44 @@
+#ifndef _DEVICE_HPP_
+#define _DEVICE_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <optional>
+#include <vector>
+
+// Physical and logical device state shared by the windowed and headless paths
+struct device_context
+{
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    VkDevice logical_device = VK_NULL_HANDLE;
+    uint32_t graphics_queue_index = 0;
+    std::optional<uint32_t> present_queue_index;
+    VkQueue graphics_queue = VK_NULL_HANDLE;
+    VkQueue present_queue = VK_NULL_HANDLE;
+
+    // Prefers a transfer only family, then a compute family without graphics, and falls back to
+    // the graphics family, in which case transfer_queue is graphics_queue
+    uint32_t transfer_queue_index = 0;
+    VkQueue transfer_queue = VK_NULL_HANDLE;
+    std::vector<const char*> enabled_extensions;
+
+    // VK_KHR_present_id and VK_KHR_present_wait are enabled along with their features
+    bool present_wait_supported = false;
+
+    // Core features turned on whenever the device has them, currently the indirect draw features
+    VkPhysicalDeviceFeatures enabled_features{};
+};
+
+VkInstance create_instance(const std::vector<const char*>& extensions, bool enable_validation);
+
+// Selects a physical device and creates the logical device, surface may be VK_NULL_HANDLE
+// when no presentation support is needed. Optional extensions are enabled when available.
+device_context create_device(VkInstance instance, VkSurfaceKHR surface,
+    const std::vector<const char*>& optional_extensions = {});
+
+bool has_extension(const device_context& device, const char* extension);
+
+uint32_t find_memory_type(VkPhysicalDevice physical_device, uint32_t type_bits, VkMemoryPropertyFlags properties);
+
+#endif
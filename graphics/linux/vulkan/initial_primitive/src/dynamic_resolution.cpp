@@ -0,0 +1,240 @@
+#include "dynamic_resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void dynamic_resolution::create(const device_context& device, memory_allocator& allocator, VkRenderPass pass,
+    VkFormat target_format, VkExtent2D extent, uint32_t slots, double target, float minimum_scale)
+{
+    logical_device = device.logical_device;
+    memory = &allocator;
+    render_pass = pass;
+    format = target_format;
+    slot_count = slots;
+    target_milliseconds = target;
+    min_scale = minimum_scale;
+
+    // Both the offscreen and the swapchain images have the format, so one check covers both ends
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(device.physical_device, format, &format_properties);
+
+    const VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+
+    if ((format_properties.optimalTilingFeatures & blit_features) != blit_features)
+    {
+        throw std::runtime_error("Swapchain format does not support blits, which dynamic resolution scales with");
+    }
+
+    filter = (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+        ? VK_FILTER_LINEAR
+        : VK_FILTER_NEAREST;
+
+    output_extent = extent;
+    create_targets(extent);
+}
+
+void dynamic_resolution::destroy()
+{
+    destroy_targets();
+}
+
+bool dynamic_resolution::needs_reallocation(VkExtent2D extent) const
+{
+    return extent.width > capacity.width || extent.height > capacity.height;
+}
+
+void dynamic_resolution::resize(VkExtent2D extent)
+{
+    // Growing both ways at once keeps alternating resizes from reallocating every time
+    if (needs_reallocation(extent))
+    {
+        const VkExtent2D grown{std::max(extent.width, capacity.width), std::max(extent.height, capacity.height)};
+        destroy_targets();
+        create_targets(grown);
+        ++reallocations;
+    }
+
+    output_extent = extent;
+}
+
+void dynamic_resolution::record(double frame_milliseconds)
+{
+    ++measured_frames;
+    hit_frames += frame_milliseconds <= target_milliseconds ? 1 : 0;
+    scale_total += current_scale;
+
+    // Frames still in flight were recorded at the previous scale and say nothing about this one
+    if (++frames_since_change <= slot_count)
+    {
+        return;
+    }
+
+    // The average restarts at each scale, a single slow frame barely moves it afterwards
+    smoothed_milliseconds = frames_since_change == slot_count + 1
+        ? frame_milliseconds
+        : smoothed_milliseconds + smoothing * (frame_milliseconds - smoothed_milliseconds);
+
+    if (frames_since_change < slot_count + settle_frames || smoothed_milliseconds <= 0.0)
+    {
+        return;
+    }
+
+    // Anything between the headroom and the target is left alone, outside of it the scale aims
+    // for the middle of that band
+    if (smoothed_milliseconds <= target_milliseconds && smoothed_milliseconds >= target_milliseconds * headroom)
+    {
+        return;
+    }
+
+    const double aim = target_milliseconds * (1.0 + headroom) / 2.0;
+    const float step = static_cast<float>(std::sqrt(aim / smoothed_milliseconds));
+    const float next_scale = std::clamp(current_scale * std::clamp(step, max_step_down, max_step_up), min_scale, 1.0f);
+
+    // Changes below a pixel in a hundred are not worth a frame of settling
+    if (std::fabs(next_scale - current_scale) < 0.01f)
+    {
+        return;
+    }
+
+    current_scale = next_scale;
+    lowest_scale = std::min(lowest_scale, current_scale);
+    frames_since_change = 0;
+    ++scale_changes;
+}
+
+float dynamic_resolution::scale() const
+{
+    return current_scale;
+}
+
+double dynamic_resolution::target() const
+{
+    return target_milliseconds;
+}
+
+double dynamic_resolution::hit_rate() const
+{
+    return measured_frames > 0 ? static_cast<double>(hit_frames) / measured_frames : 0.0;
+}
+
+VkExtent2D dynamic_resolution::render_extent() const
+{
+    return VkExtent2D{
+        std::clamp(static_cast<uint32_t>(std::lround(output_extent.width * current_scale)), 1u, capacity.width),
+        std::clamp(static_cast<uint32_t>(std::lround(output_extent.height * current_scale)), 1u, capacity.height)
+    };
+}
+
+VkFramebuffer dynamic_resolution::framebuffer(uint32_t slot) const
+{
+    return framebuffers.at(slot);
+}
+
+frame_blit dynamic_resolution::blit(uint32_t slot, VkImage destination) const
+{
+    frame_blit upscale;
+    upscale.source = images.at(slot);
+    upscale.source_extent = render_extent();
+    upscale.destination = destination;
+    upscale.destination_extent = output_extent;
+    upscale.filter = filter;
+
+    return upscale;
+}
+
+void dynamic_resolution::report(std::ostream& output, const std::string& source) const
+{
+    const VkExtent2D extent = render_extent();
+
+    output << "Dynamic resolution: " << target_milliseconds << " ms target from " << source << ", "
+           << hit_rate() * 100.0 << "% of " << measured_frames << " frames on target\n";
+    output << "  scale: " << current_scale << " current, "
+           << (measured_frames > 0 ? scale_total / measured_frames : current_scale) << " average, " << lowest_scale
+           << " lowest, " << scale_changes << " changes\n";
+    output << "  render extent: " << extent.width << "x" << extent.height << " of " << output_extent.width << "x"
+           << output_extent.height << ", targets reallocated " << reallocations << " times\n";
+}
+
+void dynamic_resolution::create_targets(VkExtent2D extent)
+{
+    capacity = extent;
+    images.resize(slot_count);
+    image_memory.resize(slot_count);
+    image_views.resize(slot_count);
+    framebuffers.resize(slot_count);
+
+    for (uint32_t i = 0; i < slot_count; ++i)
+    {
+        VkImageCreateInfo image_create_info{};
+        image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_create_info.imageType = VK_IMAGE_TYPE_2D;
+        image_create_info.format = format;
+        image_create_info.extent = {extent.width, extent.height, 1};
+        image_create_info.mipLevels = 1;
+        image_create_info.arrayLayers = 1;
+        image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_create_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(logical_device, &image_create_info, nullptr, &images[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create scaled render target");
+        }
+
+        image_memory[i] = memory->allocate_image(images[i], image_create_info.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkImageViewCreateInfo image_view_create_info{};
+        image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        image_view_create_info.image = images[i];
+        image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        image_view_create_info.format = format;
+        image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        image_view_create_info.subresourceRange.baseMipLevel = 0;
+        image_view_create_info.subresourceRange.levelCount = 1;
+        image_view_create_info.subresourceRange.baseArrayLayer = 0;
+        image_view_create_info.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(logical_device, &image_view_create_info, nullptr, &image_views[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create scaled render target view");
+        }
+
+        VkFramebufferCreateInfo framebuffer_create_info{};
+        framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_create_info.renderPass = render_pass;
+        framebuffer_create_info.attachmentCount = 1;
+        framebuffer_create_info.pAttachments = &image_views[i];
+        framebuffer_create_info.width = extent.width;
+        framebuffer_create_info.height = extent.height;
+        framebuffer_create_info.layers = 1;
+
+        if (vkCreateFramebuffer(logical_device, &framebuffer_create_info, nullptr, &framebuffers[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create scaled render target framebuffer");
+        }
+    }
+}
+
+void dynamic_resolution::destroy_targets()
+{
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        vkDestroyFramebuffer(logical_device, framebuffers[i], nullptr);
+        vkDestroyImageView(logical_device, image_views[i], nullptr);
+        vkDestroyImage(logical_device, images[i], nullptr);
+        memory->free(image_memory[i]);
+    }
+
+    images.clear();
+    image_memory.clear();
+    image_views.clear();
+    framebuffers.clear();
+    capacity = {};
+}
@@ -0,0 +1,99 @@
+#ifndef _DYNAMIC_RESOLUTION_HPP_
+#define _DYNAMIC_RESOLUTION_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+#include "memory_allocator.hpp"
+#include "renderer.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Renders the scene below the swapchain resolution when frames run over a target frame time.
+// Each frame slot owns an offscreen target as large as the swapchain, of which only the top
+// left render_extent is drawn and then blitted up to the swapchain image, so a change of scale
+// never recreates an image or framebuffer.
+//
+// The controller averages the frame times measured at the current scale, skipping the frames
+// that were already in flight when it changed, and keeps them between 85% of the target and
+// the target. Cost follows the pixel count, the square of the scale, so the scale moves by the
+// square root of the time ratio, dropping quickly when over the target and rising in small steps.
+class dynamic_resolution
+{
+public:
+    // render_pass must be compatible with a single color attachment of format, left in
+    // TRANSFER_SRC_OPTIMAL
+    void create(const device_context& device, memory_allocator& allocator, VkRenderPass render_pass, VkFormat format,
+        VkExtent2D output_extent, uint32_t slot_count, double target_milliseconds, float min_scale);
+    void destroy();
+
+    // Targets only grow, when the new output does not fit them they are reallocated and no slot
+    // may still be in use
+    bool needs_reallocation(VkExtent2D output_extent) const;
+    void resize(VkExtent2D output_extent);
+
+    // Feeds the measured time of one frame to the controller
+    void record(double frame_milliseconds);
+
+    float scale() const;
+    double target() const;
+
+    // Fraction of measured frames at or below the target
+    double hit_rate() const;
+
+    // Region of the slot's target the frame renders into
+    VkExtent2D render_extent() const;
+    VkFramebuffer framebuffer(uint32_t slot) const;
+
+    // Upscale of the slot's rendered region into a swapchain image of the output extent
+    frame_blit blit(uint32_t slot, VkImage destination) const;
+
+    void report(std::ostream& output, const std::string& source) const;
+
+private:
+    static constexpr double smoothing = 0.1;
+    static constexpr uint32_t settle_frames = 8;
+    static constexpr double headroom = 0.85;
+    static constexpr float max_step_down = 0.75f;
+    static constexpr float max_step_up = 1.05f;
+
+    void create_targets(VkExtent2D extent);
+    void destroy_targets();
+
+    VkDevice logical_device = VK_NULL_HANDLE;
+    memory_allocator* memory = nullptr;
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkFilter filter = VK_FILTER_LINEAR;
+    uint32_t slot_count = 0;
+
+    // Per slot
+    std::vector<VkImage> images;
+    std::vector<memory_allocation> image_memory;
+    std::vector<VkImageView> image_views;
+    std::vector<VkFramebuffer> framebuffers;
+
+    VkExtent2D capacity{};
+    VkExtent2D output_extent{};
+
+    // Controller
+    double target_milliseconds = 0.0;
+    float min_scale = 0.5f;
+    float current_scale = 1.0f;
+    double smoothed_milliseconds = 0.0;
+    uint32_t frames_since_change = 0;
+
+    // Statistics
+    uint64_t measured_frames = 0;
+    uint64_t hit_frames = 0;
+    uint64_t scale_changes = 0;
+    uint64_t reallocations = 0;
+    double scale_total = 0.0;
+    float lowest_scale = 1.0f;
+};
+
+#endif
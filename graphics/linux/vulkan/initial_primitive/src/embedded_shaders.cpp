@@ -0,0 +1,68 @@
+#include "embedded_shaders.hpp"
+
+// The .spv.inc files are glslc -mfmt=num output, comma separated SPIR-V words
+alignas(4) static constexpr uint32_t vertex_shader_code[] = {
+#include "vert.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t fragment_shader_code[] = {
+#include "frag.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t textured_shader_code[] = {
+#include "textured.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t cull_shader_code[] = {
+#include "cull.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t post_vertex_shader_code[] = {
+#include "post_vert.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t post_shader_code[] = {
+#include "post.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t post_sampled_shader_code[] = {
+#include "post_sampled.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t saxpy_shader_code[] = {
+#include "saxpy.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t reduce_shader_code[] = {
+#include "reduce.spv.inc"
+};
+
+alignas(4) static constexpr uint32_t scan_shader_code[] = {
+#include "scan.spv.inc"
+};
+
+static const embedded_shader embedded_shaders[] = {
+    {"vert.spv", vertex_shader_code, sizeof(vertex_shader_code)},
+    {"frag.spv", fragment_shader_code, sizeof(fragment_shader_code)},
+    {"textured.spv", textured_shader_code, sizeof(textured_shader_code)},
+    {"cull.spv", cull_shader_code, sizeof(cull_shader_code)},
+    {"post_vert.spv", post_vertex_shader_code, sizeof(post_vertex_shader_code)},
+    {"post.spv", post_shader_code, sizeof(post_shader_code)},
+    {"post_sampled.spv", post_sampled_shader_code, sizeof(post_sampled_shader_code)},
+    {"saxpy.spv", saxpy_shader_code, sizeof(saxpy_shader_code)},
+    {"reduce.spv", reduce_shader_code, sizeof(reduce_shader_code)},
+    {"scan.spv", scan_shader_code, sizeof(scan_shader_code)}
+};
+
+const embedded_shader* find_embedded_shader(const std::string& name)
+{
+    for (const embedded_shader& shader : embedded_shaders)
+    {
+        if (name == shader.name)
+        {
+            return &shader;
+        }
+    }
+
+    return nullptr;
+}
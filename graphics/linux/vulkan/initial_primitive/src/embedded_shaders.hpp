@@ -0,0 +1,22 @@
+#ifndef _EMBEDDED_SHADERS_HPP_
+#define _EMBEDDED_SHADERS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SPIR-V compiled by glslc at build time and linked into the executable, so startup needs no
+// file I/O and the code is already uint32_t aligned for VkShaderModuleCreateInfo
+struct embedded_shader
+{
+    const char* name;
+    const uint32_t* code;
+
+    // In bytes, as VkShaderModuleCreateInfo::codeSize expects
+    size_t size;
+};
+
+// Looks a shader up by the file name glslc also writes it to, such as "vert.spv"
+const embedded_shader* find_embedded_shader(const std::string& name);
+
+#endif
@@ -0,0 +1,75 @@
+#include "frame_statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+frame_statistics::frame_statistics(size_t window) : window(window)
+{
+}
+
+void frame_statistics::record(double milliseconds)
+{
+    if (window != 0 && samples.size() == window)
+    {
+        samples[next] = milliseconds;
+        next = (next + 1) % window;
+        return;
+    }
+
+    samples.push_back(milliseconds);
+}
+
+size_t frame_statistics::count() const
+{
+    return samples.size();
+}
+
+double frame_statistics::total() const
+{
+    return std::accumulate(samples.begin(), samples.end(), 0.0);
+}
+
+double frame_statistics::min() const
+{
+    return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+}
+
+double frame_statistics::average() const
+{
+    return samples.empty() ? 0.0 : total() / samples.size();
+}
+
+double frame_statistics::percentile(double fraction) const
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+
+    std::vector<double> sorted(samples);
+    const size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    const size_t index = std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+
+    return sorted[index];
+}
+
+double frame_statistics::max() const
+{
+    return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+}
+
+void frame_statistics::report(std::ostream& output, const std::string& label) const
+{
+    output << label << ": " << count() << " samples, "
+           << "min " << min() << " ms, "
+           << "avg " << average() << " ms, "
+           << "p99 " << percentile(0.99) << " ms, "
+           << "max " << max() << " ms\n";
+}
+
+double milliseconds_between(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
@@ -0,0 +1,37 @@
+#ifndef _FRAME_STATISTICS_HPP_
+#define _FRAME_STATISTICS_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Collects per-frame durations, in milliseconds, for an end of run report. A non-zero window
+// keeps only the most recent samples, giving rolling statistics.
+class frame_statistics
+{
+public:
+    explicit frame_statistics(size_t window = 0);
+
+    void record(double milliseconds);
+
+    size_t count() const;
+    double total() const;
+    double min() const;
+    double average() const;
+    double percentile(double fraction) const;
+    double max() const;
+
+    void report(std::ostream& output, const std::string& label) const;
+
+private:
+    size_t window;
+    size_t next = 0;
+    std::vector<double> samples;
+};
+
+// Time from start to end in milliseconds, the unit every report in the sample uses
+double milliseconds_between(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+#endif
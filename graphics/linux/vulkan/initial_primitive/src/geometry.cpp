@@ -0,0 +1,210 @@
+#include "geometry.hpp"
+
+#include "sample_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+gpu_buffer create_buffer(memory_allocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags properties)
+{
+    gpu_buffer created;
+    created.size = size;
+
+    VkBufferCreateInfo buffer_create_info{};
+    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.size = size;
+    buffer_create_info.usage = usage;
+    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(allocator.device(), &buffer_create_info, nullptr, &created.buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create buffer");
+    }
+
+    created.allocation = allocator.allocate_buffer(created.buffer, properties);
+
+    return created;
+}
+
+void destroy_buffer(memory_allocator& allocator, gpu_buffer& buffer)
+{
+    vkDestroyBuffer(allocator.device(), buffer.buffer, nullptr);
+    allocator.free(buffer.allocation);
+    buffer = gpu_buffer{};
+}
+
+void layout_instances(instance_attributes* instances, uint32_t instance_count, float world_scale, float phase)
+{
+    // Square grid in normalized device coordinates, each triangle shrunk to fit its cell
+    const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(instance_count))));
+    const float cell = 2.0f * world_scale / columns;
+
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        const uint32_t column = i % columns;
+        const uint32_t row = i / columns;
+
+        instances[i].offset[0] = -world_scale + cell * (column + 0.5f);
+        instances[i].offset[1] = -world_scale + cell * (row + 0.5f);
+        instances[i].color[0] = 1.0f;
+        instances[i].color[1] = std::fmod(static_cast<float>(column) / columns + phase, 1.0f);
+        instances[i].color[2] = std::fmod(static_cast<float>(row) / columns + phase, 1.0f);
+        instances[i].scale = std::min(1.0f, cell * 0.9f);
+    }
+}
+
+scene_geometry create_scene_geometry(memory_allocator& allocator, VkQueue queue, VkCommandPool command_pool,
+    uint32_t instance_count, bool draw_per_object, float world_scale)
+{
+    SAMPLE_TRACE_SCOPE("create_scene_geometry");
+
+    const std::vector<vertex> vertices = {
+        {{0.0f, -0.5f}},
+        {{0.5f, 0.5f}},
+        {{-0.5f, 0.5f}}
+    };
+
+    const std::vector<uint16_t> indices = {0, 1, 2};
+
+    std::vector<instance_attributes> instances(instance_count);
+    layout_instances(instances.data(), instance_count, world_scale, 0.0f);
+
+    scene_geometry geometry;
+    geometry.index_count = static_cast<uint32_t>(indices.size());
+    geometry.instance_count = instance_count;
+    geometry.draw_per_object = draw_per_object;
+    geometry.world_scale = world_scale;
+
+    const VkDeviceSize sizes[] = {
+        sizeof(vertex) * vertices.size(),
+        sizeof(uint16_t) * indices.size(),
+        sizeof(instance_attributes) * instances.size()
+    };
+    const void* sources[] = {vertices.data(), indices.data(), instances.data()};
+    const VkBufferUsageFlags usages[] = {
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+    };
+    gpu_buffer* destinations[] = {&geometry.vertices, &geometry.indices, &geometry.instances};
+
+    // Transient staging buffers share one persistently mapped arena, with slack for alignment
+    VkDevice logical_device = allocator.device();
+    linear_arena staging_arena = allocator.create_arena(sizes[0] + sizes[1] + sizes[2] + 3 * 256, ~0u,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    std::vector<VkBuffer> staging_buffers(3);
+
+    VkCommandBuffer command_buffer;
+    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocation_info.commandPool = command_pool;
+    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocation_info.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, &command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate upload command buffer");
+    }
+
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to begin recording upload command buffer");
+    }
+
+    for (size_t i = 0; i < staging_buffers.size(); ++i)
+    {
+        VkBufferCreateInfo buffer_create_info{};
+        buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_create_info.size = sizes[i];
+        buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &staging_buffers[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create staging buffer");
+        }
+
+        VkMemoryRequirements memory_requirements;
+        vkGetBufferMemoryRequirements(logical_device, staging_buffers[i], &memory_requirements);
+
+        const memory_allocation staging = staging_arena.allocate(memory_requirements);
+        vkBindBufferMemory(logical_device, staging_buffers[i], staging.memory, staging.offset);
+        std::memcpy(staging.mapped, sources[i], static_cast<size_t>(sizes[i]));
+
+        *destinations[i] = create_buffer(allocator, sizes[i], usages[i] | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkBufferCopy copy_region{};
+        copy_region.size = sizes[i];
+        vkCmdCopyBuffer(command_buffer, staging_buffers[i], destinations[i]->buffer, 1, &copy_region);
+    }
+
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to record upload command buffer");
+    }
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+
+    if (vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to submit buffer upload");
+    }
+
+    vkQueueWaitIdle(queue);
+    vkFreeCommandBuffers(logical_device, command_pool, 1, &command_buffer);
+
+    for (VkBuffer staging_buffer : staging_buffers)
+    {
+        vkDestroyBuffer(logical_device, staging_buffer, nullptr);
+    }
+
+    allocator.destroy_arena(staging_arena);
+
+    return geometry;
+}
+
+void destroy_scene_geometry(memory_allocator& allocator, scene_geometry& geometry)
+{
+    destroy_buffer(allocator, geometry.instances);
+    destroy_buffer(allocator, geometry.indices);
+    destroy_buffer(allocator, geometry.vertices);
+}
+
+std::vector<VkVertexInputBindingDescription> vertex_input_bindings()
+{
+    std::vector<VkVertexInputBindingDescription> bindings(2);
+
+    bindings[0].binding = 0;
+    bindings[0].stride = sizeof(vertex);
+    bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    bindings[1].binding = 1;
+    bindings[1].stride = sizeof(instance_attributes);
+    bindings[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    return bindings;
+}
+
+std::vector<VkVertexInputAttributeDescription> vertex_input_attributes()
+{
+    std::vector<VkVertexInputAttributeDescription> attributes(4);
+
+    attributes[0] = {0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(vertex, position)};
+    attributes[1] = {1, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(instance_attributes, offset)};
+    attributes[2] = {2, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(instance_attributes, color)};
+    attributes[3] = {3, 1, VK_FORMAT_R32_SFLOAT, offsetof(instance_attributes, scale)};
+
+    return attributes;
+}
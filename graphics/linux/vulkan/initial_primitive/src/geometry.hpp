@@ -0,0 +1,97 @@
+#ifndef _GEOMETRY_HPP_
+#define _GEOMETRY_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "memory_allocator.hpp"
+
+#include <vector>
+
+// Vertex, index and per-instance buffers drawn by record_frame
+
+struct vertex
+{
+    float position[2];
+};
+
+struct instance_attributes
+{
+    float offset[2];
+    float color[3];
+    float scale;
+};
+
+// Per frame data read by shader.vert from the dynamic uniform buffer at set 0
+struct frame_uniforms
+{
+    // Angle every instance is turned by around its own center, in radians
+    float rotation = 0.0f;
+    float padding[3] = {};
+};
+
+// Per draw data pushed to the fragment shaders, small enough for the 128 bytes every device supports
+struct draw_constants
+{
+    float tint[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+};
+
+struct gpu_buffer
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    memory_allocation allocation;
+    VkDeviceSize size = 0;
+};
+
+struct scene_geometry
+{
+    gpu_buffer vertices;
+    gpu_buffer indices;
+    gpu_buffer instances;
+    uint32_t index_count = 0;
+    uint32_t instance_count = 0;
+
+    // Issues one draw per instance instead of a single instanced draw
+    bool draw_per_object = false;
+
+    // Half extent of the instance grid, above one part of the grid lies outside the framebuffer
+    float world_scale = 1.0f;
+
+    // Set for GPU culled frames, draws are then sourced from the indirect command buffer and, when
+    // the count function is available, the draw count buffer
+    VkBuffer indirect_commands = VK_NULL_HANDLE;
+    VkBuffer indirect_count = VK_NULL_HANDLE;
+    PFN_vkCmdDrawIndexedIndirectCountKHR draw_indexed_indirect_count = nullptr;
+
+    // Layout the graphics pipeline was created with, the frame uniforms are bound at set 0 with
+    // frame_offset into the uniform ring and the texture, for the textured pipeline, at set 1
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    VkDescriptorSet frame_set = VK_NULL_HANDLE;
+    uint32_t frame_offset = 0;
+    VkDescriptorSet texture_set = VK_NULL_HANDLE;
+
+    // Pushed once per record_draws call
+    draw_constants constants;
+};
+
+gpu_buffer create_buffer(memory_allocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags properties);
+
+void destroy_buffer(memory_allocator& allocator, gpu_buffer& buffer);
+
+// Lays the instances out on a grid covering world_scale times the framebuffer, phase shifts the colors
+void layout_instances(instance_attributes* instances, uint32_t instance_count, float world_scale, float phase);
+
+// A single triangle instanced over a grid, one instance on a world scale of one reproduces
+// the original red triangle. The buffers are filled through a staging arena with one submission
+// that is waited on before returning.
+scene_geometry create_scene_geometry(memory_allocator& allocator, VkQueue queue, VkCommandPool command_pool,
+    uint32_t instance_count, bool draw_per_object, float world_scale);
+
+void destroy_scene_geometry(memory_allocator& allocator, scene_geometry& geometry);
+
+// Binding 0 advances per vertex, binding 1 per instance
+std::vector<VkVertexInputBindingDescription> vertex_input_bindings();
+std::vector<VkVertexInputAttributeDescription> vertex_input_attributes();
+
+#endif
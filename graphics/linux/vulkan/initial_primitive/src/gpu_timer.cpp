@@ -0,0 +1,175 @@
+#include "gpu_timer.hpp"
+
+#include <stdexcept>
+
+void gpu_timer::create(VkPhysicalDevice physical_device, VkDevice device, uint32_t queue_family_index,
+    uint32_t slot_count, const std::vector<std::string>& pass_names, const std::string& csv_path)
+{
+    logical_device = device;
+    names = pass_names;
+    pass_count = static_cast<uint32_t>(pass_names.size());
+    statistics.assign(pass_count, frame_statistics(rolling_window));
+    latest_milliseconds.assign(pass_count, 0.0);
+    pending.assign(slot_count, false);
+    slot_frame_numbers.assign(slot_count, 0);
+
+    // Timestamp support and resolution
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    timestamp_period = properties.limits.timestampPeriod;
+
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+
+    const uint32_t valid_bits = queue_families.at(queue_family_index).timestampValidBits;
+
+    if (valid_bits == 0)
+    {
+        return;
+    }
+
+    timestamp_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+    // Two queries per pass per slot
+    VkQueryPoolCreateInfo query_pool_create_info{};
+    query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_pool_create_info.queryCount = slot_count * pass_count * 2;
+
+    if (vkCreateQueryPool(logical_device, &query_pool_create_info, nullptr, &query_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create timestamp query pool");
+    }
+
+    if (!csv_path.empty())
+    {
+        csv.open(csv_path);
+
+        if (!csv.is_open())
+        {
+            throw std::runtime_error("Unable to open GPU timing CSV: " + csv_path);
+        }
+
+        csv << "frame,pass,milliseconds\n";
+    }
+}
+
+void gpu_timer::destroy()
+{
+    if (query_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(logical_device, query_pool, nullptr);
+        query_pool = VK_NULL_HANDLE;
+    }
+
+    csv.close();
+}
+
+bool gpu_timer::supported() const
+{
+    return query_pool != VK_NULL_HANDLE;
+}
+
+bool gpu_timer::collect(uint32_t slot)
+{
+    if (!supported() || !pending.at(slot))
+    {
+        return false;
+    }
+
+    // Value and availability for each query
+    std::vector<uint64_t> results(pass_count * 2 * 2);
+
+    const VkResult result = vkGetQueryPoolResults(logical_device, query_pool, slot * pass_count * 2, pass_count * 2,
+        results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    pending[slot] = false;
+
+    if (result != VK_SUCCESS && result != VK_NOT_READY)
+    {
+        return false;
+    }
+
+    bool collected = false;
+
+    for (uint32_t pass = 0; pass < pass_count; ++pass)
+    {
+        const uint64_t* begin = &results[pass * 4];
+        const uint64_t* end = &results[pass * 4 + 2];
+
+        if (begin[1] == 0 || end[1] == 0)
+        {
+            continue;
+        }
+
+        const double milliseconds = ((end[0] - begin[0]) & timestamp_mask) * timestamp_period / 1e6;
+        statistics[pass].record(milliseconds);
+        latest_milliseconds[pass] = milliseconds;
+        collected = true;
+
+        if (csv.is_open())
+        {
+            csv << slot_frame_numbers[slot] << "," << names[pass] << "," << milliseconds << "\n";
+        }
+    }
+
+    return collected;
+}
+
+double gpu_timer::latest(uint32_t pass) const
+{
+    return pass < latest_milliseconds.size() ? latest_milliseconds[pass] : 0.0;
+}
+
+void gpu_timer::submitted(uint32_t slot, uint64_t frame_number)
+{
+    if (supported())
+    {
+        pending.at(slot) = true;
+        slot_frame_numbers.at(slot) = frame_number;
+    }
+}
+
+void gpu_timer::reset(VkCommandBuffer command_buffer, uint32_t slot)
+{
+    if (!supported())
+    {
+        return;
+    }
+
+    vkCmdResetQueryPool(command_buffer, query_pool, slot * pass_count * 2, pass_count * 2);
+}
+
+void gpu_timer::begin_pass(VkCommandBuffer command_buffer, uint32_t slot, uint32_t pass)
+{
+    if (supported())
+    {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, (slot * pass_count + pass) * 2);
+    }
+}
+
+void gpu_timer::end_pass(VkCommandBuffer command_buffer, uint32_t slot, uint32_t pass)
+{
+    if (supported())
+    {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, (slot * pass_count + pass) * 2 + 1);
+    }
+}
+
+void gpu_timer::report(std::ostream& output) const
+{
+    if (!supported())
+    {
+        output << "GPU timestamps unsupported on the graphics queue\n";
+        return;
+    }
+
+    for (uint32_t pass = 0; pass < pass_count; ++pass)
+    {
+        statistics[pass].report(output, "GPU " + names[pass] + " (last " + std::to_string(rolling_window) + " frames)");
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef _GPU_TIMER_HPP_
+#define _GPU_TIMER_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "frame_statistics.hpp"
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Timestamp queries written around named passes. Each slot owns its own range of queries and
+// is only read back once the fence of the submission that used it has signalled, so results
+// are collected without ever waiting on the GPU.
+class gpu_timer
+{
+public:
+    void create(VkPhysicalDevice physical_device, VkDevice logical_device, uint32_t queue_family_index,
+        uint32_t slot_count, const std::vector<std::string>& pass_names, const std::string& csv_path);
+    void destroy();
+
+    // False when the queue family does not support timestamps, all other calls are then no-ops
+    bool supported() const;
+
+    // Host side, reads the slot's previous results into the statistics, returning true when
+    // there were results to read
+    bool collect(uint32_t slot);
+
+    // Most recently collected time of the pass in milliseconds, zero before the first
+    double latest(uint32_t pass) const;
+
+    // Host side, marks the slot's queries as pending once its command buffer is submitted, and
+    // remembers the frame that wrote them for the CSV
+    void submitted(uint32_t slot, uint64_t frame_number);
+
+    // Recorded outside of any render pass, before the slot's first timestamp
+    void reset(VkCommandBuffer command_buffer, uint32_t slot);
+
+    void begin_pass(VkCommandBuffer command_buffer, uint32_t slot, uint32_t pass);
+    void end_pass(VkCommandBuffer command_buffer, uint32_t slot, uint32_t pass);
+
+    void report(std::ostream& output) const;
+
+private:
+    static constexpr size_t rolling_window = 1000;
+
+    VkDevice logical_device = VK_NULL_HANDLE;
+    VkQueryPool query_pool = VK_NULL_HANDLE;
+    uint32_t pass_count = 0;
+    double timestamp_period = 1.0;
+    uint64_t timestamp_mask = 0;
+    std::vector<std::string> names;
+    std::vector<frame_statistics> statistics;
+    std::vector<double> latest_milliseconds;
+    std::vector<bool> pending;
+    std::vector<uint64_t> slot_frame_numbers;
+    std::ofstream csv;
+};
+
+#endif
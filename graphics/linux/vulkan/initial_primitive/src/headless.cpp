@@ -0,0 +1,713 @@
+#include "headless.hpp"
+
+#include "async_uploader.hpp"
+#include "culling.hpp"
+#include "frame_statistics.hpp"
+#include "parallel_recorder.hpp"
+#include "pipeline_builder.hpp"
+#include "pipeline_cache.hpp"
+#include "recorded_commands.hpp"
+#include "render_graph.hpp"
+#include "renderer.hpp"
+#include "sample_trace.h"
+#include "texture_streamer.hpp"
+#include "uniform_ring.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Frame count used when neither a frame nor a duration limit is requested
+static const uint64_t default_headless_frames = 1000;
+
+static void write_ppm(const std::string& path, const uint8_t* rgba, VkExtent2D extent)
+{
+    std::ofstream output(path, std::ios::binary);
+
+    if (!output.is_open())
+    {
+        throw std::runtime_error("Unable to open PPM output: " + path);
+    }
+
+    output << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+
+    for (size_t pixel = 0; pixel < static_cast<size_t>(extent.width) * extent.height; ++pixel)
+    {
+        output.write(reinterpret_cast<const char*>(rgba + pixel * 4), 3);
+    }
+}
+
+headless_result run_headless(const options& settings, const device_context& device)
+{
+    VkDevice logical_device = device.logical_device;
+    const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    const VkExtent2D extent = {settings.width, settings.height};
+    const uint32_t frames_in_flight = settings.frames_in_flight;
+
+    // Buffers and images are sub-allocated from shared device memory blocks
+    memory_allocator allocator;
+    allocator.create(device.physical_device, logical_device);
+
+    // Offscreen render targets, one per frame in flight so concurrent frames never share an image
+    std::vector<VkImage> images(frames_in_flight);
+    std::vector<memory_allocation> image_memory(frames_in_flight);
+    std::vector<VkImageView> image_views(frames_in_flight);
+
+    for (uint32_t i = 0; i < frames_in_flight; ++i)
+    {
+        VkImageCreateInfo image_create_info{};
+        image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_create_info.imageType = VK_IMAGE_TYPE_2D;
+        image_create_info.format = format;
+        image_create_info.extent = {extent.width, extent.height, 1};
+        image_create_info.mipLevels = 1;
+        image_create_info.arrayLayers = 1;
+        image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_create_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(logical_device, &image_create_info, nullptr, &images[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create offscreen image");
+        }
+
+        image_memory[i] = allocator.allocate_image(images[i], image_create_info.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkImageViewCreateInfo image_view_create_info{};
+        image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        image_view_create_info.image = images[i];
+        image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        image_view_create_info.format = format;
+        image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        image_view_create_info.subresourceRange.baseMipLevel = 0;
+        image_view_create_info.subresourceRange.levelCount = 1;
+        image_view_create_info.subresourceRange.baseArrayLayer = 0;
+        image_view_create_info.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(logical_device, &image_view_create_info, nullptr, &image_views[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create offscreen image view");
+        }
+    }
+
+    // Render graph, the scene is drawn into the offscreen image or through the post passes into it,
+    // which is left ready to be copied out
+    render_graph graph;
+    const resource_id offscreen_target = graph.import_image("offscreen", format, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    resource_id previous_output = settings.post_passes > 0 ? graph.create_image("scene", format) : offscreen_target;
+    const uint32_t scene_pass = graph.add_pass("scene", {previous_output});
+
+    std::vector<VkPipeline> post_pipelines(settings.post_passes, VK_NULL_HANDLE);
+    std::vector<VkPipelineLayout> post_pipeline_layouts(settings.post_passes, VK_NULL_HANDLE);
+
+    for (uint32_t i = 0; i < settings.post_passes; ++i)
+    {
+        const resource_id output = i + 1 < settings.post_passes ? graph.create_image("post " + std::to_string(i), format)
+                                                                 : offscreen_target;
+        const std::vector<resource_id> reads = {previous_output};
+        const uint32_t post_pass = scene_pass + 1 + i;
+
+        graph.add_pass("post " + std::to_string(i), {output}, settings.post_sampled ? std::vector<resource_id>() : reads,
+            settings.post_sampled ? reads : std::vector<resource_id>(),
+            [&, i, post_pass](VkCommandBuffer command_buffer, uint32_t frame) {
+                const VkDescriptorSet input_set = graph.descriptor_set(frame, post_pass);
+
+                vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_pipelines[i]);
+                set_viewport(command_buffer, extent);
+                vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_pipeline_layouts[i], 0, 1,
+                    &input_set, 0, nullptr);
+                vkCmdDraw(command_buffer, 3, 1, 0, 0);
+            });
+
+        previous_output = output;
+    }
+
+    graph.compile(device.physical_device, allocator, extent, frames_in_flight);
+    VkRenderPass render_pass = graph.render_pass(scene_pass);
+
+    // Shared pipeline
+    VkShaderModule vertex_shader_module = load_shader_module(logical_device, "vert.spv", settings.shader_directory);
+    const bool textured = !settings.texture_path.empty();
+    VkDescriptorSetLayout uniform_set_layout = create_uniform_set_layout(logical_device);
+    VkDescriptorSetLayout texture_set_layout = textured ? create_texture_set_layout(logical_device) : VK_NULL_HANDLE;
+    VkShaderModule fragment_shader_module = load_shader_module(logical_device, textured ? "textured.spv" : "frag.spv",
+        settings.shader_directory);
+    VkPipelineLayout pipeline_layout = create_pipeline_layout(logical_device, uniform_set_layout, texture_set_layout);
+
+    size_t pipeline_cache_bytes = 0;
+    VkPipelineCache pipeline_cache = settings.pipeline_cache_path.empty()
+        ? VK_NULL_HANDLE
+        : load_pipeline_cache(device.physical_device, logical_device, settings.pipeline_cache_path, pipeline_cache_bytes);
+
+    pipeline_specialization specialization;
+    specialization.flat_color = settings.flat_color;
+    std::copy(settings.color, settings.color + 3, specialization.color);
+
+    const auto pipeline_start = std::chrono::steady_clock::now();
+    VkPipeline pipeline = create_graphics_pipeline(logical_device, pipeline_cache, render_pass, pipeline_layout,
+        vertex_shader_module, fragment_shader_module, specialization);
+
+    std::cout << "Pipeline creation: "
+              << milliseconds_between(pipeline_start, std::chrono::steady_clock::now()) << " ms ("
+              << (pipeline_cache_bytes > 0 ? "warm" : "cold") << " cache, " << pipeline_cache_bytes << " bytes loaded)\n";
+
+    // Post-processing pipelines, each built against the subpass the graph placed its pass in
+    VkShaderModule post_vertex_shader_module = VK_NULL_HANDLE;
+    VkShaderModule post_fragment_shader_module = VK_NULL_HANDLE;
+
+    if (settings.post_passes > 0)
+    {
+        post_vertex_shader_module = load_shader_module(logical_device, "post_vert.spv", settings.shader_directory);
+        post_fragment_shader_module = load_shader_module(logical_device,
+            settings.post_sampled ? "post_sampled.spv" : "post.spv", settings.shader_directory);
+    }
+
+    for (uint32_t i = 0; i < settings.post_passes; ++i)
+    {
+        const uint32_t post_pass = scene_pass + 1 + i;
+        post_pipeline_layouts[i] = create_post_pipeline_layout(logical_device, graph.set_layout(post_pass));
+        post_pipelines[i] = create_post_pipeline(logical_device, pipeline_cache, graph.render_pass(post_pass),
+            graph.subpass(post_pass), post_pipeline_layouts[i], post_vertex_shader_module, post_fragment_shader_module);
+    }
+
+    // Framebuffers, the scene's is also the one the benchmarks render into
+    std::vector<VkFramebuffer> framebuffers(frames_in_flight);
+
+    for (uint32_t i = 0; i < frames_in_flight; ++i)
+    {
+        graph.create_framebuffers(i, {image_views[i]});
+        framebuffers[i] = graph.framebuffer(i, scene_pass);
+    }
+
+    // Command pool and buffers
+    VkCommandPool command_pool;
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    command_pool_create_info.queueFamilyIndex = device.graphics_queue_index;
+
+    if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create command pool");
+    }
+
+    // Vertex, index and instance buffers, uploaded once through a staging buffer
+    scene_geometry geometry = create_scene_geometry(allocator, device.graphics_queue, command_pool,
+        settings.instances, settings.draw_per_object, settings.world_scale);
+    std::cout << "Instances: " << geometry.instance_count << ", draw calls per frame: "
+        << (geometry.draw_per_object ? geometry.instance_count : 1) << "\n";
+
+    // Frame uniforms, one ring slot per frame in flight bound through a single descriptor set
+    uniform_ring uniforms;
+    uniforms.create(device, allocator, uniform_set_layout, frames_in_flight, 1, sizeof(frame_uniforms));
+    geometry.pipeline_layout = pipeline_layout;
+    geometry.frame_set = uniforms.descriptor_set();
+    std::copy(settings.tint, settings.tint + 3, geometry.constants.tint);
+
+    std::vector<VkCommandBuffer> command_buffers(frames_in_flight);
+    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocation_info.commandPool = command_pool;
+    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocation_info.commandBufferCount = frames_in_flight;
+
+    if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, command_buffers.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate command buffers");
+    }
+
+    // Pre-recorded command buffers, one per offscreen framebuffer
+    recorded_commands prerecorded_frames;
+
+    if (settings.prerecorded)
+    {
+        prerecorded_frames.create(logical_device, command_pool, framebuffers.size());
+    }
+
+    if (settings.record_benchmark)
+    {
+        benchmark_recording(logical_device, device.graphics_queue_index, render_pass, framebuffers[0], extent, pipeline,
+            geometry, std::max(1u, std::thread::hardware_concurrency()), std::cout);
+    }
+
+    if (settings.uniform_benchmark_draws > 0)
+    {
+        benchmark_uniform_updates(device, allocator, render_pass, framebuffers[0], extent, pipeline, pipeline_layout,
+            uniform_set_layout, geometry, settings.uniform_benchmark_draws, std::cout);
+    }
+
+    if (settings.pipeline_benchmark_permutations > 0)
+    {
+        benchmark_pipeline_compilation(logical_device, render_pass, pipeline_layout, vertex_shader_module,
+            fragment_shader_module, settings.pipeline_benchmark_permutations,
+            std::max(1u, std::thread::hardware_concurrency()), std::cout);
+    }
+
+    // Secondary command buffer recording, one command pool per worker per frame in flight
+    parallel_recorder recorder;
+
+    if (settings.record_threads > 0)
+    {
+        recorder.create(logical_device, device.graphics_queue_index, settings.record_threads, frames_in_flight);
+    }
+
+    // GPU timestamps, one query slot per command buffer that may be in flight
+    gpu_timer timer;
+
+    if (settings.gpu_timing)
+    {
+        timer.create(device.physical_device, logical_device, device.graphics_queue_index,
+            frames_in_flight, timed_pass_names, settings.gpu_timing_csv);
+    }
+
+    gpu_timer* frame_timer = settings.gpu_timing ? &timer : nullptr;
+
+    // Instance buffers rewritten every frame through the transfer queue, one per frame slot
+    async_uploader uploader;
+    std::vector<scene_geometry> streamed_geometry;
+
+    if (settings.stream_instances)
+    {
+        uploader.create(device, allocator, frames_in_flight, geometry.instances.size);
+
+        streamed_geometry.assign(frames_in_flight, geometry);
+
+        for (scene_geometry& streamed : streamed_geometry)
+        {
+            streamed.instances = create_buffer(allocator, geometry.instances.size,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+
+        std::cout << "Streaming instances on " << (uploader.dedicated() ? "a dedicated transfer queue" : "the graphics queue")
+                  << " (family " << device.transfer_queue_index << ")\n";
+    }
+
+    // Texture streamed from a file mapping, a few mip levels per frame
+    texture_streamer textures;
+
+    if (textured)
+    {
+        textures.create(device, allocator, settings.texture_path, texture_set_layout, frames_in_flight, settings.texture_budget_kib * 1024);
+    }
+
+    // Instance culling, each frame slot culls the instance buffer it draws from
+    const cull_mode culling = cull_mode_from_name(settings.cull);
+    instance_culler culler;
+
+    if (culling != cull_mode::none)
+    {
+        std::vector<VkBuffer> cull_sources(frames_in_flight, geometry.instances.buffer);
+
+        for (uint32_t slot = 0; slot < streamed_geometry.size(); ++slot)
+        {
+            cull_sources[slot] = streamed_geometry[slot].instances.buffer;
+        }
+
+        culler.create(device, allocator, pipeline_cache, culling, geometry, cull_sources, settings.shader_directory);
+    }
+
+    // Synchronization, no semaphores are needed without a swapchain
+    std::vector<VkFence> in_flight_fences(frames_in_flight);
+
+    VkFenceCreateInfo fence_create_info{};
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; i < frames_in_flight; ++i)
+    {
+        if (vkCreateFence(logical_device, &fence_create_info, nullptr, &in_flight_fences[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create in-flight fence");
+        }
+    }
+
+    // Render loop
+    const uint64_t frame_limit = settings.frame_limit == 0 && settings.duration_seconds == 0.0
+        ? default_headless_frames
+        : settings.frame_limit;
+
+    frame_statistics frame_times;
+    frame_statistics cpu_times;
+    uint64_t frame_number = 0;
+    uint32_t current_frame = 0;
+    const auto loop_start = std::chrono::steady_clock::now();
+    auto previous_frame_start = loop_start;
+
+    while (true)
+    {
+        SAMPLE_TRACE_SCOPE("frame");
+        const auto frame_start = std::chrono::steady_clock::now();
+        const double elapsed_seconds = std::chrono::duration<double>(frame_start - loop_start).count();
+
+        if ((frame_limit != 0 && frame_number >= frame_limit) ||
+            (settings.duration_seconds != 0.0 && elapsed_seconds >= settings.duration_seconds))
+        {
+            break;
+        }
+
+        if (frame_number > 0)
+        {
+            frame_times.record(milliseconds_between(previous_frame_start, frame_start));
+        }
+
+        previous_frame_start = frame_start;
+
+        VkFence in_flight_fence = in_flight_fences[current_frame];
+        const uint64_t wait_trace_start = sample_trace_begin();
+        vkWaitForFences(logical_device, 1, &in_flight_fence, VK_TRUE, UINT64_MAX);
+        sample_trace_end("wait_frame_fence", wait_trace_start);
+        vkResetFences(logical_device, 1, &in_flight_fence);
+        timer.collect(current_frame);
+        textures.collect(current_frame);
+
+        // Streamed instances are copied before recording so the upload overlaps the CPU work below
+        scene_geometry frame_geometry = settings.stream_instances ? streamed_geometry[current_frame] : geometry;
+
+        // The slot's fence has signalled, so its part of the uniform ring can be rewritten
+        uniforms.reset(current_frame);
+        static_cast<frame_uniforms*>(uniforms.allocate(current_frame, sizeof(frame_uniforms), frame_geometry.frame_offset))
+            ->rotation = static_cast<float>(settings.spin * elapsed_seconds);
+        VkSemaphore upload_semaphore = VK_NULL_HANDLE;
+        VkPipelineStageFlags upload_wait_stage = 0;
+        VkCommandBuffer acquire_command_buffer = VK_NULL_HANDLE;
+
+        if (settings.stream_instances)
+        {
+            layout_instances(static_cast<instance_attributes*>(uploader.staging(current_frame)), geometry.instance_count,
+                geometry.world_scale, frame_number * 0.01f);
+            const bool compute_reads = culling == cull_mode::gpu;
+            uploader.copy(current_frame, 0, frame_geometry.instances.buffer, 0, geometry.instances.size,
+                compute_reads ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                compute_reads ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+            uploader.submit(current_frame, upload_semaphore, upload_wait_stage, acquire_command_buffer);
+        }
+
+        // CPU cost covers recording and submission, not the time spent waiting on the GPU
+        const auto cpu_start = std::chrono::steady_clock::now();
+        VkCommandBuffer command_buffer;
+        VkCommandBuffer cull_command_buffer = VK_NULL_HANDLE;
+        VkCommandBuffer texture_command_buffer = VK_NULL_HANDLE;
+
+        if (culling != cull_mode::none)
+        {
+            frame_geometry = culler.cull(current_frame, frame_geometry, cull_command_buffer);
+        }
+
+        if (textured)
+        {
+            texture_command_buffer = textures.stream(current_frame);
+            frame_geometry.texture_set = textures.descriptor_set();
+
+            // Pre-recorded buffers keep binding the set of the levels resident when they were recorded
+            if (settings.prerecorded && texture_command_buffer != VK_NULL_HANDLE)
+            {
+                prerecorded_frames.invalidate_all();
+            }
+        }
+
+        if (settings.prerecorded)
+        {
+            command_buffer = prerecorded_frames.acquire(current_frame, [&](VkCommandBuffer buffer) {
+                record_frame(buffer, render_pass, framebuffers[current_frame], extent, pipeline, frame_geometry, frame_timer, current_frame,
+                    &graph, current_frame);
+            });
+        }
+        else
+        {
+            command_buffer = command_buffers[current_frame];
+            vkResetCommandBuffer(command_buffer, 0);
+
+            if (settings.record_threads > 0)
+            {
+                const std::vector<VkCommandBuffer>& secondary_command_buffers =
+                    recorder.record(current_frame, render_pass, framebuffers[current_frame], extent, pipeline, frame_geometry);
+                record_frame(command_buffer, render_pass, framebuffers[current_frame], extent, secondary_command_buffers,
+                    frame_timer, current_frame, &graph, current_frame);
+            }
+            else
+            {
+                record_frame(command_buffer, render_pass, framebuffers[current_frame], extent, pipeline, frame_geometry,
+                    frame_timer, current_frame, &graph, current_frame);
+            }
+        }
+
+        // The ownership acquire for streamed instances, texture uploads and the culling pass run ahead
+        // of the frame in the same batch
+        std::vector<VkCommandBuffer> submitted_command_buffers = {command_buffer};
+
+        if (cull_command_buffer != VK_NULL_HANDLE)
+        {
+            submitted_command_buffers.insert(submitted_command_buffers.begin(), cull_command_buffer);
+        }
+
+        if (texture_command_buffer != VK_NULL_HANDLE)
+        {
+            submitted_command_buffers.insert(submitted_command_buffers.begin(), texture_command_buffer);
+        }
+
+        if (acquire_command_buffer != VK_NULL_HANDLE)
+        {
+            submitted_command_buffers.insert(submitted_command_buffers.begin(), acquire_command_buffer);
+        }
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.waitSemaphoreCount = upload_semaphore != VK_NULL_HANDLE ? 1 : 0;
+        submit_info.pWaitSemaphores = &upload_semaphore;
+        submit_info.pWaitDstStageMask = &upload_wait_stage;
+        submit_info.commandBufferCount = static_cast<uint32_t>(submitted_command_buffers.size());
+        submit_info.pCommandBuffers = submitted_command_buffers.data();
+
+        const uint64_t submit_trace_start = sample_trace_begin();
+
+        if (vkQueueSubmit(device.graphics_queue, 1, &submit_info, in_flight_fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to submit draw call to command buffer");
+        }
+
+        sample_trace_end("queue_submit", submit_trace_start);
+        timer.submitted(current_frame, frame_number);
+
+        cpu_times.record(milliseconds_between(cpu_start, std::chrono::steady_clock::now()));
+
+        current_frame = (current_frame + 1) % frames_in_flight;
+        ++frame_number;
+    }
+
+    vkWaitForFences(logical_device, frames_in_flight, in_flight_fences.data(), VK_TRUE, UINT64_MAX);
+    const double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loop_start).count();
+
+    // Throughput report
+    std::cout << "Headless " << extent.width << "x" << extent.height << ", frames in flight: " << frames_in_flight << "\n";
+    std::cout << "Rendered " << frame_number << " frames in " << elapsed_seconds << " s ("
+              << (elapsed_seconds > 0.0 ? frame_number / elapsed_seconds : 0.0) << " frames/s)\n";
+    frame_times.report(std::cout, "Frame time");
+    cpu_times.report(std::cout, "CPU time");
+
+    if (settings.gpu_timing)
+    {
+        for (uint32_t slot = 0; slot < frames_in_flight; ++slot)
+        {
+            timer.collect(slot);
+        }
+
+        timer.report(std::cout);
+    }
+
+    if (settings.prerecorded)
+    {
+        std::cout << "Pre-recorded command buffers: " << prerecorded_frames.reused_count() << " frames reused, "
+                  << prerecorded_frames.recorded_count() << " re-recorded\n";
+    }
+
+    if (textured)
+    {
+        for (uint32_t slot = 0; slot < frames_in_flight; ++slot)
+        {
+            textures.collect(slot);
+        }
+
+        textures.report(std::cout);
+    }
+
+    if (culling == cull_mode::cpu)
+    {
+        std::cout << "Culling: " << culler.average_visible() << " of " << geometry.instance_count
+                  << " instances visible per frame\n";
+    }
+
+    graph.report(std::cout);
+    allocator.report(std::cout);
+
+    // Readback of the last rendered frame
+    if (!settings.output_path.empty() && frame_number > 0)
+    {
+        const uint32_t last_frame = (current_frame + frames_in_flight - 1) % frames_in_flight;
+        const VkDeviceSize readback_size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+
+        gpu_buffer readback = create_buffer(allocator, readback_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        VkCommandBuffer command_buffer = command_buffers[0];
+        vkResetCommandBuffer(command_buffer, 0);
+
+        VkCommandBufferBeginInfo command_buffer_begin_info{};
+        command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to begin recording readback command buffer");
+        }
+
+        // The render pass already transitioned the image, only its writes need to be made visible
+        VkImageMemoryBarrier image_barrier{};
+        image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        image_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        image_barrier.image = images[last_frame];
+        image_barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+
+        VkBufferImageCopy copy_region{};
+        copy_region.bufferOffset = 0;
+        copy_region.bufferRowLength = 0;
+        copy_region.bufferImageHeight = 0;
+        copy_region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        copy_region.imageOffset = {0, 0, 0};
+        copy_region.imageExtent = {extent.width, extent.height, 1};
+
+        vkCmdCopyImageToBuffer(command_buffer, images[last_frame], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &copy_region);
+
+        VkBufferMemoryBarrier buffer_barrier{};
+        buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        buffer_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        buffer_barrier.buffer = readback.buffer;
+        buffer_barrier.offset = 0;
+        buffer_barrier.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 0, nullptr, 1, &buffer_barrier, 0, nullptr);
+
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to record readback command buffer");
+        }
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &command_buffer;
+
+        vkResetFences(logical_device, 1, &in_flight_fences[0]);
+
+        if (vkQueueSubmit(device.graphics_queue, 1, &submit_info, in_flight_fences[0]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to submit readback");
+        }
+
+        vkWaitForFences(logical_device, 1, &in_flight_fences[0], VK_TRUE, UINT64_MAX);
+
+        write_ppm(settings.output_path, static_cast<const uint8_t*>(readback.allocation.mapped), extent);
+
+        std::cout << "Wrote last frame to " << settings.output_path << "\n";
+
+        destroy_buffer(allocator, readback);
+    }
+
+    // Cleanup, the graph's framebuffers go before the offscreen views they reference
+    vkDeviceWaitIdle(logical_device);
+    graph.destroy();
+
+    for (uint32_t i = 0; i < frames_in_flight; ++i)
+    {
+        vkDestroyFence(logical_device, in_flight_fences[i], nullptr);
+        vkDestroyImageView(logical_device, image_views[i], nullptr);
+        vkDestroyImage(logical_device, images[i], nullptr);
+        allocator.free(image_memory[i]);
+    }
+
+    if (settings.stream_instances)
+    {
+        for (scene_geometry& streamed : streamed_geometry)
+        {
+            destroy_buffer(allocator, streamed.instances);
+        }
+
+        uploader.destroy();
+    }
+
+    if (textured)
+    {
+        textures.destroy();
+    }
+
+    culler.destroy();
+    uniforms.destroy();
+    recorder.destroy();
+    timer.destroy();
+    prerecorded_frames.destroy();
+    destroy_scene_geometry(allocator, geometry);
+    vkDestroyCommandPool(logical_device, command_pool, nullptr);
+    if (pipeline_cache != VK_NULL_HANDLE)
+    {
+        save_pipeline_cache(device.physical_device, logical_device, pipeline_cache, settings.pipeline_cache_path);
+        vkDestroyPipelineCache(logical_device, pipeline_cache, nullptr);
+    }
+
+    for (uint32_t i = 0; i < settings.post_passes; ++i)
+    {
+        vkDestroyPipeline(logical_device, post_pipelines[i], nullptr);
+        vkDestroyPipelineLayout(logical_device, post_pipeline_layouts[i], nullptr);
+    }
+
+    if (settings.post_passes > 0)
+    {
+        vkDestroyShaderModule(logical_device, post_fragment_shader_module, nullptr);
+        vkDestroyShaderModule(logical_device, post_vertex_shader_module, nullptr);
+    }
+
+    vkDestroyPipeline(logical_device, pipeline, nullptr);
+    vkDestroyPipelineLayout(logical_device, pipeline_layout, nullptr);
+
+    if (texture_set_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(logical_device, texture_set_layout, nullptr);
+    }
+
+    vkDestroyDescriptorSetLayout(logical_device, uniform_set_layout, nullptr);
+    vkDestroyShaderModule(logical_device, fragment_shader_module, nullptr);
+    vkDestroyShaderModule(logical_device, vertex_shader_module, nullptr);
+    allocator.destroy();
+
+    return {elapsed_seconds > 0.0 ? frame_number / elapsed_seconds : 0.0, frame_times.average(), cpu_times.average()};
+}
+
+void run_cull_benchmark(const options& settings, const device_context& device)
+{
+    const char* const modes[] = {"none", "cpu", "gpu"};
+    headless_result results[3];
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        options run_settings = settings;
+        run_settings.cull = modes[i];
+
+        std::cout << "Culling benchmark, --cull=" << modes[i] << ":\n";
+        results[i] = run_headless(run_settings, device);
+        std::cout << "\n";
+    }
+
+    std::cout << "Culling comparison, " << settings.instances << " instances at world scale " << settings.world_scale << ":\n"
+              << std::fixed << std::setprecision(3);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        std::cout << "  " << std::left << std::setw(5) << modes[i] << std::right
+                  << " CPU submission " << std::setw(9) << results[i].cpu_milliseconds << " ms/frame,"
+                  << " frame time " << std::setw(9) << results[i].frame_milliseconds << " ms,"
+                  << " " << std::setw(10) << results[i].frames_per_second << " frames/s\n";
+    }
+
+    std::cout << std::defaultfloat;
+}
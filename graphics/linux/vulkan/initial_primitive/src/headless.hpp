@@ -0,0 +1,22 @@
+#ifndef _HEADLESS_HPP_
+#define _HEADLESS_HPP_
+
+#include "device.hpp"
+#include "options.hpp"
+
+// Throughput of a headless run, for benchmarks that compare several runs
+struct headless_result
+{
+    double frames_per_second = 0.0;
+    double frame_milliseconds = 0.0;
+    double cpu_milliseconds = 0.0;
+};
+
+// Renders the sample into offscreen images and reports throughput, without any window system
+headless_result run_headless(const options& settings, const device_context& device);
+
+// Renders the same instances without culling, with CPU culling and with GPU culling, then reports
+// the CPU submission time and frame time of the three side by side
+void run_cull_benchmark(const options& settings, const device_context& device);
+
+#endif
@@ -1,135 +1,152 @@
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
+#include "async_uploader.hpp"
+#include "compute_benchmark.hpp"
+#include "culling.hpp"
+#include "deferred_destruction.hpp"
+#include "device.hpp"
+#include "dynamic_resolution.hpp"
+#include "frame_statistics.hpp"
+#include "headless.hpp"
+#include "memory_benchmark.hpp"
+#include "options.hpp"
+#include "parallel_recorder.hpp"
+#include "pipeline_cache.hpp"
+#include "recorded_commands.hpp"
+#include "render_graph.hpp"
+#include "renderer.hpp"
+#include "sample_trace.h"
+#include "shader_watcher.hpp"
+#include "swapchain.hpp"
+#include "texture_streamer.hpp"
+#include "uniform_ring.hpp"
 
 #include <algorithm>
-#include <fstream>
-#include <limits>
-#include <optional>
-#include <set>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
-int main(int argc, char** argv) 
-{
-    // GLFW initialization
-    glfwInit();
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Vulkan", nullptr, nullptr);
-
-    // Application information
-    VkApplicationInfo app_info{};
-    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-    app_info.pApplicationName = "Initial Vulkan Primitive";
-    app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.pEngineName = "None";
-    app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_API_VERSION_1_0;
-
-    // Create information
-    VkInstanceCreateInfo instance_create_info{};
-    instance_create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-    instance_create_info.pApplicationInfo = &app_info;
-
-    uint32_t glfw_extension_count = 0;
-    const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-
-    const std::vector<const char*> validation_layers = {
-        "VK_LAYER_KHRONOS_validation"
-    };
+static const std::pair<const char*, VkPresentModeKHR> present_mode_names[] = {
+    {"fifo", VK_PRESENT_MODE_FIFO_KHR},
+    {"fifo_relaxed", VK_PRESENT_MODE_FIFO_RELAXED_KHR},
+    {"mailbox", VK_PRESENT_MODE_MAILBOX_KHR},
+    {"immediate", VK_PRESENT_MODE_IMMEDIATE_KHR}
+};
 
-    uint32_t available_layers_count;
-    vkEnumerateInstanceLayerProperties(&available_layers_count, nullptr);
-
-    std::vector<VkLayerProperties> available_layers(available_layers_count);
-    vkEnumerateInstanceLayerProperties(&available_layers_count, available_layers.data());
-
-    std::set<std::string> required_layers(validation_layers.begin(), validation_layers.end());
-
-    for (const auto& layer : available_layers)
+static VkPresentModeKHR present_mode_from_name(const std::string& name)
+{
+    for (const auto& [mode_name, mode] : present_mode_names)
     {
-        required_layers.erase(layer.layerName);
+        if (name == mode_name)
+        {
+            return mode;
+        }
     }
 
-    if (!required_layers.empty())
+    throw std::runtime_error("Unknown present mode: " + name);
+}
+
+static const char* present_mode_name(VkPresentModeKHR mode)
+{
+    for (const auto& [mode_name, named_mode] : present_mode_names)
     {
-        throw std::runtime_error("Required layers are unavailable");
+        if (mode == named_mode)
+        {
+            return mode_name;
+        }
     }
 
-    instance_create_info.enabledExtensionCount = glfw_extension_count;
-    instance_create_info.ppEnabledExtensionNames = glfw_extensions;
-    instance_create_info.enabledLayerCount = 1;
-    instance_create_info.ppEnabledLayerNames = validation_layers.data();
+    return "unknown";
+}
 
-    // Instance creation
-    VkInstance instance;
+int main(int argc, char** argv) 
+{
+    const options settings = parse_options(argc, argv);
+    sample_trace_start(settings.trace_path.c_str());
 
-    if (vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS)
+    // Headless rendering and benchmarks skip GLFW and the surface entirely
+    if (settings.headless || settings.memory_benchmark || settings.compute_benchmark_mib > 0 || settings.cull_benchmark)
     {
-        throw std::runtime_error("Failed to create Vulkan instance");
-    }
+        VkInstance instance = create_instance({}, settings.validation);
+        device_context device = create_device(instance, VK_NULL_HANDLE, settings.cull == "gpu" || settings.cull_benchmark
+            ? std::vector<const char*>{VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME}
+            : std::vector<const char*>{});
 
-    // Render surface creation
-    VkSurfaceKHR surface;
+        bool passed = true;
 
-    if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create surface rendering target");
-    }
-
-    // Physical device enumeration
-    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
-    
-    uint32_t device_count = 0;
-    vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
+        if (settings.memory_benchmark)
+        {
+            run_memory_benchmark(device);
+        }
+        else if (settings.compute_benchmark_mib > 0)
+        {
+            passed = run_compute_benchmark(settings, device);
+        }
+        else if (settings.cull_benchmark)
+        {
+            run_cull_benchmark(settings, device);
+        }
+        else
+        {
+            run_headless(settings, device);
+        }
 
-    if (device_count == 0)
-    {
-        throw std::runtime_error("No devices with Vulkan support found");
+        vkDestroyDevice(device.logical_device, nullptr);
+        vkDestroyInstance(instance, nullptr);
+        return passed ? 0 : 1;
     }
 
-    std::vector<VkPhysicalDevice> devices(device_count);
-    vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
+    // GLFW initialization
+    const uint64_t glfw_trace_start = sample_trace_begin();
+    glfwInit();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    GLFWwindow* window = glfwCreateWindow(settings.width, settings.height, "Vulkan", nullptr, nullptr);
+    sample_trace_end("glfw_init", glfw_trace_start);
 
-    // Physical device property identification
-    VkPhysicalDeviceFeatures device_features;
-    bool suitable_device_found = false;
+    // Some platforms never report the swapchain out of date on resize, so the size change is tracked as well
+    bool framebuffer_resized = false;
+    glfwSetWindowUserPointer(window, &framebuffer_resized);
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* resized_window, int, int) {
+        *static_cast<bool*>(glfwGetWindowUserPointer(resized_window)) = true;
+    });
 
-    for (const auto& device: devices)
-    {
-        vkGetPhysicalDeviceFeatures(device, &device_features);
+    // Instance creation
+    uint32_t glfw_extension_count = 0;
+    const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+    VkInstance instance = create_instance(std::vector<const char*>(glfw_extensions, glfw_extensions + glfw_extension_count),
+        settings.validation);
 
-        if (device_features.geometryShader)
-        {
-            suitable_device_found = true;
-            physical_device = device;
-            break;
-        }
-    }
+    // Render surface creation
+    VkSurfaceKHR surface;
 
-    if (!suitable_device_found)
+    if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
     {
-        throw std::runtime_error("No suitable GPU with geometry shader support");
+        throw std::runtime_error("Failed to create surface rendering target");
     }
 
-    // Swapchain extension validation
-    uint32_t extension_count = 0;
-    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
-    const std::vector<const char*> required_device_extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
-
-    std::vector<VkExtensionProperties> available_extensions(extension_count);
-    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, available_extensions.data());
-    std::set<std::string> required_extensions(required_device_extensions.begin(), required_device_extensions.end());
+    // Device creation
+    std::vector<const char*> optional_extensions;
 
-    for (const auto& extension : available_extensions)
+    if (settings.latency)
     {
-        required_extensions.erase(extension.extensionName);
+        optional_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        optional_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
     }
 
-    if (!required_extensions.empty())
+    if (settings.cull == "gpu")
     {
-        throw std::runtime_error("One or more required device extensions are unavailable");
+        optional_extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
     }
 
+    device_context device = create_device(instance, surface, optional_extensions);
+    VkPhysicalDevice physical_device = device.physical_device;
+    VkDevice logical_device = device.logical_device;
+    VkQueue graphics_queue = device.graphics_queue;
+    VkQueue present_queue = device.present_queue;
+
     // Swapchain formatting and presentation validation
     uint32_t format_count = 0;
     vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, nullptr);
@@ -150,481 +167,233 @@ int main(int argc, char** argv)
     std::vector<VkSurfaceFormatKHR> supported_formats(format_count);
     vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, supported_formats.data());
 
-    VkPresentModeKHR selected_mode = VK_PRESENT_MODE_FIFO_KHR;
     std::vector<VkPresentModeKHR> presentation_formats(presentation_count);
     vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &presentation_count, presentation_formats.data());
 
-    for (const auto& mode : presentation_formats)
-    {
-        if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            selected_mode = mode;
-            break;
-        }
-    }
-
-    // Extent selection
-    VkSurfaceCapabilitiesKHR surface_capabilities;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &surface_capabilities);
+    // Present mode selection in order of preference, FIFO is always supported as the fallback
+    std::vector<VkPresentModeKHR> preferred_modes = {VK_PRESENT_MODE_MAILBOX_KHR};
 
-    VkExtent2D selected_extent;
-
-    if (surface_capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) 
+    if (!settings.present_mode.empty())
     {
-        selected_extent = surface_capabilities.currentExtent;
-    } 
-    else
+        preferred_modes = {present_mode_from_name(settings.present_mode)};
+    }
+    else if (settings.uncapped)
     {
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
-
-        selected_extent = VkExtent2D{
-            std::clamp(static_cast<uint32_t>(width), surface_capabilities.minImageExtent.width, surface_capabilities.maxImageExtent.width),
-            std::clamp(static_cast<uint32_t>(height), surface_capabilities.maxImageExtent.width, surface_capabilities.maxImageExtent.height)
-        };
+        preferred_modes = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
     }
 
-    // Queue family enumeration
-    uint32_t queue_family_count = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
-
-    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
-    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
-    
-    uint32_t index = 0;
-    std::optional<uint32_t> graphics_queue_index;
-    std::optional<uint32_t> present_queue_index;
+    VkPresentModeKHR selected_mode = VK_PRESENT_MODE_FIFO_KHR;
 
-    for (const auto& queue_family : queue_families)
+    for (const auto& preferred_mode : preferred_modes)
     {
-        VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, index, surface, &present_support);
-
-        if (present_support)
+        if (std::find(presentation_formats.begin(), presentation_formats.end(), preferred_mode) != presentation_formats.end())
         {
-            present_queue_index = index;
-        }
-
-        if (queue_family.queueFlags && VK_QUEUE_GRAPHICS_BIT)
-        {
-            graphics_queue_index = index;
+            selected_mode = preferred_mode;
+            break;
         }
-
-        ++index;
     }
 
-    if (!graphics_queue_index.has_value())
+    if (!settings.present_mode.empty() && selected_mode != preferred_modes[0])
     {
-        throw std::runtime_error("No queue family with graphics command support found");
+        std::cerr << "Present mode " << settings.present_mode << " is unsupported, falling back to fifo\n";
     }
 
-    if (!present_queue_index.has_value())
-    {
-        throw std::runtime_error("No queue family with present support found");
-    }
+    // Buffers and images are sub-allocated from shared device memory blocks
+    memory_allocator allocator;
+    allocator.create(physical_device, logical_device);
 
-    // Logical device creation
-    VkDevice logical_device;
-    std::vector<VkDeviceQueueCreateInfo> queue_creation_infos;
-    std::set<uint32_t> unique_queue_indicies = {graphics_queue_index.value(), present_queue_index.value()};
+    // Render pass from a single pass render graph, whose only image is the swapchain's, and pipeline.
+    // With dynamic resolution the pass draws into a scaled target that is then blitted into it.
+    const bool scaled = settings.target_frame_milliseconds > 0.0;
+    render_graph graph;
+    const resource_id backbuffer = scaled
+        ? graph.import_image("scaled", supported_formats[0].format, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+        : graph.import_image("swapchain", supported_formats[0].format, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    const uint32_t scene_pass = graph.add_pass("scene", {backbuffer});
+    graph.compile(physical_device, allocator, {settings.width, settings.height}, settings.frames_in_flight);
 
-    for (const auto& queue_index : unique_queue_indicies)
-    {
-        VkDeviceQueueCreateInfo queue_create_info{};
-        queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queue_create_info.queueFamilyIndex = queue_index;
-        queue_create_info.queueCount = 1;
+    VkShaderModule vertex_shader_module = load_shader_module(logical_device, "vert.spv", settings.shader_directory);
+    const bool textured = !settings.texture_path.empty();
+    VkDescriptorSetLayout uniform_set_layout = create_uniform_set_layout(logical_device);
+    VkDescriptorSetLayout texture_set_layout = textured ? create_texture_set_layout(logical_device) : VK_NULL_HANDLE;
+    const std::string fragment_shader_name = textured ? "textured.spv" : "frag.spv";
+    VkShaderModule fragment_shader_module = load_shader_module(logical_device, fragment_shader_name, settings.shader_directory);
+    VkRenderPass render_pass = graph.render_pass(scene_pass);
+    VkPipelineLayout pipeline_layout = create_pipeline_layout(logical_device, uniform_set_layout, texture_set_layout);
 
-        float queue_priority = 1.0f;
-        queue_create_info.pQueuePriorities = &queue_priority;
+    // Pipeline creation through the persistent cache
+    size_t pipeline_cache_bytes = 0;
+    VkPipelineCache pipeline_cache = settings.pipeline_cache_path.empty()
+        ? VK_NULL_HANDLE
+        : load_pipeline_cache(physical_device, logical_device, settings.pipeline_cache_path, pipeline_cache_bytes);
 
-        queue_creation_infos.push_back(queue_create_info);
-    }
+    pipeline_specialization specialization;
+    specialization.flat_color = settings.flat_color;
+    std::copy(settings.color, settings.color + 3, specialization.color);
+
+    const auto pipeline_start = std::chrono::steady_clock::now();
+    VkPipeline pipeline = create_graphics_pipeline(logical_device, pipeline_cache, render_pass, pipeline_layout,
+        vertex_shader_module, fragment_shader_module, specialization);
+
+    std::cout << "Pipeline creation: "
+              << milliseconds_between(pipeline_start, std::chrono::steady_clock::now()) << " ms ("
+              << (pipeline_cache_bytes > 0 ? "warm" : "cold") << " cache, " << pipeline_cache_bytes << " bytes loaded)\n";
 
-    VkPhysicalDeviceFeatures logical_device_features{};
-    VkDeviceCreateInfo device_create_info{};
-    device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    device_create_info.pQueueCreateInfos = queue_creation_infos.data();
-    device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_creation_infos.size());
-    device_create_info.pEnabledFeatures = &logical_device_features;
-    device_create_info.enabledExtensionCount = static_cast<uint32_t>(required_device_extensions.size());
-    device_create_info.ppEnabledExtensionNames = required_device_extensions.data();
-    device_create_info.enabledLayerCount = 0;
+    // With --shader-dir the pipeline is rebuilt whenever its SPIR-V files are recompiled
+    shader_watcher shader_changes;
+    shader_changes.create(settings.shader_directory, {"vert.spv", fragment_shader_name});
 
-    if (vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS)
+    // Swapchain, views and framebuffers, recreated whenever the window is resized
+    swapchain_settings swapchain_configuration;
+    swapchain_configuration.surface_format = supported_formats[0];
+    swapchain_configuration.present_mode = selected_mode;
+    swapchain_configuration.requested_images = settings.swapchain_images;
+
+    if (scaled)
     {
-        throw std::runtime_error("Failed to create logical device");
+        swapchain_configuration.image_usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     }
 
-    // Queue handle retrieval
-    VkQueue graphics_queue;
-    VkQueue present_queue;
-    vkGetDeviceQueue(logical_device, graphics_queue_index.value(), 0, &graphics_queue);
-    vkGetDeviceQueue(logical_device, present_queue_index.value(), 0, &present_queue);
+    swapchain_context swapchain = create_swapchain(device, surface, swapchain_configuration,
+        select_extent(physical_device, surface, window), render_pass, VK_NULL_HANDLE);
 
-    // Swapchain creation
-    VkSwapchainCreateInfoKHR swapchain_create_info{};
-    swapchain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    swapchain_create_info.surface = surface;
-    swapchain_create_info.minImageCount = surface_capabilities.minImageCount;
-    swapchain_create_info.imageFormat = supported_formats[0].format;
-    swapchain_create_info.imageColorSpace = supported_formats[0].colorSpace;
-    swapchain_create_info.imageExtent = selected_extent;
-    swapchain_create_info.imageArrayLayers = 1;
-    swapchain_create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    swapchain_create_info.preTransform = surface_capabilities.currentTransform;
-    swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    swapchain_create_info.presentMode = selected_mode;
-    swapchain_create_info.clipped = VK_TRUE;
-    swapchain_create_info.oldSwapchain = VK_NULL_HANDLE;
+    std::cout << "Present mode: " << present_mode_name(selected_mode) << ", swapchain images: " << swapchain.images.size() << "\n";
 
-    const uint32_t queue_family_indices[] = {graphics_queue_index.value(), present_queue_index.value()};
+    // Command pool
+    VkCommandPool command_pool;
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    command_pool_create_info.queueFamilyIndex = device.graphics_queue_index;
 
-    if (graphics_queue_index.value() == present_queue_index.value())
-    {
-        swapchain_create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        swapchain_create_info.queueFamilyIndexCount = 0;
-        swapchain_create_info.pQueueFamilyIndices = nullptr;
-    }
-    else
+    if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS)
     {
-        swapchain_create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-        swapchain_create_info.queueFamilyIndexCount = 2;
-        swapchain_create_info.pQueueFamilyIndices = queue_family_indices; 
+        throw std::runtime_error("Unable to create command pool");
     }
 
-    VkSwapchainKHR swapchain;
+    // Vertex, index and instance buffers, uploaded once through a staging buffer
+    scene_geometry geometry = create_scene_geometry(allocator, device.graphics_queue, command_pool,
+        settings.instances, settings.draw_per_object, settings.world_scale);
+    std::cout << "Instances: " << geometry.instance_count << ", draw calls per frame: "
+        << (geometry.draw_per_object ? geometry.instance_count : 1) << "\n";
 
-    if (vkCreateSwapchainKHR(logical_device, &swapchain_create_info, nullptr, &swapchain) != VK_SUCCESS)
+    // Command buffers, one per frame in flight
+    const uint32_t frames_in_flight = settings.frames_in_flight;
+    std::vector<VkCommandBuffer> command_buffers(frames_in_flight);
+    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocation_info.commandPool = command_pool;
+    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocation_info.commandBufferCount = frames_in_flight;
+
+    if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, command_buffers.data()) != VK_SUCCESS)
     {
-        throw std::runtime_error("Unable to create swapchain");
+        throw std::runtime_error("Unable to allocate command buffers");
     }
 
-    // Image retrieval
-    uint32_t image_count;
-    vkGetSwapchainImagesKHR(logical_device, swapchain, &image_count, nullptr);
-    std::vector<VkImage> swapchain_images(image_count);
-    vkGetSwapchainImagesKHR(logical_device, swapchain, &image_count, swapchain_images.data());
-    std::vector<VkImageView> image_views(swapchain_images.size());
+    // Pre-recorded command buffers, one per swapchain framebuffer
+    recorded_commands prerecorded_frames;
 
-    for (size_t i = 0; i < swapchain_images.size(); ++i)
+    if (settings.prerecorded)
     {
-        VkImageViewCreateInfo image_view_create_info{};
-        image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        image_view_create_info.image = swapchain_images[i];
-        image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        image_view_create_info.format = supported_formats[0].format;
-        image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-        image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        image_view_create_info.subresourceRange.baseMipLevel = 0;
-        image_view_create_info.subresourceRange.levelCount = 1;
-        image_view_create_info.subresourceRange.baseArrayLayer = 0;
-        image_view_create_info.subresourceRange.layerCount = 1;
-
-        if (vkCreateImageView(logical_device, &image_view_create_info, nullptr, &image_views[i]) != VK_SUCCESS)
-        {
-            throw std::runtime_error("Unable to create image view");
-        }
+        prerecorded_frames.create(logical_device, command_pool, swapchain.framebuffers.size());
     }
 
-    // Shader loading
-    std::ifstream vertex_shader_file("vert.spv", std::ios::ate | std::ios::binary);
+    // Secondary command buffer recording, one command pool per worker per frame in flight
+    parallel_recorder recorder;
 
-    if (!vertex_shader_file.is_open())
+    if (settings.record_threads > 0)
     {
-        throw std::runtime_error("Unable to read vertex shader SPIR-V");
+        recorder.create(logical_device, device.graphics_queue_index, settings.record_threads, frames_in_flight);
     }
 
-    size_t vertex_file_size = (size_t) vertex_shader_file.tellg();
-    std::vector<char> vertex_shader_bytecode(vertex_file_size);
+    // Per frame resources such as timestamp queries and streamed instances live in slots, keyed by
+    // swapchain image for pre-recorded buffers since those keep referencing the same resources
+    const uint32_t frame_slots = settings.prerecorded ? static_cast<uint32_t>(swapchain.framebuffers.size()) : frames_in_flight;
 
-    vertex_shader_file.seekg(0);
-    vertex_shader_file.read(vertex_shader_bytecode.data(), vertex_file_size);
-    vertex_shader_file.close();
+    // Frame uniforms, one ring slot per frame slot bound through a single descriptor set. A slot's
+    // dynamic offset never changes, so pre-recorded buffers pick up the new data every frame.
+    uniform_ring uniforms;
+    uniforms.create(device, allocator, uniform_set_layout, frame_slots, 1, sizeof(frame_uniforms));
+    geometry.pipeline_layout = pipeline_layout;
+    geometry.frame_set = uniforms.descriptor_set();
+    std::copy(settings.tint, settings.tint + 3, geometry.constants.tint);
 
-    std::ifstream fragment_shader_file("frag.spv", std::ios::ate | std::ios::binary);
+    // GPU timestamps, one query slot per command buffer that may be in flight
+    gpu_timer timer;
 
-    if (!fragment_shader_file.is_open())
+    if (settings.gpu_timing)
     {
-        throw std::runtime_error("Unable to read fragment shader SPIR-V");
+        timer.create(physical_device, logical_device, device.graphics_queue_index,
+            frame_slots, timed_pass_names, settings.gpu_timing_csv);
     }
 
-    size_t fragment_file_size = (size_t) fragment_shader_file.tellg();
-    std::vector<char> fragment_shader_bytecode(fragment_file_size);
-
-    fragment_shader_file.seekg(0);
-    fragment_shader_file.read(fragment_shader_bytecode.data(), fragment_file_size);
-    fragment_shader_file.close();
+    gpu_timer* frame_timer = settings.gpu_timing ? &timer : nullptr;
 
-    // Shader module creation
-    VkShaderModuleCreateInfo vertex_shader_module_create_info{};
-    vertex_shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    vertex_shader_module_create_info.codeSize = vertex_shader_bytecode.size();
-    vertex_shader_module_create_info.pCode = reinterpret_cast<const uint32_t*>(vertex_shader_bytecode.data());
-    VkShaderModule vertex_shader_module;
+    // Scaled render targets, one per frame slot, following the GPU time of each frame or the frame
+    // interval when the queue has no timestamps
+    dynamic_resolution resolution;
 
-    if (vkCreateShaderModule(logical_device, &vertex_shader_module_create_info, nullptr, &vertex_shader_module) != VK_SUCCESS)
+    if (scaled)
     {
-        throw std::runtime_error("Unable to create vertex shader module");
+        resolution.create(device, allocator, render_pass, supported_formats[0].format, swapchain.extent, frame_slots,
+            settings.target_frame_milliseconds, settings.min_render_scale);
     }
 
-    VkShaderModuleCreateInfo fragment_shader_module_create_info{};
-    fragment_shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    fragment_shader_module_create_info.codeSize = fragment_shader_bytecode.size();
-    fragment_shader_module_create_info.pCode = reinterpret_cast<const uint32_t*>(fragment_shader_bytecode.data());
-    VkShaderModule fragment_shader_module;
+    const bool scale_from_gpu_time = scaled && timer.supported();
 
-    if (vkCreateShaderModule(logical_device, &fragment_shader_module_create_info, nullptr, &fragment_shader_module) != VK_SUCCESS)
+    // Instance buffers rewritten every frame through the transfer queue, one per frame slot
+    async_uploader uploader;
+    std::vector<scene_geometry> streamed_geometry;
+
+    if (settings.stream_instances)
     {
-        throw std::runtime_error("Unable to create fragment shader module");
-    }
-
-    // Shader stage creation
-    VkPipelineShaderStageCreateInfo vertex_shader_stage_creation_info{};
-    vertex_shader_stage_creation_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertex_shader_stage_creation_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertex_shader_stage_creation_info.module = vertex_shader_module;
-    vertex_shader_stage_creation_info.pName = "main";
-
-    VkPipelineShaderStageCreateInfo fragment_shader_stage_creation_info{};
-    fragment_shader_stage_creation_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragment_shader_stage_creation_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragment_shader_stage_creation_info.module = fragment_shader_module;
-    fragment_shader_stage_creation_info.pName = "main";
-
-    VkPipelineShaderStageCreateInfo shader_stages[] = {vertex_shader_stage_creation_info, fragment_shader_stage_creation_info};
-
-    // Dynamic state configuration
-    std::vector<VkDynamicState> dynamic_states{};
-
-    VkPipelineDynamicStateCreateInfo dynamic_state_create_info{};
-    dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamic_state_create_info.dynamicStateCount = dynamic_states.size();
-    dynamic_state_create_info.pDynamicStates = dynamic_states.data();
-
-    // Vertex input
-    VkPipelineVertexInputStateCreateInfo vertex_input_state_create_info{};
-    vertex_input_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertex_input_state_create_info.vertexBindingDescriptionCount = 0;
-    vertex_input_state_create_info.pVertexBindingDescriptions = nullptr;
-    vertex_input_state_create_info.vertexAttributeDescriptionCount = 0;
-    vertex_input_state_create_info.pVertexAttributeDescriptions = nullptr;
-
-    // Input assembly
-    VkPipelineInputAssemblyStateCreateInfo input_assembly_state_create_info{};
-    input_assembly_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    input_assembly_state_create_info.primitiveRestartEnable = VK_FALSE;
-
-    // Viewport
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)selected_extent.width;
-    viewport.height = (float)selected_extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    // Scissor
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = selected_extent;
-
-    // Viewport state
-    VkPipelineViewportStateCreateInfo viewport_state_create_info{};
-    viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewport_state_create_info.viewportCount = 1;
-    viewport_state_create_info.pViewports = &viewport;
-    viewport_state_create_info.scissorCount = 1;
-    viewport_state_create_info.pScissors = &scissor;
-
-    // Rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterization_state_create_info{};
-    rasterization_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterization_state_create_info.depthClampEnable = VK_FALSE;
-    rasterization_state_create_info.rasterizerDiscardEnable = VK_FALSE;
-    rasterization_state_create_info.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterization_state_create_info.lineWidth = 1.0f;
-    rasterization_state_create_info.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterization_state_create_info.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterization_state_create_info.depthBiasEnable = VK_FALSE;
-    rasterization_state_create_info.depthBiasConstantFactor = 0.0f;
-    rasterization_state_create_info.depthBiasClamp = 0.0f;
-    rasterization_state_create_info.depthBiasSlopeFactor = 0.0f;
-
-    // Multisampling
-    VkPipelineMultisampleStateCreateInfo multisample_state_create_info{};
-    multisample_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisample_state_create_info.sampleShadingEnable = VK_FALSE;
-    multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisample_state_create_info.minSampleShading = 1.0f;
-    multisample_state_create_info.pSampleMask = nullptr;
-    multisample_state_create_info.alphaToCoverageEnable = VK_FALSE;
-    multisample_state_create_info.alphaToOneEnable = VK_FALSE;
-
-    // Blending
-    VkPipelineColorBlendAttachmentState color_blend_attachment{};
-    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    color_blend_attachment.blendEnable = VK_FALSE;
-    color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-    color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
-    color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-    VkPipelineColorBlendStateCreateInfo color_blend_state_create_info{};
-    color_blend_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    color_blend_state_create_info.logicOpEnable = VK_FALSE;
-    color_blend_state_create_info.logicOp = VK_LOGIC_OP_COPY;
-    color_blend_state_create_info.attachmentCount = 1;
-    color_blend_state_create_info.pAttachments = &color_blend_attachment;
-    color_blend_state_create_info.blendConstants[0] = 0.0f;
-    color_blend_state_create_info.blendConstants[1] = 0.0f;
-    color_blend_state_create_info.blendConstants[2] = 0.0f;
-    color_blend_state_create_info.blendConstants[3] = 0.0f;
-
-    // Color buffer attachment
-    VkAttachmentDescription color_attachment{};
-    color_attachment.format = supported_formats[0].format;
-    color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    // Subpass attachment
-    VkAttachmentReference color_attachment_ref{};
-    color_attachment_ref.attachment = 0;
-    color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    // Subpass
-    VkSubpassDescription subpass_description{};
-    subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass_description.colorAttachmentCount = 1;
-    subpass_description.pColorAttachments = &color_attachment_ref;
-
-    // Subpass dependencies
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    // Render Pass
-    VkRenderPass render_pass;
-    VkRenderPassCreateInfo render_pass_create_info{};
-    render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    render_pass_create_info.attachmentCount = 1;
-    render_pass_create_info.pAttachments = &color_attachment;
-    render_pass_create_info.subpassCount = 1;
-    render_pass_create_info.pSubpasses = &subpass_description;
-    render_pass_create_info.dependencyCount = 1;
-    render_pass_create_info.pDependencies = &dependency;
-
-    if (vkCreateRenderPass(logical_device, &render_pass_create_info, nullptr, &render_pass) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Unable to create render pass");
-    }
-
-    // Pipeline layout
-    VkPipelineLayout pipeline_layout;
-    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
-    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_create_info.setLayoutCount = 0;
-    pipeline_layout_create_info.pSetLayouts = nullptr;
-    pipeline_layout_create_info.pushConstantRangeCount = 0;
-    pipeline_layout_create_info.pPushConstantRanges = nullptr;
-
-    if (vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Unable to create pipeline layout");
-    }
-
-    // Graphics pipeline
-    VkPipeline pipeline;
-    VkGraphicsPipelineCreateInfo pipeline_create_info{};
-    pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipeline_create_info.stageCount = 2;
-    pipeline_create_info.pStages = shader_stages;
-    pipeline_create_info.pVertexInputState = &vertex_input_state_create_info;
-    pipeline_create_info.pInputAssemblyState = &input_assembly_state_create_info;
-    pipeline_create_info.pViewportState = &viewport_state_create_info;
-    pipeline_create_info.pRasterizationState = &rasterization_state_create_info;
-    pipeline_create_info.pMultisampleState = &multisample_state_create_info;
-    pipeline_create_info.pDepthStencilState = nullptr;
-    pipeline_create_info.pColorBlendState = &color_blend_state_create_info;
-    pipeline_create_info.pDynamicState = &dynamic_state_create_info;
-    pipeline_create_info.layout = pipeline_layout;
-    pipeline_create_info.renderPass = render_pass;
-    pipeline_create_info.subpass = 0;
-    pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
-    pipeline_create_info.basePipelineIndex = -1;
-
-    if (vkCreateGraphicsPipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Unable to create graphics pipeline");
-    }
-
-    // Framebuffers
-    std::vector<VkFramebuffer> swapchain_framebuffers(image_views.size());
-
-    for (size_t i = 0; i < image_views.size(); ++i)
-    {
-        VkImageView attachments[] = {
-            image_views[i]
-        };
-
-        VkFramebufferCreateInfo framebuffer_create_info{};
-        framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebuffer_create_info.renderPass = render_pass;
-        framebuffer_create_info.attachmentCount = 1;
-        framebuffer_create_info.pAttachments = attachments;
-        framebuffer_create_info.width = selected_extent.width;
-        framebuffer_create_info.height = selected_extent.height;
-        framebuffer_create_info.layers = 1;
-
-        if (vkCreateFramebuffer(logical_device, &framebuffer_create_info, nullptr, &swapchain_framebuffers[i]) != VK_SUCCESS)
-        {
-            throw std::runtime_error("Unable to create framebuffer");
+        uploader.create(device, allocator, frame_slots, geometry.instances.size);
+
+        streamed_geometry.assign(frame_slots, geometry);
+
+        for (scene_geometry& streamed : streamed_geometry)
+        {
+            streamed.instances = create_buffer(allocator, geometry.instances.size,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
         }
+
+        std::cout << "Streaming instances on " << (uploader.dedicated() ? "a dedicated transfer queue" : "the graphics queue")
+                  << " (family " << device.transfer_queue_index << ")\n";
     }
 
-    // Command pool
-    VkCommandPool command_pool;
-    VkCommandPoolCreateInfo command_pool_create_info{};
-    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    command_pool_create_info.queueFamilyIndex = graphics_queue_index.value();
+    // Texture streamed from a file mapping, a few mip levels per frame
+    texture_streamer textures;
 
-    if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS)
+    if (textured)
     {
-        throw std::runtime_error("Unable to create command pool");
+        textures.create(device, allocator, settings.texture_path, texture_set_layout, frame_slots, settings.texture_budget_kib * 1024);
     }
 
-    // Command buffer
-    VkCommandBuffer command_buffer;
-    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
-    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    command_buffer_allocation_info.commandPool = command_pool;
-    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    command_buffer_allocation_info.commandBufferCount = 1;
+    // Instance culling, each frame slot culls the instance buffer it draws from
+    const cull_mode culling = cull_mode_from_name(settings.cull);
+    instance_culler culler;
 
-    if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, &command_buffer) != VK_SUCCESS)
+    if (culling != cull_mode::none)
     {
-        throw std::runtime_error("Unable to allocate command buffer");
+        std::vector<VkBuffer> cull_sources(frame_slots, geometry.instances.buffer);
+
+        for (uint32_t slot = 0; slot < streamed_geometry.size(); ++slot)
+        {
+            cull_sources[slot] = streamed_geometry[slot].instances.buffer;
+        }
+
+        culler.create(device, allocator, pipeline_cache, culling, geometry, cull_sources, settings.shader_directory);
     }
 
-    // Synchronization
-    VkSemaphore image_available_semaphore;
-    VkSemaphore render_finished_semaphore;
-    VkFence in_flight_fence;
+    // Synchronization, one set per frame in flight
+    std::vector<VkSemaphore> image_available_semaphores(frames_in_flight);
+    std::vector<VkSemaphore> render_finished_semaphores(frames_in_flight);
+    std::vector<VkFence> in_flight_fences(frames_in_flight);
+
+    // Fence of the frame currently rendering into each swapchain image, if any
+    std::vector<VkFence> images_in_flight(swapchain.images.size(), VK_NULL_HANDLE);
 
     VkSemaphoreCreateInfo semaphore_create_info{};
     semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -633,126 +402,615 @@ int main(int argc, char** argv)
     fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    if (vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &image_available_semaphore) != VK_SUCCESS)
+    for (uint32_t i = 0; i < frames_in_flight; ++i)
     {
-        throw std::runtime_error("Unable to create available image semaphore");
+        if (vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &image_available_semaphores[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create available image semaphore");
+        }
+
+        if (vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &render_finished_semaphores[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create render finished semaphore");
+        }
+
+        if (vkCreateFence(logical_device, &fence_create_info, nullptr, &in_flight_fences[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create in-flight fence");
+        }
     }
 
-    if (vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &render_finished_semaphore) != VK_SUCCESS)
+    // Swapchains replaced by a resize, destroyed once the frames that used them have retired
+    deferred_destruction retired_swapchains;
+    retired_swapchains.create(logical_device, frames_in_flight);
+
+    // Frame timing
+    frame_statistics frame_times;
+    frame_statistics fence_wait_times;
+    frame_statistics cpu_times;
+    uint64_t frame_number = 0;
+    uint32_t current_frame = 0;
+    auto previous_frame_start = std::chrono::steady_clock::now();
+    const auto loop_start = previous_frame_start;
+
+    // Latency instrumentation, measured from the event poll that starts each frame
+    frame_statistics input_to_acquire;
+    frame_statistics input_to_submit;
+    frame_statistics input_to_present;
+    frame_statistics input_to_display;
+    std::deque<std::pair<uint64_t, std::chrono::steady_clock::time_point>> pending_presents;
+
+    PFN_vkWaitForPresentKHR wait_for_present = nullptr;
+
+    if (settings.latency && device.present_wait_supported)
     {
-        throw std::runtime_error("Unable to create render finished semaphore");
+        wait_for_present = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(logical_device, "vkWaitForPresentKHR"));
     }
-
-    if (vkCreateFence(logical_device, &fence_create_info, nullptr, &in_flight_fence) != VK_SUCCESS)
+    else if (settings.latency)
     {
-        throw std::runtime_error("Unable to create in-flight fence");
+        std::cerr << "VK_KHR_present_wait unavailable, input to display latency will not be reported\n";
     }
 
+    // Resize instrumentation, frame times of frames that recreated the swapchain and the time spent recreating
+    frame_statistics resize_frame_times;
+    frame_statistics recreate_times;
+    bool recreated_last_frame = false;
+
+    // Hands the swapchain over to a new one through oldSwapchain and queues the old one for
+    // deferred destruction, nothing here waits on the GPU. Returns false when the window closed
+    // while minimized.
+    auto recreate_swapchain = [&]() {
+        SAMPLE_TRACE_SCOPE("recreate_swapchain");
+        VkExtent2D extent = select_extent(physical_device, surface, window);
+
+        // A minimized window has no extent to render at, so wait for it to come back
+        while ((extent.width == 0 || extent.height == 0) && !glfwWindowShouldClose(window))
+        {
+            glfwWaitEvents();
+            extent = select_extent(physical_device, surface, window);
+        }
+
+        if (extent.width == 0 || extent.height == 0)
+        {
+            return false;
+        }
+
+        const auto recreate_start = std::chrono::steady_clock::now();
+        swapchain_context replacement = create_swapchain(device, surface, swapchain_configuration, extent, render_pass,
+            swapchain.swapchain);
+        retired_swapchains.retire(swapchain);
+        swapchain = replacement;
+        framebuffer_resized = false;
+
+        // Frame slots of pre-recorded buffers are keyed by image, so the image count has to stay put
+        if (settings.prerecorded && swapchain.images.size() > frame_slots)
+        {
+            throw std::runtime_error("Swapchain image count grew on resize, which --prerecorded cannot follow");
+        }
+
+        // Reallocating the scaled targets waits for the frames rendering into them, which only
+        // happens when the window grows past every size it had before
+        if (scaled && resolution.needs_reallocation(swapchain.extent))
+        {
+            vkWaitForFences(logical_device, frames_in_flight, in_flight_fences.data(), VK_TRUE, UINT64_MAX);
+        }
+
+        if (scaled)
+        {
+            resolution.resize(swapchain.extent);
+        }
+
+        // Entries of the old images are kept, they still guard the frame slots of pre-recorded buffers
+        images_in_flight.resize(swapchain.images.size(), VK_NULL_HANDLE);
+        prerecorded_frames.invalidate_all();
+
+        // Present IDs belong to the retired swapchain
+        pending_presents.clear();
+
+        recreate_times.record(milliseconds_between(recreate_start, std::chrono::steady_clock::now()));
+        recreated_last_frame = true;
+        return true;
+    };
+
     // Main loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && (settings.frame_limit == 0 || frame_number < settings.frame_limit))
     {
+        SAMPLE_TRACE_SCOPE("frame");
+        const auto input_time = std::chrono::steady_clock::now();
+
+        // The resize storm alternates between the requested size and three quarters of it every frame
+        if (frame_number < settings.resize_storm_frames)
+        {
+            const bool shrink = frame_number % 2 == 0;
+            glfwSetWindowSize(window, shrink ? settings.width * 3 / 4 : settings.width,
+                shrink ? settings.height * 3 / 4 : settings.height);
+        }
+
+        const uint64_t poll_trace_start = sample_trace_begin();
         glfwPollEvents();
+        sample_trace_end("poll_events", poll_trace_start);
 
-        // Acquire next image when ready
+        // Swapped in with the device idle, a shader that fails to load or compile keeps the previous pipeline
+        if (shader_changes.changed())
+        {
+            SAMPLE_TRACE_SCOPE("reload_shaders");
+            VkShaderModule reloaded_vertex_shader_module = VK_NULL_HANDLE;
+            VkShaderModule reloaded_fragment_shader_module = VK_NULL_HANDLE;
+
+            try
+            {
+                reloaded_vertex_shader_module = load_shader_module(logical_device, "vert.spv", settings.shader_directory);
+                reloaded_fragment_shader_module = load_shader_module(logical_device, fragment_shader_name,
+                    settings.shader_directory);
+                VkPipeline reloaded_pipeline = create_graphics_pipeline(logical_device, pipeline_cache, render_pass,
+                    pipeline_layout, reloaded_vertex_shader_module, reloaded_fragment_shader_module, specialization);
+
+                vkDeviceWaitIdle(logical_device);
+                vkDestroyPipeline(logical_device, pipeline, nullptr);
+                vkDestroyShaderModule(logical_device, fragment_shader_module, nullptr);
+                vkDestroyShaderModule(logical_device, vertex_shader_module, nullptr);
+
+                pipeline = reloaded_pipeline;
+                vertex_shader_module = reloaded_vertex_shader_module;
+                fragment_shader_module = reloaded_fragment_shader_module;
+                prerecorded_frames.invalidate_all();
+
+                std::cout << "Reloaded shaders from " << settings.shader_directory << "\n";
+            }
+            catch (const std::runtime_error& error)
+            {
+                if (reloaded_fragment_shader_module != VK_NULL_HANDLE)
+                {
+                    vkDestroyShaderModule(logical_device, reloaded_fragment_shader_module, nullptr);
+                }
+
+                if (reloaded_vertex_shader_module != VK_NULL_HANDLE)
+                {
+                    vkDestroyShaderModule(logical_device, reloaded_vertex_shader_module, nullptr);
+                }
+
+                std::cerr << "Shader reload failed, keeping the previous pipeline: " << error.what() << "\n";
+            }
+        }
+
+        const auto frame_start = std::chrono::steady_clock::now();
+
+        if (settings.duration_seconds != 0.0 &&
+            std::chrono::duration<double>(frame_start - loop_start).count() >= settings.duration_seconds)
+        {
+            break;
+        }
+
+        double frame_milliseconds = 0.0;
+
+        if (frame_number > 0)
+        {
+            frame_milliseconds = milliseconds_between(previous_frame_start, frame_start);
+            frame_times.record(frame_milliseconds);
+
+            if (recreated_last_frame)
+            {
+                resize_frame_times.record(frame_milliseconds);
+            }
+        }
+
+        previous_frame_start = frame_start;
+        recreated_last_frame = false;
+
+        // Wait until this frame slot's previous submission has retired
+        VkFence in_flight_fence = in_flight_fences[current_frame];
+        const uint64_t wait_trace_start = sample_trace_begin();
         vkWaitForFences(logical_device, 1, &in_flight_fence, VK_TRUE, UINT64_MAX);
-        vkResetFences(logical_device, 1, &in_flight_fence);
+        sample_trace_end("wait_frame_fence", wait_trace_start);
+        retired_swapchains.waited(current_frame);
+        retired_swapchains.collect();
 
+        // Acquire next image when ready
         uint32_t image_index;
-        vkAcquireNextImageKHR(logical_device, swapchain, UINT64_MAX, image_available_semaphore, VK_NULL_HANDLE, &image_index);
-        vkResetCommandBuffer(command_buffer, 0);
+        const uint64_t acquire_trace_start = sample_trace_begin();
+        const VkResult acquire_result = vkAcquireNextImageKHR(logical_device, swapchain.swapchain, UINT64_MAX,
+            image_available_semaphores[current_frame], VK_NULL_HANDLE, &image_index);
+        sample_trace_end("acquire_image", acquire_trace_start);
+
+        // Nothing was acquired and the semaphore stays unsignalled, so the frame starts over on the new swapchain
+        if (acquire_result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            if (!recreate_swapchain())
+            {
+                break;
+            }
 
-        // Command buffer recording
-        VkCommandBufferBeginInfo command_buffer_begin_info{};
-        command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        command_buffer_begin_info.flags = 0;
-        command_buffer_begin_info.pInheritanceInfo = nullptr;
+            continue;
+        }
+        else if (acquire_result != VK_SUCCESS && acquire_result != VK_SUBOPTIMAL_KHR)
+        {
+            throw std::runtime_error("Unable to acquire swapchain image");
+        }
 
-        if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+        if (settings.latency)
         {
-            throw std::runtime_error("Unable to begin recording command buffer");
+            input_to_acquire.record(milliseconds_between(input_time, std::chrono::steady_clock::now()));
         }
 
-        // Render pass start
-        VkRenderPassBeginInfo render_pass_begin_info{};
-        render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        render_pass_begin_info.renderPass = render_pass;
-        render_pass_begin_info.framebuffer = swapchain_framebuffers[image_index];
-        render_pass_begin_info.renderArea.offset = {0, 0};
-        render_pass_begin_info.renderArea.extent = selected_extent;
+        // An older frame slot may still be rendering into the acquired image
+        if (images_in_flight[image_index] != VK_NULL_HANDLE)
+        {
+            vkWaitForFences(logical_device, 1, &images_in_flight[image_index], VK_TRUE, UINT64_MAX);
+        }
 
-        VkClearValue clear_color = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-        render_pass_begin_info.clearValueCount = 1;
-        render_pass_begin_info.pClearValues = &clear_color;
+        images_in_flight[image_index] = in_flight_fence;
 
-        vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-        vkCmdDraw(command_buffer, 3, 1, 0, 0);
-        vkCmdEndRenderPass(command_buffer);
+        // The waits above retired the last submission using this frame slot
+        const uint32_t frame_slot = settings.prerecorded ? image_index : current_frame;
+        const bool gpu_time_collected = timer.collect(frame_slot);
+        textures.collect(frame_slot);
 
-        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+        if (scale_from_gpu_time && gpu_time_collected)
         {
-            throw std::runtime_error("Unable to record command buffer");
+            resolution.record(timer.latest(timer_pass_main));
         }
+        else if (scaled && !scale_from_gpu_time && frame_number > 0)
+        {
+            resolution.record(frame_milliseconds);
+        }
+
+        fence_wait_times.record(milliseconds_between(frame_start, std::chrono::steady_clock::now()));
+
+        vkResetFences(logical_device, 1, &in_flight_fence);
+
+        // Streamed instances are copied before recording so the upload overlaps the CPU work below
+        scene_geometry frame_geometry = settings.stream_instances ? streamed_geometry[frame_slot] : geometry;
+
+        // The waits above also retired the slot's part of the uniform ring
+        uniforms.reset(frame_slot);
+        static_cast<frame_uniforms*>(uniforms.allocate(frame_slot, sizeof(frame_uniforms), frame_geometry.frame_offset))
+            ->rotation = static_cast<float>(settings.spin * std::chrono::duration<double>(frame_start - loop_start).count());
+        VkSemaphore upload_semaphore = VK_NULL_HANDLE;
+        VkPipelineStageFlags upload_wait_stage = 0;
+        VkCommandBuffer acquire_command_buffer = VK_NULL_HANDLE;
+
+        if (settings.stream_instances)
+        {
+            layout_instances(static_cast<instance_attributes*>(uploader.staging(frame_slot)), geometry.instance_count,
+                geometry.world_scale, frame_number * 0.01f);
+            const bool compute_reads = culling == cull_mode::gpu;
+            uploader.copy(frame_slot, 0, frame_geometry.instances.buffer, 0, geometry.instances.size,
+                compute_reads ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                compute_reads ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+            uploader.submit(frame_slot, upload_semaphore, upload_wait_stage, acquire_command_buffer);
+        }
+
+        // Command buffer recording, or reuse when the image's buffer is still valid
+        const auto cpu_start = std::chrono::steady_clock::now();
+        const uint64_t record_trace_start = sample_trace_begin();
+        VkCommandBuffer command_buffer;
+        VkCommandBuffer cull_command_buffer = VK_NULL_HANDLE;
+        VkCommandBuffer texture_command_buffer = VK_NULL_HANDLE;
+
+        if (culling != cull_mode::none)
+        {
+            frame_geometry = culler.cull(frame_slot, frame_geometry, cull_command_buffer);
+        }
+
+        if (textured)
+        {
+            texture_command_buffer = textures.stream(frame_slot);
+            frame_geometry.texture_set = textures.descriptor_set();
+
+            // Pre-recorded buffers keep binding the set of the levels resident when they were recorded
+            if (settings.prerecorded && texture_command_buffer != VK_NULL_HANDLE)
+            {
+                prerecorded_frames.invalidate_all();
+            }
+        }
+
+        if (settings.prerecorded)
+        {
+            command_buffer = prerecorded_frames.acquire(image_index, [&](VkCommandBuffer buffer) {
+                record_frame(buffer, render_pass, swapchain.framebuffers[image_index], swapchain.extent, pipeline, frame_geometry,
+                    frame_timer, frame_slot);
+            });
+        }
+        else
+        {
+            command_buffer = command_buffers[current_frame];
+            vkResetCommandBuffer(command_buffer, 0);
+
+            // Scaled frames draw into the top left of the slot's target, then blit it over the swapchain image
+            VkFramebuffer framebuffer = swapchain.framebuffers[image_index];
+            VkExtent2D render_extent = swapchain.extent;
+            frame_blit upscale;
+
+            if (scaled)
+            {
+                framebuffer = resolution.framebuffer(frame_slot);
+                render_extent = resolution.render_extent();
+                upscale = resolution.blit(frame_slot, swapchain.images[image_index]);
+            }
+
+            if (settings.record_threads > 0)
+            {
+                const std::vector<VkCommandBuffer>& secondary_command_buffers =
+                    recorder.record(current_frame, render_pass, framebuffer, render_extent, pipeline, frame_geometry);
+                record_frame(command_buffer, render_pass, framebuffer, render_extent, secondary_command_buffers,
+                    frame_timer, frame_slot, nullptr, 0, scaled ? &upscale : nullptr);
+            }
+            else
+            {
+                record_frame(command_buffer, render_pass, framebuffer, render_extent, pipeline, frame_geometry,
+                    frame_timer, frame_slot, nullptr, 0, scaled ? &upscale : nullptr);
+            }
+        }
+
+        sample_trace_end("record_commands", record_trace_start);
 
         // Command submission
         VkSubmitInfo submit_info{};
         submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-        VkSemaphore wait_semaphores[] = {image_available_semaphore};
-        VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submit_info.waitSemaphoreCount = 1;
-        submit_info.pWaitSemaphores = wait_semaphores;
-        submit_info.pWaitDstStageMask = wait_stages;
-        submit_info.commandBufferCount =1 ;
-        submit_info.pCommandBuffers = &command_buffer;
+        std::vector<VkSemaphore> wait_semaphores = {image_available_semaphores[current_frame]};
+        std::vector<VkPipelineStageFlags> wait_stages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        std::vector<VkCommandBuffer> submitted_command_buffers = {command_buffer};
+
+        // The ownership acquire for streamed instances runs ahead of the frame in the same batch
+        if (upload_semaphore != VK_NULL_HANDLE)
+        {
+            wait_semaphores.push_back(upload_semaphore);
+            wait_stages.push_back(upload_wait_stage);
+        }
+
+        if (cull_command_buffer != VK_NULL_HANDLE)
+        {
+            submitted_command_buffers.insert(submitted_command_buffers.begin(), cull_command_buffer);
+        }
+
+        if (texture_command_buffer != VK_NULL_HANDLE)
+        {
+            submitted_command_buffers.insert(submitted_command_buffers.begin(), texture_command_buffer);
+        }
+
+        if (acquire_command_buffer != VK_NULL_HANDLE)
+        {
+            submitted_command_buffers.insert(submitted_command_buffers.begin(), acquire_command_buffer);
+        }
+
+        submit_info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+        submit_info.pWaitSemaphores = wait_semaphores.data();
+        submit_info.pWaitDstStageMask = wait_stages.data();
+        submit_info.commandBufferCount = static_cast<uint32_t>(submitted_command_buffers.size());
+        submit_info.pCommandBuffers = submitted_command_buffers.data();
 
-        VkSemaphore signal_semaphores[] = {render_finished_semaphore};
+        VkSemaphore signal_semaphores[] = {render_finished_semaphores[current_frame]};
         submit_info.signalSemaphoreCount = 1;
         submit_info.pSignalSemaphores = signal_semaphores;
 
+        const uint64_t submit_trace_start = sample_trace_begin();
+
         if (vkQueueSubmit(graphics_queue, 1, &submit_info, in_flight_fence) != VK_SUCCESS)
         {
             throw std::runtime_error("Unable to submit draw call to command buffer");
         }
 
+        sample_trace_end("queue_submit", submit_trace_start);
+
+        retired_swapchains.submitted(current_frame);
+
+        timer.submitted(frame_slot, frame_number);
+
+        cpu_times.record(milliseconds_between(cpu_start, std::chrono::steady_clock::now()));
+
+        if (settings.latency)
+        {
+            input_to_submit.record(milliseconds_between(input_time, std::chrono::steady_clock::now()));
+        }
+
         // Presentation
         VkPresentInfoKHR present_info{};
         present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         present_info.waitSemaphoreCount = 1;
         present_info.pWaitSemaphores = signal_semaphores;
 
-        VkSwapchainKHR swapchains[] = {swapchain};
+        VkSwapchainKHR swapchains[] = {swapchain.swapchain};
         present_info.swapchainCount = 1;
         present_info.pSwapchains = swapchains;
         present_info.pImageIndices = &image_index;
         present_info.pResults = nullptr;
-        vkQueuePresentKHR(present_queue, &present_info);
+
+        // Present IDs let the presentation engine report when this frame reached the display
+        const uint64_t present_id = frame_number + 1;
+        VkPresentIdKHR present_id_info{};
+        present_id_info.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+        present_id_info.swapchainCount = 1;
+        present_id_info.pPresentIds = &present_id;
+
+        if (wait_for_present != nullptr)
+        {
+            present_info.pNext = &present_id_info;
+        }
+
+        const uint64_t present_trace_start = sample_trace_begin();
+        const VkResult present_result = vkQueuePresentKHR(present_queue, &present_info);
+        sample_trace_end("queue_present", present_trace_start);
+
+        if (present_result != VK_SUCCESS && present_result != VK_SUBOPTIMAL_KHR && present_result != VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            throw std::runtime_error("Unable to present swapchain image");
+        }
+
+        if (settings.latency)
+        {
+            input_to_present.record(milliseconds_between(input_time, std::chrono::steady_clock::now()));
+        }
+
+        // Poll, rather than block on, the oldest outstanding presents
+        if (wait_for_present != nullptr)
+        {
+            pending_presents.emplace_back(present_id, input_time);
+
+            while (!pending_presents.empty() &&
+                   wait_for_present(logical_device, swapchain.swapchain, pending_presents.front().first, 0) == VK_SUCCESS)
+            {
+                input_to_display.record(milliseconds_between(pending_presents.front().second, std::chrono::steady_clock::now()));
+                pending_presents.pop_front();
+            }
+        }
+
+        // A suboptimal image was still presented, the swapchain is replaced before the next acquire
+        if ((present_result != VK_SUCCESS || framebuffer_resized) && !recreate_swapchain())
+        {
+            break;
+        }
+
+        // The window title shows the controller's state about twice a second at 60 frames per second
+        if (scaled && frame_number % 30 == 0)
+        {
+            std::ostringstream title;
+            title.precision(2);
+            title << std::fixed << "Vulkan - scale " << resolution.scale() << ", " << resolution.hit_rate() * 100.0
+                  << "% on " << resolution.target() << " ms target";
+            glfwSetWindowTitle(window, title.str().c_str());
+        }
+
+        current_frame = (current_frame + 1) % frames_in_flight;
+        ++frame_number;
+    }
+
+    // Frame time report
+    const double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loop_start).count();
+
+    // Every submission has retired once its frame fence has signalled, the reports and cleanup below rely on it
+    vkWaitForFences(logical_device, frames_in_flight, in_flight_fences.data(), VK_TRUE, UINT64_MAX);
+
+    while (!pending_presents.empty() &&
+           wait_for_present(logical_device, swapchain.swapchain, pending_presents.front().first, 100000000) == VK_SUCCESS)
+    {
+        input_to_display.record(milliseconds_between(pending_presents.front().second, std::chrono::steady_clock::now()));
+        pending_presents.pop_front();
+    }
+
+    std::cout << "Frames in flight: " << frames_in_flight << "\n";
+    std::cout << "Rendered " << frame_number << " frames in " << elapsed_seconds << " s ("
+              << (elapsed_seconds > 0.0 ? frame_number / elapsed_seconds : 0.0) << " frames/s)\n";
+    frame_times.report(std::cout, "Frame time");
+    fence_wait_times.report(std::cout, "Fence wait");
+    cpu_times.report(std::cout, "CPU time");
+
+    if (settings.gpu_timing)
+    {
+        for (uint32_t slot = 0; slot < frame_slots; ++slot)
+        {
+            timer.collect(slot);
+        }
+
+        timer.report(std::cout);
+    }
+
+    if (settings.latency)
+    {
+        input_to_acquire.report(std::cout, "Input to acquire");
+        input_to_submit.report(std::cout, "Input to submit");
+        input_to_present.report(std::cout, "Input to present call");
+
+        if (wait_for_present != nullptr)
+        {
+            input_to_display.report(std::cout, "Input to display");
+        }
+    }
+
+    if (settings.prerecorded)
+    {
+        std::cout << "Pre-recorded command buffers: " << prerecorded_frames.reused_count() << " frames reused, "
+                  << prerecorded_frames.recorded_count() << " re-recorded\n";
+    }
+
+    if (textured)
+    {
+        for (uint32_t slot = 0; slot < frame_slots; ++slot)
+        {
+            textures.collect(slot);
+        }
+
+        textures.report(std::cout);
+    }
+
+    if (culling == cull_mode::cpu)
+    {
+        std::cout << "Culling: " << culler.average_visible() << " of " << geometry.instance_count
+                  << " instances visible per frame\n";
+    }
+
+    if (scaled)
+    {
+        resolution.report(std::cout, scale_from_gpu_time ? "GPU time" : "frame interval");
+    }
+
+    if (recreate_times.count() > 0)
+    {
+        recreate_times.report(std::cout, "Swapchain recreation");
+        resize_frame_times.report(std::cout, "Resize frame time");
+    }
+
+    allocator.report(std::cout);
+
+    // Cleanup, presentation may still be waiting on the last render finished semaphores
+    vkQueueWaitIdle(present_queue);
+
+    for (uint32_t i = 0; i < frames_in_flight; ++i)
+    {
+        vkDestroyFence(logical_device, in_flight_fences[i], nullptr);
+        vkDestroySemaphore(logical_device, render_finished_semaphores[i], nullptr);
+        vkDestroySemaphore(logical_device, image_available_semaphores[i], nullptr);
+    }
+
+    if (settings.stream_instances)
+    {
+        for (scene_geometry& streamed : streamed_geometry)
+        {
+            destroy_buffer(allocator, streamed.instances);
+        }
+
+        uploader.destroy();
     }
 
-    // Cleanup
-    vkDeviceWaitIdle(logical_device);
-    vkDestroyFence(logical_device, in_flight_fence, nullptr);
-    vkDestroySemaphore(logical_device, render_finished_semaphore, nullptr);
-    vkDestroySemaphore(logical_device, image_available_semaphore, nullptr);
+    if (textured)
+    {
+        textures.destroy();
+    }
+
+    culler.destroy();
+    resolution.destroy();
+    uniforms.destroy();
+    recorder.destroy();
+    timer.destroy();
+    prerecorded_frames.destroy();
+    destroy_scene_geometry(allocator, geometry);
     vkDestroyCommandPool(logical_device, command_pool, nullptr);
 
-    for (auto framebuffer : swapchain_framebuffers)
+    retired_swapchains.destroy();
+    destroy_swapchain(logical_device, swapchain);
+
+    if (pipeline_cache != VK_NULL_HANDLE)
     {
-        vkDestroyFramebuffer(logical_device, framebuffer, nullptr);
+        save_pipeline_cache(physical_device, logical_device, pipeline_cache, settings.pipeline_cache_path);
+        vkDestroyPipelineCache(logical_device, pipeline_cache, nullptr);
     }
 
     vkDestroyPipeline(logical_device, pipeline, nullptr);
     vkDestroyPipelineLayout(logical_device, pipeline_layout, nullptr);
-    vkDestroyRenderPass(logical_device, render_pass, nullptr);
-    vkDestroyShaderModule(logical_device, fragment_shader_module, nullptr);
-    vkDestroyShaderModule(logical_device, vertex_shader_module, nullptr);
 
-    for (auto image_view : image_views)
+    if (texture_set_layout != VK_NULL_HANDLE)
     {
-        vkDestroyImageView(logical_device, image_view, nullptr);
+        vkDestroyDescriptorSetLayout(logical_device, texture_set_layout, nullptr);
     }
 
-    vkDestroySwapchainKHR(logical_device, swapchain, nullptr);
+    vkDestroyDescriptorSetLayout(logical_device, uniform_set_layout, nullptr);
+    graph.destroy();
+    vkDestroyShaderModule(logical_device, fragment_shader_module, nullptr);
+    vkDestroyShaderModule(logical_device, vertex_shader_module, nullptr);
+
+    // Last, after everything that may have sub-allocated from it
+    allocator.destroy();
+
     vkDestroySurfaceKHR(instance, surface, nullptr);
     vkDestroyDevice(logical_device, nullptr);
     vkDestroyInstance(instance, nullptr);
@@ -0,0 +1,344 @@
+#include "memory_allocator.hpp"
+
+#include "device.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+memory_allocation linear_arena::allocate(const VkMemoryRequirements& requirements)
+{
+    if ((requirements.memoryTypeBits & (1u << memory_type)) == 0)
+    {
+        throw std::runtime_error("Resource cannot be placed in the linear arena's memory type");
+    }
+
+    const VkDeviceSize offset = align_up(backing.offset + head, requirements.alignment);
+
+    if (offset + requirements.size > backing.offset + backing.size)
+    {
+        throw std::runtime_error("Linear arena exhausted");
+    }
+
+    head = offset + requirements.size - backing.offset;
+
+    memory_allocation allocation;
+    allocation.memory = backing.memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.mapped = backing.mapped != nullptr ? static_cast<char*>(backing.mapped) + (offset - backing.offset) : nullptr;
+    allocation.pool = memory_allocator::arena_pool;
+
+    return allocation;
+}
+
+void linear_arena::reset()
+{
+    head = 0;
+}
+
+VkDeviceSize linear_arena::used() const
+{
+    return head;
+}
+
+VkDeviceSize linear_arena::capacity() const
+{
+    return backing.size;
+}
+
+void memory_allocator::create(VkPhysicalDevice physical, VkDevice device, VkDeviceSize size)
+{
+    physical_device = physical;
+    logical_device = device;
+    block_size = size;
+
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    buffer_image_granularity = properties.limits.bufferImageGranularity;
+
+    pools.assign(memory_properties.memoryTypeCount * 2, {});
+}
+
+void memory_allocator::destroy()
+{
+    for (std::vector<block>& pool : pools)
+    {
+        for (block& source : pool)
+        {
+            vkFreeMemory(logical_device, source.memory, nullptr);
+        }
+    }
+
+    for (const auto& allocation : dedicated_allocations)
+    {
+        vkFreeMemory(logical_device, allocation.second.memory, nullptr);
+    }
+
+    pools.clear();
+    dedicated_allocations.clear();
+}
+
+VkDeviceMemory memory_allocator::allocate_memory(uint32_t memory_type, VkDeviceSize size, void** mapped)
+{
+    VkMemoryAllocateInfo memory_allocate_info{};
+    memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memory_allocate_info.allocationSize = size;
+    memory_allocate_info.memoryTypeIndex = memory_type;
+
+    VkDeviceMemory memory;
+
+    if (vkAllocateMemory(logical_device, &memory_allocate_info, nullptr, &memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate device memory block");
+    }
+
+    // Host visible memory is mapped once and stays mapped until it is freed
+    *mapped = nullptr;
+
+    if (memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (vkMapMemory(logical_device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to map device memory block");
+        }
+    }
+
+    return memory;
+}
+
+bool memory_allocator::allocate_from_block(block& source, const VkMemoryRequirements& requirements,
+    memory_allocation& allocation)
+{
+    // First fit, the leading alignment padding stays with the allocation and returns on free
+    for (auto range = source.free_ranges.begin(); range != source.free_ranges.end(); ++range)
+    {
+        const VkDeviceSize offset = align_up(range->first, requirements.alignment);
+        const VkDeviceSize padding = offset - range->first;
+
+        if (padding + requirements.size > range->second)
+        {
+            continue;
+        }
+
+        const VkDeviceSize range_offset = range->first;
+        const VkDeviceSize range_size = padding + requirements.size;
+        const VkDeviceSize remaining = range->second - range_size;
+
+        source.free_ranges.erase(range);
+
+        if (remaining > 0)
+        {
+            source.free_ranges[range_offset + range_size] = remaining;
+        }
+
+        source.allocations += 1;
+        source.used += requirements.size;
+        source.wasted += padding;
+
+        allocation.memory = source.memory;
+        allocation.offset = offset;
+        allocation.size = requirements.size;
+        allocation.mapped = source.mapped != nullptr ? static_cast<char*>(source.mapped) + offset : nullptr;
+        allocation.range_offset = range_offset;
+        allocation.range_size = range_size;
+
+        return true;
+    }
+
+    return false;
+}
+
+memory_allocation memory_allocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+    resource_kind kind)
+{
+    const uint32_t memory_type = find_memory_type(physical_device, requirements.memoryTypeBits, properties);
+    memory_allocation allocation;
+
+    // Large resources get their own memory instead of wasting most of a block
+    if (requirements.size > block_size / 2)
+    {
+        allocation.memory = allocate_memory(memory_type, requirements.size, &allocation.mapped);
+        allocation.size = requirements.size;
+        allocation.pool = dedicated_pool;
+        dedicated_allocations[allocation.memory] = {allocation.memory, requirements.size};
+
+        return allocation;
+    }
+
+    // Keeping linear and optimal resources in separate blocks satisfies bufferImageGranularity
+    const uint32_t kind_index = buffer_image_granularity > 1 && kind == resource_kind::optimal ? 1 : 0;
+    allocation.pool = memory_type * 2 + kind_index;
+    std::vector<block>& pool = pools[allocation.pool];
+
+    for (uint32_t i = 0; i < pool.size(); ++i)
+    {
+        if (allocate_from_block(pool[i], requirements, allocation))
+        {
+            allocation.block = i;
+            return allocation;
+        }
+    }
+
+    block created;
+    created.memory = allocate_memory(memory_type, block_size, &created.mapped);
+    created.size = block_size;
+    created.free_ranges[0] = block_size;
+    pool.push_back(created);
+
+    allocation.block = static_cast<uint32_t>(pool.size() - 1);
+    allocate_from_block(pool.back(), requirements, allocation);
+
+    return allocation;
+}
+
+void memory_allocator::free(const memory_allocation& allocation)
+{
+    // Arena allocations are released all at once by linear_arena::reset
+    if (allocation.memory == VK_NULL_HANDLE || allocation.pool == arena_pool)
+    {
+        return;
+    }
+
+    if (allocation.pool == dedicated_pool)
+    {
+        vkFreeMemory(logical_device, allocation.memory, nullptr);
+        dedicated_allocations.erase(allocation.memory);
+        return;
+    }
+
+    block& source = pools[allocation.pool][allocation.block];
+    source.allocations -= 1;
+    source.used -= allocation.size;
+    source.wasted -= allocation.range_size - allocation.size;
+
+    // Return the range and merge it with its free neighbours
+    auto range = source.free_ranges.emplace(allocation.range_offset, allocation.range_size).first;
+    auto next = std::next(range);
+
+    if (next != source.free_ranges.end() && range->first + range->second == next->first)
+    {
+        range->second += next->second;
+        source.free_ranges.erase(next);
+    }
+
+    if (range != source.free_ranges.begin())
+    {
+        auto previous = std::prev(range);
+
+        if (previous->first + previous->second == range->first)
+        {
+            previous->second += range->second;
+            source.free_ranges.erase(range);
+        }
+    }
+}
+
+memory_allocation memory_allocator::allocate_buffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+{
+    VkMemoryRequirements memory_requirements;
+    vkGetBufferMemoryRequirements(logical_device, buffer, &memory_requirements);
+
+    memory_allocation allocation = allocate(memory_requirements, properties, resource_kind::linear);
+    vkBindBufferMemory(logical_device, buffer, allocation.memory, allocation.offset);
+
+    return allocation;
+}
+
+memory_allocation memory_allocator::allocate_image(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties)
+{
+    VkMemoryRequirements memory_requirements;
+    vkGetImageMemoryRequirements(logical_device, image, &memory_requirements);
+
+    const resource_kind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? resource_kind::optimal : resource_kind::linear;
+    memory_allocation allocation = allocate(memory_requirements, properties, kind);
+    vkBindImageMemory(logical_device, image, allocation.memory, allocation.offset);
+
+    return allocation;
+}
+
+linear_arena memory_allocator::create_arena(VkDeviceSize size, uint32_t memory_type_bits, VkMemoryPropertyFlags properties)
+{
+    VkMemoryRequirements requirements{};
+    requirements.size = size;
+    requirements.alignment = 256;
+    requirements.memoryTypeBits = memory_type_bits;
+
+    linear_arena arena;
+    arena.memory_type = find_memory_type(physical_device, memory_type_bits, properties);
+    arena.backing = allocate(requirements, properties, resource_kind::linear);
+
+    return arena;
+}
+
+void memory_allocator::destroy_arena(linear_arena& arena)
+{
+    free(arena.backing);
+    arena = linear_arena{};
+}
+
+memory_statistics memory_allocator::statistics() const
+{
+    memory_statistics result;
+    VkDeviceSize free_bytes = 0;
+    VkDeviceSize largest_free_ranges = 0;
+
+    for (const std::vector<block>& pool : pools)
+    {
+        for (const block& source : pool)
+        {
+            result.blocks += 1;
+            result.allocations += source.allocations;
+            result.bytes_reserved += source.size;
+            result.bytes_used += source.used;
+            result.bytes_wasted += source.wasted;
+
+            VkDeviceSize largest_free_range = 0;
+
+            for (const auto& range : source.free_ranges)
+            {
+                free_bytes += range.second;
+                largest_free_range = std::max(largest_free_range, range.second);
+            }
+
+            largest_free_ranges += largest_free_range;
+        }
+    }
+
+    for (const auto& allocation : dedicated_allocations)
+    {
+        result.dedicated_allocations += 1;
+        result.allocations += 1;
+        result.bytes_reserved += allocation.second.size;
+        result.bytes_used += allocation.second.size;
+    }
+
+    if (free_bytes > 0)
+    {
+        result.fragmentation = 1.0 - static_cast<double>(largest_free_ranges) / free_bytes;
+    }
+
+    return result;
+}
+
+void memory_allocator::report(std::ostream& output) const
+{
+    const memory_statistics stats = statistics();
+
+    output << "Device memory: " << stats.blocks << " blocks, " << stats.dedicated_allocations << " dedicated, "
+        << stats.allocations << " allocations, " << stats.bytes_reserved / 1024 << " KiB reserved, "
+        << stats.bytes_used / 1024 << " KiB used, " << stats.bytes_wasted << " bytes wasted, "
+        << stats.fragmentation * 100.0 << "% fragmented\n";
+}
+
+VkDevice memory_allocator::device() const
+{
+    return logical_device;
+}
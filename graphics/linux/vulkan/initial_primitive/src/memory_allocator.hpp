@@ -0,0 +1,135 @@
+#ifndef _MEMORY_ALLOCATOR_HPP_
+#define _MEMORY_ALLOCATOR_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <vector>
+
+// Sub-allocates buffers and images from large device memory blocks instead of calling
+// vkAllocateMemory per resource, which is slow and limited by maxMemoryAllocationCount
+
+// Buffers and linear images may not share a bufferImageGranularity page with optimal images
+enum class resource_kind
+{
+    linear,
+    optimal
+};
+
+struct memory_allocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+
+    // Host address of offset when the memory is host visible, blocks stay mapped for their lifetime
+    void* mapped = nullptr;
+
+    // Bookkeeping for free, pool is dedicated_pool for allocations owning their own memory and
+    // arena_pool for allocations released by linear_arena::reset
+    uint32_t pool = 0;
+    uint32_t block = 0;
+    VkDeviceSize range_offset = 0;
+    VkDeviceSize range_size = 0;
+};
+
+struct memory_statistics
+{
+    uint64_t blocks = 0;
+    uint64_t dedicated_allocations = 0;
+    uint64_t allocations = 0;
+    VkDeviceSize bytes_reserved = 0;
+    VkDeviceSize bytes_used = 0;
+
+    // Alignment padding in front of live allocations
+    VkDeviceSize bytes_wasted = 0;
+
+    // 1 - sum of each block's largest free range / total free bytes, zero when no block has
+    // its free space split
+    double fragmentation = 0.0;
+};
+
+class memory_allocator;
+
+// Bump allocator over a single allocation for transient data, everything is released at once by
+// reset. Only buffers may be placed in an arena.
+class linear_arena
+{
+public:
+    memory_allocation allocate(const VkMemoryRequirements& requirements);
+    void reset();
+
+    VkDeviceSize used() const;
+    VkDeviceSize capacity() const;
+
+private:
+    friend class memory_allocator;
+
+    memory_allocation backing;
+    uint32_t memory_type = 0;
+    VkDeviceSize head = 0;
+};
+
+class memory_allocator
+{
+public:
+    static const uint32_t dedicated_pool = UINT32_MAX;
+    static const uint32_t arena_pool = UINT32_MAX - 1;
+
+    void create(VkPhysicalDevice physical_device, VkDevice logical_device, VkDeviceSize block_size = 64ull << 20);
+    void destroy();
+
+    memory_allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+        resource_kind kind);
+    void free(const memory_allocation& allocation);
+
+    // Allocates and binds memory for the resource
+    memory_allocation allocate_buffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+    memory_allocation allocate_image(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties);
+
+    linear_arena create_arena(VkDeviceSize size, uint32_t memory_type_bits, VkMemoryPropertyFlags properties);
+    void destroy_arena(linear_arena& arena);
+
+    memory_statistics statistics() const;
+    void report(std::ostream& output) const;
+
+    VkDevice device() const;
+
+private:
+    struct block
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+
+        // Free ranges keyed by offset, adjacent ranges are always coalesced
+        std::map<VkDeviceSize, VkDeviceSize> free_ranges;
+        uint64_t allocations = 0;
+        VkDeviceSize used = 0;
+        VkDeviceSize wasted = 0;
+    };
+
+    struct dedicated
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+    };
+
+    bool allocate_from_block(block& source, const VkMemoryRequirements& requirements, memory_allocation& allocation);
+    VkDeviceMemory allocate_memory(uint32_t memory_type, VkDeviceSize size, void** mapped);
+
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    VkDevice logical_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memory_properties{};
+    VkDeviceSize block_size = 0;
+    VkDeviceSize buffer_image_granularity = 1;
+
+    // Indexed by memory type * 2 + resource kind, kinds share pools when the granularity is 1
+    std::vector<std::vector<block>> pools;
+    std::map<VkDeviceMemory, dedicated> dedicated_allocations;
+};
+
+#endif
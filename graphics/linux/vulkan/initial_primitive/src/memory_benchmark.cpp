@@ -0,0 +1,146 @@
+#include "memory_benchmark.hpp"
+
+#include "memory_allocator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// Allocations per round, capped further by maxMemoryAllocationCount for the raw path
+static const uint32_t benchmark_allocations = 4000;
+static const uint32_t benchmark_rounds = 10;
+
+static double microseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run_memory_benchmark(const device_context& device)
+{
+    VkDevice logical_device = device.logical_device;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.physical_device, &properties);
+
+    // Leave headroom for allocations made by the driver and the validation layer
+    const uint32_t count = std::min(benchmark_allocations, properties.limits.maxMemoryAllocationCount / 2);
+
+    // Requirements of a representative vertex buffer, only the size varies between allocations
+    VkBufferCreateInfo buffer_create_info{};
+    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.size = 4096;
+    buffer_create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer probe;
+
+    if (vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &probe) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create benchmark buffer");
+    }
+
+    VkMemoryRequirements probe_requirements;
+    vkGetBufferMemoryRequirements(logical_device, probe, &probe_requirements);
+    vkDestroyBuffer(logical_device, probe, nullptr);
+
+    // Deterministic sizes between 256 bytes and 64 KiB
+    std::vector<VkMemoryRequirements> requirements(count, probe_requirements);
+    uint32_t seed = 1;
+
+    for (VkMemoryRequirements& requirement : requirements)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        requirement.size = 256 + (seed >> 8) % (64 * 1024 - 256);
+    }
+
+    const VkMemoryPropertyFlags memory_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    const uint32_t memory_type = find_memory_type(device.physical_device, probe_requirements.memoryTypeBits, memory_flags);
+
+    // One vkAllocateMemory per resource
+    std::vector<VkDeviceMemory> raw(count);
+    double raw_allocate = 0.0;
+    double raw_free = 0.0;
+
+    for (uint32_t round = 0; round < benchmark_rounds; ++round)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            VkMemoryAllocateInfo memory_allocate_info{};
+            memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            memory_allocate_info.allocationSize = requirements[i].size;
+            memory_allocate_info.memoryTypeIndex = memory_type;
+
+            if (vkAllocateMemory(logical_device, &memory_allocate_info, nullptr, &raw[i]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Unable to allocate benchmark memory");
+            }
+        }
+
+        raw_allocate += microseconds_since(start);
+        start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            vkFreeMemory(logical_device, raw[i], nullptr);
+        }
+
+        raw_free += microseconds_since(start);
+    }
+
+    // Sub-allocated, blocks are kept between rounds as they would be in a running application
+    memory_allocator allocator;
+    allocator.create(device.physical_device, logical_device);
+
+    std::vector<memory_allocation> pooled(count);
+    double pooled_allocate = 0.0;
+    double pooled_free = 0.0;
+
+    for (uint32_t round = 0; round < benchmark_rounds; ++round)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            pooled[i] = allocator.allocate(requirements[i], memory_flags, resource_kind::linear);
+        }
+
+        pooled_allocate += microseconds_since(start);
+        start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            allocator.free(pooled[i]);
+        }
+
+        pooled_free += microseconds_since(start);
+    }
+
+    const double operations = static_cast<double>(count) * benchmark_rounds;
+
+    std::cout << "Memory benchmark: " << count << " allocations x " << benchmark_rounds << " rounds\n";
+    std::cout << "vkAllocateMemory: " << raw_allocate / operations << " us/allocate, "
+              << raw_free / operations << " us/free\n";
+    std::cout << "memory_allocator: " << pooled_allocate / operations << " us/allocate, "
+              << pooled_free / operations << " us/free\n";
+
+    // Free every other allocation and refill with larger ones to show fragmentation
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        pooled[i] = allocator.allocate(requirements[i], memory_flags, resource_kind::linear);
+    }
+
+    for (uint32_t i = 0; i < count; i += 2)
+    {
+        allocator.free(pooled[i]);
+        VkMemoryRequirements larger = requirements[i];
+        larger.size *= 2;
+        pooled[i] = allocator.allocate(larger, memory_flags, resource_kind::linear);
+    }
+
+    allocator.report(std::cout);
+    allocator.destroy();
+}
@@ -0,0 +1,10 @@
+#ifndef _MEMORY_BENCHMARK_HPP_
+#define _MEMORY_BENCHMARK_HPP_
+
+#include "device.hpp"
+
+// Times memory_allocator against one vkAllocateMemory per resource and reports the allocator's
+// fragmentation after a mixed allocate and free pattern
+void run_memory_benchmark(const device_context& device);
+
+#endif
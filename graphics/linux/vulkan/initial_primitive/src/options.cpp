@@ -0,0 +1,323 @@
+#include "options.hpp"
+
+#include <stdexcept>
+#include <string>
+
+static uint64_t parse_unsigned(const std::string& name, const std::string& value)
+{
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+    {
+        throw std::runtime_error("Expected a non-negative integer for " + name);
+    }
+
+    return std::stoull(value);
+}
+
+static double parse_seconds(const std::string& name, const std::string& value)
+{
+    if (value.empty() || value.find_first_not_of("0123456789.") != std::string::npos)
+    {
+        throw std::runtime_error("Expected a non-negative number of seconds for " + name);
+    }
+
+    return std::stod(value);
+}
+
+static float parse_scale(const std::string& name, const std::string& value)
+{
+    if (value.empty() || value.find_first_not_of("0123456789.") != std::string::npos || std::stof(value) <= 0.0f)
+    {
+        throw std::runtime_error("Expected a positive number for " + name);
+    }
+
+    return std::stof(value);
+}
+
+static void parse_color(const std::string& name, const std::string& value, float* color)
+{
+    size_t start = 0;
+
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        const size_t end = channel < 2 ? value.find(',', start) : value.size();
+        const std::string component = end == std::string::npos ? "" : value.substr(start, end - start);
+
+        if (component.empty() || component.find_first_not_of("0123456789.") != std::string::npos || std::stof(component) > 1.0f)
+        {
+            throw std::runtime_error("Expected three comma separated values between 0 and 1 for " + name);
+        }
+
+        color[channel] = std::stof(component);
+        start = end + 1;
+    }
+}
+
+options parse_options(int argc, char** argv)
+{
+    options parsed{};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        const size_t separator = argument.find('=');
+        const std::string name = argument.substr(0, separator);
+        const std::string value = separator == std::string::npos ? "" : argument.substr(separator + 1);
+
+        if (name == "--frames-in-flight")
+        {
+            parsed.frames_in_flight = static_cast<uint32_t>(parse_unsigned(name, value));
+
+            if (parsed.frames_in_flight == 0)
+            {
+                throw std::runtime_error("At least one frame must be allowed in flight");
+            }
+        }
+        else if (name == "--frames")
+        {
+            parsed.frame_limit = parse_unsigned(name, value);
+        }
+        else if (name == "--duration")
+        {
+            parsed.duration_seconds = parse_seconds(name, value);
+        }
+        else if (name == "--width")
+        {
+            parsed.width = static_cast<uint32_t>(parse_unsigned(name, value));
+        }
+        else if (name == "--height")
+        {
+            parsed.height = static_cast<uint32_t>(parse_unsigned(name, value));
+        }
+        else if (name == "--headless")
+        {
+            parsed.headless = true;
+        }
+        else if (name == "--present-mode")
+        {
+            parsed.present_mode = value;
+        }
+        else if (name == "--swapchain-images")
+        {
+            parsed.swapchain_images = static_cast<uint32_t>(parse_unsigned(name, value));
+        }
+        else if (name == "--uncapped")
+        {
+            parsed.uncapped = true;
+        }
+        else if (name == "--resize-storm")
+        {
+            parsed.resize_storm_frames = parse_unsigned(name, value);
+        }
+        else if (name == "--dynamic-resolution")
+        {
+            parsed.target_frame_milliseconds = parse_scale(name, value);
+            parsed.gpu_timing = true;
+        }
+        else if (name == "--min-render-scale")
+        {
+            parsed.min_render_scale = parse_scale(name, value);
+
+            if (parsed.min_render_scale > 1.0f)
+            {
+                throw std::runtime_error("The minimum render scale must not exceed 1");
+            }
+        }
+        else if (name == "--latency")
+        {
+            parsed.latency = true;
+        }
+        else if (name == "--instances")
+        {
+            parsed.instances = static_cast<uint32_t>(parse_unsigned(name, value));
+
+            if (parsed.instances == 0)
+            {
+                throw std::runtime_error("At least one instance must be drawn");
+            }
+        }
+        else if (name == "--draw-per-object")
+        {
+            parsed.draw_per_object = true;
+        }
+        else if (name == "--record-threads")
+        {
+            parsed.record_threads = static_cast<uint32_t>(parse_unsigned(name, value));
+        }
+        else if (name == "--record-benchmark")
+        {
+            parsed.record_benchmark = true;
+        }
+        else if (name == "--uniform-benchmark")
+        {
+            parsed.uniform_benchmark_draws = static_cast<uint32_t>(parse_unsigned(name, value));
+        }
+        else if (name == "--pipeline-benchmark")
+        {
+            parsed.pipeline_benchmark_permutations = static_cast<uint32_t>(parse_unsigned(name, value));
+        }
+        else if (name == "--cull")
+        {
+            if (value != "none" && value != "cpu" && value != "gpu")
+            {
+                throw std::runtime_error("Expected none, cpu or gpu for " + name);
+            }
+
+            parsed.cull = value;
+        }
+        else if (name == "--world-scale")
+        {
+            parsed.world_scale = parse_scale(name, value);
+        }
+        else if (name == "--stream-instances")
+        {
+            parsed.stream_instances = true;
+        }
+        else if (name == "--gpu-timing")
+        {
+            parsed.gpu_timing = true;
+        }
+        else if (name == "--gpu-timing-csv")
+        {
+            parsed.gpu_timing = true;
+            parsed.gpu_timing_csv = value;
+        }
+        else if (name == "--flat-color")
+        {
+            parsed.flat_color = true;
+            parse_color(name, value, parsed.color);
+        }
+        else if (name == "--spin")
+        {
+            parsed.spin = parse_scale(name, value);
+        }
+        else if (name == "--tint")
+        {
+            parse_color(name, value, parsed.tint);
+        }
+        else if (name == "--texture")
+        {
+            parsed.texture_path = value;
+        }
+        else if (name == "--texture-budget")
+        {
+            parsed.texture_budget_kib = parse_unsigned(name, value);
+
+            if (parsed.texture_budget_kib == 0)
+            {
+                throw std::runtime_error("The texture budget must be non-zero");
+            }
+        }
+        else if (name == "--post-passes")
+        {
+            parsed.post_passes = static_cast<uint32_t>(parse_unsigned(name, value));
+        }
+        else if (name == "--post-sampled")
+        {
+            parsed.post_sampled = true;
+        }
+        else if (name == "--shader-dir")
+        {
+            parsed.shader_directory = value;
+        }
+        else if (name == "--prerecorded")
+        {
+            parsed.prerecorded = true;
+        }
+        else if (name == "--memory-benchmark")
+        {
+            parsed.memory_benchmark = true;
+        }
+        else if (name == "--cull-benchmark")
+        {
+            parsed.cull_benchmark = true;
+        }
+        else if (name == "--compute-benchmark")
+        {
+            parsed.compute_benchmark_mib = value.empty() ? 1024 : parse_unsigned(name, value);
+
+            if (parsed.compute_benchmark_mib == 0)
+            {
+                throw std::runtime_error("--compute-benchmark needs a non-zero size in MiB");
+            }
+        }
+        else if (name == "--output")
+        {
+            parsed.output_path = value;
+        }
+        else if (name == "--pipeline-cache")
+        {
+            parsed.pipeline_cache_path = value;
+        }
+        else if (name == "--no-pipeline-cache")
+        {
+            parsed.pipeline_cache_path.clear();
+        }
+        else if (name == "--trace")
+        {
+            parsed.trace_path = value;
+        }
+        else if (name == "--no-validation")
+        {
+            parsed.validation = false;
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option: " + argument);
+        }
+    }
+
+    if (parsed.width == 0 || parsed.height == 0)
+    {
+        throw std::runtime_error("Framebuffer dimensions must be non-zero");
+    }
+
+    if (parsed.prerecorded && parsed.record_threads > 0)
+    {
+        throw std::runtime_error("--prerecorded and --record-threads are mutually exclusive");
+    }
+
+    // CPU culling rewrites the draw count every frame, which prerecorded buffers cannot pick up
+    if (parsed.cull == "cpu" && (parsed.prerecorded || parsed.stream_instances))
+    {
+        throw std::runtime_error("--cull=cpu cannot be combined with --prerecorded or --stream-instances");
+    }
+
+    // Every culling mode has to be able to run with the remaining options
+    if (parsed.cull_benchmark && (parsed.cull != "none" || parsed.prerecorded || parsed.stream_instances ||
+        parsed.record_threads > 0))
+    {
+        throw std::runtime_error("--cull-benchmark cannot be combined with --cull, --prerecorded, --stream-instances or --record-threads");
+    }
+
+    // Indirect draws are recorded inline, the secondary buffers split instances between workers
+    if (parsed.cull == "gpu" && parsed.record_threads > 0)
+    {
+        throw std::runtime_error("--cull=gpu and --record-threads are mutually exclusive");
+    }
+
+    // The benchmark pipeline only binds the frame uniforms
+    if (parsed.uniform_benchmark_draws > 0 && !parsed.texture_path.empty())
+    {
+        throw std::runtime_error("--uniform-benchmark cannot be combined with --texture");
+    }
+
+    // Swapchain images are recreated on resize while graph images are sized once
+    if (parsed.post_passes > 0 && !parsed.headless)
+    {
+        throw std::runtime_error("--post-passes requires --headless");
+    }
+
+    // The benchmarks record the scene render pass alone, without the post passes merged into it
+    if (parsed.post_passes > 0 && (parsed.record_benchmark || parsed.uniform_benchmark_draws > 0))
+    {
+        throw std::runtime_error("--post-passes cannot be combined with --record-benchmark or --uniform-benchmark");
+    }
+
+    // Scaled frames are blitted into the swapchain, and the render area changes from frame to frame
+    if (parsed.target_frame_milliseconds > 0.0 && (parsed.headless || parsed.prerecorded))
+    {
+        throw std::runtime_error("--dynamic-resolution cannot be combined with --headless or --prerecorded");
+    }
+
+    return parsed;
+}
@@ -0,0 +1,141 @@
+#ifndef _OPTIONS_HPP_
+#define _OPTIONS_HPP_
+
+#include <cstdint>
+#include <string>
+
+// Command line configurable behaviour of the sample
+struct options
+{
+    // Number of frames the CPU may record ahead of the GPU
+    uint32_t frames_in_flight = 2;
+
+    // Number of frames to render before exiting, zero runs until the window closes
+    uint64_t frame_limit = 0;
+
+    // Seconds to render before exiting, zero disables the limit
+    double duration_seconds = 0.0;
+
+    // Size of the window or offscreen framebuffer
+    uint32_t width = 800;
+    uint32_t height = 600;
+
+    // Swapchain present mode by name (fifo, fifo_relaxed, mailbox, immediate), empty prefers mailbox
+    std::string present_mode;
+
+    // Requested swapchain minImageCount, zero uses the surface minimum
+    uint32_t swapchain_images = 0;
+
+    // Prefers present modes that never wait for vertical blank, for throughput measurements
+    bool uncapped = false;
+
+    // Resizes the window every frame for this many frames, alternating between the requested size
+    // and three quarters of it, to measure the frame time cost of swapchain recreation
+    uint64_t resize_storm_frames = 0;
+
+    // Frame time in milliseconds the windowed path scales its render resolution to meet, zero
+    // renders at the swapchain resolution. Implies gpu_timing, the frame interval is used when
+    // the queue has no timestamps.
+    double target_frame_milliseconds = 0.0;
+
+    // Lowest fraction of the swapchain width and height dynamic resolution may render at
+    float min_render_scale = 0.5f;
+
+    // Records input to present timestamps, using VK_KHR_present_wait when available
+    bool latency = false;
+
+    // Number of triangle instances drawn each frame
+    uint32_t instances = 1;
+
+    // Issues one draw call per instance instead of a single instanced draw
+    bool draw_per_object = false;
+
+    // Worker threads recording secondary command buffers, zero records inline on the main thread
+    uint32_t record_threads = 0;
+
+    // In headless mode, times recording inline and with 1, 2, 4, ... threads before rendering
+    bool record_benchmark = false;
+
+    // In headless mode, times this many per draw updates through push constants, dynamic uniform
+    // buffer offsets and descriptor rewrites before rendering, zero skips the benchmark
+    uint32_t uniform_benchmark_draws = 0;
+
+    // In headless mode, compiles this many pipeline permutations serially and on worker threads
+    // before rendering and reports both, zero skips the benchmark
+    uint32_t pipeline_benchmark_permutations = 0;
+
+    // Instance culling by name (none, cpu, gpu), gpu compacts instances in a compute pass and draws indirectly
+    std::string cull = "none";
+
+    // Spreads the instance grid over this many framebuffer widths, so culling has work to do above 1
+    float world_scale = 1.0f;
+
+    // Rewrites the instance buffer every frame through the transfer queue
+    bool stream_instances = false;
+
+    // Writes GPU timestamps around each pass and reports rolling GPU time statistics
+    bool gpu_timing = false;
+
+    // CSV file receiving every per-frame GPU pass time, implies gpu_timing
+    std::string gpu_timing_csv;
+
+    // Specializes the fragment shader to draw every instance in color instead of its own color
+    bool flat_color = false;
+    float color[3] = {1.0f, 1.0f, 1.0f};
+
+    // Turns every instance around its center at this many radians per second through the frame uniforms
+    float spin = 0.0f;
+
+    // Multiplies every fragment by this color, pushed as a constant with each draw
+    float tint[3] = {1.0f, 1.0f, 1.0f};
+
+    // KTX2 texture with precomputed mips streamed in coarsest level first, empty draws untextured
+    std::string texture_path;
+
+    // Most texture bytes uploaded per frame, in KiB
+    uint64_t texture_budget_kib = 1024;
+
+    // In headless mode, vignette passes run by the render graph after the scene, each reading the
+    // previous pass as an input attachment so all of them merge into one render pass
+    uint32_t post_passes = 0;
+
+    // Reads the previous pass through a sampler instead, which splits every post pass into its own
+    // render pass and lets the intermediate images share memory
+    bool post_sampled = false;
+
+    // Directory SPIR-V is loaded from at startup, empty uses the shaders built into the executable
+    std::string shader_directory;
+
+    // Records one command buffer per framebuffer up front and resubmits it every frame
+    bool prerecorded = false;
+
+    // Renders into an offscreen image without creating a window or surface
+    bool headless = false;
+
+    // Compares the device memory sub-allocator with raw vkAllocateMemory and exits
+    bool memory_benchmark = false;
+
+    // Renders headless without culling, with CPU culling and with GPU culling and compares them
+    bool cull_benchmark = false;
+
+    // Runs the compute kernels over buffers of up to this many MiB, reports their throughput and
+    // exits, zero skips the benchmark
+    uint64_t compute_benchmark_mib = 0;
+
+    // PPM file the last headless frame is written to, empty skips the readback
+    std::string output_path;
+
+    // File the pipeline cache is loaded from and saved to, empty disables the cache
+    std::string pipeline_cache_path = "pipeline_cache.bin";
+
+    // Chrome trace event JSON file the traced phases are written to at exit, empty falls back to
+    // the SAMPLE_TRACE environment variable and leaves tracing off when that is unset too
+    std::string trace_path;
+
+    // Enables the Khronos validation layer, which must be disabled for meaningful timings
+    bool validation = true;
+};
+
+options parse_options(int argc, char** argv);
+
+#endif
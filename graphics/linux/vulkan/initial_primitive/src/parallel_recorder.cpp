@@ -0,0 +1,269 @@
+#include "parallel_recorder.hpp"
+
+#include "frame_statistics.hpp"
+#include "renderer.hpp"
+#include "sample_trace.h"
+
+#include <chrono>
+#include <stdexcept>
+
+// Frames recorded per configuration by benchmark_recording
+static const uint32_t benchmark_frames = 100;
+
+void parallel_recorder::create(VkDevice device, uint32_t queue_family_index, uint32_t thread_count, uint32_t slot_count)
+{
+    logical_device = device;
+    workers = thread_count;
+    command_pools.resize(static_cast<size_t>(slot_count) * workers);
+    command_buffers.resize(command_pools.size());
+
+    // Pools are reset as a whole each time their slot is recorded again
+    for (size_t i = 0; i < command_pools.size(); ++i)
+    {
+        VkCommandPoolCreateInfo command_pool_create_info{};
+        command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        command_pool_create_info.queueFamilyIndex = queue_family_index;
+
+        if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pools[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create worker command pool");
+        }
+
+        VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+        command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        command_buffer_allocation_info.commandPool = command_pools[i];
+        command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        command_buffer_allocation_info.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, &command_buffers[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to allocate secondary command buffer");
+        }
+    }
+
+    recorded.resize(workers);
+
+    for (uint32_t worker = 0; worker < workers; ++worker)
+    {
+        threads.emplace_back(&parallel_recorder::worker_main, this, worker);
+    }
+}
+
+void parallel_recorder::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    work_ready.notify_all();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Destroying a pool frees its command buffers
+    for (VkCommandPool command_pool : command_pools)
+    {
+        vkDestroyCommandPool(logical_device, command_pool, nullptr);
+    }
+
+    threads.clear();
+    command_pools.clear();
+    command_buffers.clear();
+    recorded.clear();
+    stopping = false;
+}
+
+const std::vector<VkCommandBuffer>& parallel_recorder::record(uint32_t slot, VkRenderPass render_pass,
+    VkFramebuffer framebuffer, VkExtent2D extent, VkPipeline pipeline, const scene_geometry& geometry)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    job_slot = slot;
+    job_render_pass = render_pass;
+    job_framebuffer = framebuffer;
+    job_extent = extent;
+    job_pipeline = pipeline;
+    job_geometry = &geometry;
+    failure = nullptr;
+    remaining = workers;
+    generation += 1;
+
+    work_ready.notify_all();
+    work_done.wait(lock, [this] { return remaining == 0; });
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+
+    return recorded;
+}
+
+uint32_t parallel_recorder::thread_count() const
+{
+    return workers;
+}
+
+void parallel_recorder::worker_main(uint32_t worker)
+{
+    sample_trace_thread_name("recorder");
+    uint64_t seen = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_ready.wait(lock, [&] { return stopping || generation != seen; });
+
+            if (stopping)
+            {
+                return;
+            }
+
+            seen = generation;
+        }
+
+        // The job fields are only written while every worker is idle
+        std::exception_ptr error;
+
+        try
+        {
+            SAMPLE_TRACE_SCOPE("record_secondary");
+            record_range(worker);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (error)
+        {
+            failure = error;
+        }
+
+        if (--remaining == 0)
+        {
+            work_done.notify_one();
+        }
+    }
+}
+
+void parallel_recorder::record_range(uint32_t worker)
+{
+    const size_t index = static_cast<size_t>(job_slot) * workers + worker;
+    VkCommandBuffer command_buffer = command_buffers[index];
+
+    vkResetCommandPool(logical_device, command_pools[index], 0);
+
+    // Contiguous instance range, so draw order matches single threaded recording
+    const uint64_t instance_count = job_geometry->instance_count;
+    const uint32_t first_instance = static_cast<uint32_t>(instance_count * worker / workers);
+    const uint32_t last_instance = static_cast<uint32_t>(instance_count * (worker + 1) / workers);
+
+    VkCommandBufferInheritanceInfo inheritance_info{};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = job_render_pass;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = job_framebuffer;
+
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    command_buffer_begin_info.pInheritanceInfo = &inheritance_info;
+
+    if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to begin recording secondary command buffer");
+    }
+
+    if (last_instance > first_instance)
+    {
+        record_draws(command_buffer, job_pipeline, job_extent, *job_geometry, first_instance, last_instance - first_instance);
+    }
+
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to record secondary command buffer");
+    }
+
+    recorded[worker] = command_buffer;
+}
+
+void benchmark_recording(VkDevice logical_device, uint32_t queue_family_index, VkRenderPass render_pass,
+    VkFramebuffer framebuffer, VkExtent2D extent, VkPipeline pipeline, const scene_geometry& geometry,
+    uint32_t max_threads, std::ostream& output)
+{
+    // Primary command buffer the frames are assembled in, never submitted
+    VkCommandPool command_pool;
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    command_pool_create_info.queueFamilyIndex = queue_family_index;
+
+    if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create benchmark command pool");
+    }
+
+    VkCommandBuffer command_buffer;
+    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocation_info.commandPool = command_pool;
+    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocation_info.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, &command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate benchmark command buffer");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t frame = 0; frame < benchmark_frames; ++frame)
+    {
+        vkResetCommandPool(logical_device, command_pool, 0);
+        record_frame(command_buffer, render_pass, framebuffer, extent, pipeline, geometry);
+    }
+
+    const double inline_milliseconds = milliseconds_between(start, std::chrono::steady_clock::now());
+    output << "Recording inline: " << inline_milliseconds / benchmark_frames << " ms/frame\n";
+
+    // Powers of two, ending on every core even when their count is not one
+    std::vector<uint32_t> thread_counts;
+
+    for (uint32_t threads = 1; threads < max_threads; threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+
+    thread_counts.push_back(max_threads);
+
+    for (const uint32_t threads : thread_counts)
+    {
+        parallel_recorder recorder;
+        recorder.create(logical_device, queue_family_index, threads, 1);
+
+        start = std::chrono::steady_clock::now();
+
+        for (uint32_t frame = 0; frame < benchmark_frames; ++frame)
+        {
+            vkResetCommandPool(logical_device, command_pool, 0);
+            record_frame(command_buffer, render_pass, framebuffer, extent,
+                recorder.record(0, render_pass, framebuffer, extent, pipeline, geometry));
+        }
+
+        const double milliseconds = milliseconds_between(start, std::chrono::steady_clock::now());
+        output << "Recording with " << threads << " threads: " << milliseconds / benchmark_frames << " ms/frame, "
+               << inline_milliseconds / milliseconds << "x inline\n";
+
+        recorder.destroy();
+    }
+
+    vkDestroyCommandPool(logical_device, command_pool, nullptr);
+}
@@ -0,0 +1,70 @@
+#ifndef _PARALLEL_RECORDER_HPP_
+#define _PARALLEL_RECORDER_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "geometry.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Worker threads recording a frame's draws into secondary command buffers. Every worker owns one
+// command pool per slot, so pools are never shared between threads and a slot's pools are only
+// reset once the GPU has finished the submission that last used them.
+class parallel_recorder
+{
+public:
+    void create(VkDevice logical_device, uint32_t queue_family_index, uint32_t thread_count, uint32_t slot_count);
+    void destroy();
+
+    // Splits the instances into one contiguous range per worker and blocks until every range is
+    // recorded. The returned buffers stay valid until the slot is recorded again.
+    const std::vector<VkCommandBuffer>& record(uint32_t slot, VkRenderPass render_pass, VkFramebuffer framebuffer,
+        VkExtent2D extent, VkPipeline pipeline, const scene_geometry& geometry);
+
+    uint32_t thread_count() const;
+
+private:
+    void worker_main(uint32_t worker);
+    void record_range(uint32_t worker);
+
+    VkDevice logical_device = VK_NULL_HANDLE;
+    uint32_t workers = 0;
+
+    // Indexed by slot * workers + worker
+    std::vector<VkCommandPool> command_pools;
+    std::vector<VkCommandBuffer> command_buffers;
+
+    // Secondary command buffers of the slot last recorded, in draw order
+    std::vector<VkCommandBuffer> recorded;
+
+    // Work shared with the workers, guarded by mutex
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    uint64_t generation = 0;
+    uint32_t remaining = 0;
+    bool stopping = false;
+    std::exception_ptr failure;
+
+    uint32_t job_slot = 0;
+    VkRenderPass job_render_pass = VK_NULL_HANDLE;
+    VkFramebuffer job_framebuffer = VK_NULL_HANDLE;
+    VkExtent2D job_extent{};
+    VkPipeline job_pipeline = VK_NULL_HANDLE;
+    const scene_geometry* job_geometry = nullptr;
+};
+
+// Records the same frame repeatedly on the calling thread and then with 1, 2, 4, ... workers up to
+// max_threads, printing the recording time of each. Nothing is submitted.
+void benchmark_recording(VkDevice logical_device, uint32_t queue_family_index, VkRenderPass render_pass,
+    VkFramebuffer framebuffer, VkExtent2D extent, VkPipeline pipeline, const scene_geometry& geometry,
+    uint32_t max_threads, std::ostream& output);
+
+#endif
@@ -0,0 +1,412 @@
+#include "pipeline_builder.hpp"
+
+#include "frame_statistics.hpp"
+#include "sample_trace.h"
+
+#include <chrono>
+#include <stdexcept>
+
+void pipeline_builder::create(VkDevice device, VkPipelineCache cache, VkRenderPass pass, VkPipelineLayout layout,
+    VkShaderModule vertex_module, VkShaderModule fragment_module, uint32_t thread_count, bool use_derivatives)
+{
+    logical_device = device;
+    pipeline_cache = cache;
+    render_pass = pass;
+    pipeline_layout = layout;
+    vertex_shader_module = vertex_module;
+    fragment_shader_module = fragment_module;
+    derivatives = use_derivatives;
+
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        threads.emplace_back(&pipeline_builder::worker_main, this);
+    }
+}
+
+void pipeline_builder::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    work_ready.notify_all();
+
+    // Workers drain the queue before they exit
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (permutation_entry& entry : permutations)
+    {
+        if (entry.pipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(logical_device, entry.pipeline, nullptr);
+        }
+    }
+
+    threads.clear();
+    permutations.clear();
+    queue.clear();
+    stopping = false;
+}
+
+pipeline_builder::handle pipeline_builder::add(const pipeline_specialization& specialization, const pipeline_state& state)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    permutation_entry entry;
+    entry.specialization = specialization;
+    entry.state = state;
+    permutations.push_back(entry);
+
+    return static_cast<handle>(permutations.size() - 1);
+}
+
+void pipeline_builder::queue_locked(handle permutation)
+{
+    if (permutation >= permutations.size())
+    {
+        throw std::runtime_error("Unknown pipeline permutation");
+    }
+
+    if (permutations[permutation].progress != status::idle)
+    {
+        return;
+    }
+
+    // The base goes ahead of its derivatives, so a worker waiting on it never waits on queued work
+    if (derivatives && permutation != 0)
+    {
+        queue_locked(0);
+    }
+
+    permutations[permutation].progress = status::queued;
+    queue.push_back(permutation);
+    work_ready.notify_one();
+}
+
+void pipeline_builder::request(handle permutation)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    queue_locked(permutation);
+}
+
+void pipeline_builder::request_all()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (handle permutation = 0; permutation < permutations.size(); ++permutation)
+    {
+        queue_locked(permutation);
+    }
+}
+
+bool pipeline_builder::ready(handle permutation)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return permutation < permutations.size() && permutations[permutation].progress == status::ready;
+}
+
+VkPipeline pipeline_builder::pipeline(handle permutation)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    queue_locked(permutation);
+
+    return permutations[permutation].progress == status::ready ? permutations[permutation].pipeline : VK_NULL_HANDLE;
+}
+
+VkPipeline pipeline_builder::wait(handle permutation)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    queue_locked(permutation);
+
+    // Without workers the caller compiles the permutation itself
+    if (threads.empty())
+    {
+        lock.unlock();
+
+        while (true)
+        {
+            handle next;
+
+            {
+                std::lock_guard<std::mutex> queue_lock(mutex);
+
+                if (queue.empty())
+                {
+                    break;
+                }
+
+                next = queue.front();
+                queue.pop_front();
+            }
+
+            compile(next);
+        }
+
+        lock.lock();
+    }
+
+    const permutation_entry& entry = permutations[permutation];
+    work_done.wait(lock, [&] { return entry.progress == status::ready || entry.progress == status::failed; });
+
+    if (entry.failure)
+    {
+        std::rethrow_exception(entry.failure);
+    }
+
+    return entry.pipeline;
+}
+
+void pipeline_builder::wait_all()
+{
+    handle count;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        count = static_cast<handle>(permutations.size());
+    }
+
+    // Every requested permutation finishes before the first failure is rethrown
+    std::exception_ptr failure;
+
+    for (handle permutation = 0; permutation < count; ++permutation)
+    {
+        bool requested;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requested = permutations[permutation].progress != status::idle;
+        }
+
+        try
+        {
+            if (requested)
+            {
+                wait(permutation);
+            }
+        }
+        catch (...)
+        {
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+        }
+    }
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+uint32_t pipeline_builder::thread_count() const
+{
+    return static_cast<uint32_t>(threads.size());
+}
+
+void pipeline_builder::worker_main()
+{
+    sample_trace_thread_name("pipeline_builder");
+
+    while (true)
+    {
+        handle next;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_ready.wait(lock, [this] { return stopping || !queue.empty(); });
+
+            if (queue.empty())
+            {
+                return;
+            }
+
+            next = queue.front();
+            queue.pop_front();
+        }
+
+        compile(next);
+    }
+}
+
+void pipeline_builder::compile(handle permutation)
+{
+    pipeline_specialization specialization;
+    pipeline_state state;
+    VkPipelineCreateFlags flags = 0;
+    VkPipeline base_pipeline = VK_NULL_HANDLE;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // Derivatives need their base finished, a failed base leaves them as plain pipelines
+        if (derivatives && permutation == 0)
+        {
+            flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+        }
+        else if (derivatives)
+        {
+            const permutation_entry& base = permutations[0];
+            work_done.wait(lock, [&] { return base.progress == status::ready || base.progress == status::failed; });
+
+            if (base.progress == status::ready)
+            {
+                flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+                base_pipeline = base.pipeline;
+            }
+        }
+
+        specialization = permutations[permutation].specialization;
+        state = permutations[permutation].state;
+    }
+
+    VkPipeline created = VK_NULL_HANDLE;
+    std::exception_ptr failure;
+
+    try
+    {
+        created = create_graphics_pipeline(logical_device, pipeline_cache, render_pass, pipeline_layout,
+            vertex_shader_module, fragment_shader_module, specialization, state, flags, base_pipeline);
+    }
+    catch (...)
+    {
+        failure = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        permutation_entry& entry = permutations[permutation];
+        entry.pipeline = created;
+        entry.failure = failure;
+        entry.progress = failure ? status::failed : status::ready;
+    }
+
+    work_done.notify_all();
+}
+
+// Permutation i of the benchmark, every one distinct so the cache never returns an earlier pipeline
+static void benchmark_permutation(uint32_t i, uint32_t permutation_count, pipeline_specialization& specialization,
+    pipeline_state& state)
+{
+    specialization.flat_color = i % 2 == 1;
+    specialization.color[0] = static_cast<float>(i) / permutation_count;
+    specialization.color[1] = static_cast<float>(i % 5) / 4.0f;
+    specialization.color[2] = static_cast<float>(i % 3) / 2.0f;
+    state.topology = i % 3 == 2 ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    state.alpha_blend = (i / 2) % 2 == 1;
+}
+
+static VkPipelineCache create_empty_pipeline_cache(VkDevice logical_device)
+{
+    VkPipelineCacheCreateInfo pipeline_cache_create_info{};
+    pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    VkPipelineCache pipeline_cache;
+
+    if (vkCreatePipelineCache(logical_device, &pipeline_cache_create_info, nullptr, &pipeline_cache) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create pipeline cache");
+    }
+
+    return pipeline_cache;
+}
+
+void benchmark_pipeline_compilation(VkDevice logical_device, VkRenderPass render_pass, VkPipelineLayout pipeline_layout,
+    VkShaderModule vertex_shader_module, VkShaderModule fragment_shader_module, uint32_t permutation_count,
+    uint32_t max_threads, std::ostream& output)
+{
+    // Serial, one vkCreateGraphicsPipelines call after another as at startup
+    VkPipelineCache pipeline_cache = create_empty_pipeline_cache(logical_device);
+    std::vector<VkPipeline> pipelines;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < permutation_count; ++i)
+    {
+        pipeline_specialization specialization;
+        pipeline_state state;
+        benchmark_permutation(i, permutation_count, specialization, state);
+
+        pipelines.push_back(create_graphics_pipeline(logical_device, pipeline_cache, render_pass, pipeline_layout,
+            vertex_shader_module, fragment_shader_module, specialization, state));
+    }
+
+    const double serial_milliseconds = milliseconds_between(start, std::chrono::steady_clock::now());
+
+    for (VkPipeline pipeline : pipelines)
+    {
+        vkDestroyPipeline(logical_device, pipeline, nullptr);
+    }
+
+    vkDestroyPipelineCache(logical_device, pipeline_cache, nullptr);
+
+    output << "Pipeline compilation of " << permutation_count << " permutations:\n";
+    output << "  serial: " << serial_milliseconds << " ms (" << serial_milliseconds / permutation_count << " ms per pipeline)\n";
+
+    // Powers of two, ending on every core even when their count is not one
+    std::vector<uint32_t> thread_counts;
+
+    for (uint32_t threads = 1; threads < max_threads; threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+
+    thread_counts.push_back(max_threads);
+
+    // Everything requested up front at each thread count, then with derivatives and the first use
+    // of a single permutation on every core
+    const size_t run_count = thread_counts.size() + 2;
+
+    for (size_t run = 0; run < run_count; ++run)
+    {
+        const bool use_derivatives = run == run_count - 2;
+        const bool first_use = run == run_count - 1;
+        const uint32_t threads = run < thread_counts.size() ? thread_counts[run] : max_threads;
+
+        pipeline_cache = create_empty_pipeline_cache(logical_device);
+
+        pipeline_builder builder;
+        builder.create(logical_device, pipeline_cache, render_pass, pipeline_layout, vertex_shader_module,
+            fragment_shader_module, threads, use_derivatives);
+
+        for (uint32_t i = 0; i < permutation_count; ++i)
+        {
+            pipeline_specialization specialization;
+            pipeline_state state;
+            benchmark_permutation(i, permutation_count, specialization, state);
+            builder.add(specialization, state);
+        }
+
+        start = std::chrono::steady_clock::now();
+
+        if (first_use)
+        {
+            builder.wait(permutation_count - 1);
+        }
+        else
+        {
+            builder.request_all();
+            builder.wait_all();
+        }
+
+        const double milliseconds = milliseconds_between(start, std::chrono::steady_clock::now());
+
+        builder.destroy();
+        vkDestroyPipelineCache(logical_device, pipeline_cache, nullptr);
+
+        if (first_use)
+        {
+            output << "  first use of one permutation: " << milliseconds << " ms\n";
+        }
+        else
+        {
+            output << "  " << threads << (threads == 1 ? " thread" : " threads") << (use_derivatives ? " with derivatives" : "")
+                   << ": " << milliseconds << " ms (" << (milliseconds > 0.0 ? serial_milliseconds / milliseconds : 0.0)
+                   << "x serial)\n";
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef _PIPELINE_BUILDER_HPP_
+#define _PIPELINE_BUILDER_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "renderer.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Compiles permutations of the graphics pipeline on worker threads. Every permutation shares the
+// render pass, layout and shader modules and differs in its specialization constants and
+// pipeline_state. Permutations are only compiled once requested, so rarely used ones can be left
+// to compile on first use while the frame draws with a pipeline that is already ready.
+//
+// Pipeline caches are internally synchronized, so all workers create through the same cache.
+//
+// Only --pipeline-benchmark uses it, the sample itself draws with one pipeline created up front.
+class pipeline_builder
+{
+public:
+    typedef uint32_t handle;
+
+    // With use_derivatives the first permutation added is the base every other permutation derives from
+    void create(VkDevice logical_device, VkPipelineCache pipeline_cache, VkRenderPass render_pass,
+        VkPipelineLayout pipeline_layout, VkShaderModule vertex_shader_module, VkShaderModule fragment_shader_module,
+        uint32_t thread_count, bool use_derivatives);
+
+    // Waits for queued compilations and destroys every pipeline built
+    void destroy();
+
+    handle add(const pipeline_specialization& specialization, const pipeline_state& state = {});
+
+    // Queues compilation, repeated requests are ignored
+    void request(handle permutation);
+    void request_all();
+
+    bool ready(handle permutation);
+
+    // VK_NULL_HANDLE until the permutation is compiled, requesting it on first use
+    VkPipeline pipeline(handle permutation);
+
+    // Requests the permutation and blocks until it is compiled, rethrowing a failed compilation
+    VkPipeline wait(handle permutation);
+
+    // Blocks until every requested permutation is compiled
+    void wait_all();
+
+    uint32_t thread_count() const;
+
+private:
+    enum class status
+    {
+        idle,
+        queued,
+        ready,
+        failed
+    };
+
+    struct permutation_entry
+    {
+        pipeline_specialization specialization;
+        pipeline_state state;
+        status progress = status::idle;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        std::exception_ptr failure;
+    };
+
+    void worker_main();
+    void compile(handle permutation);
+    void queue_locked(handle permutation);
+
+    VkDevice logical_device = VK_NULL_HANDLE;
+    VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    VkShaderModule vertex_shader_module = VK_NULL_HANDLE;
+    VkShaderModule fragment_shader_module = VK_NULL_HANDLE;
+    bool derivatives = false;
+
+    // Guarded by mutex, a deque so entries stay in place while workers compile them
+    std::deque<permutation_entry> permutations;
+    std::deque<handle> queue;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    bool stopping = false;
+};
+
+// Compiles permutation_count permutations one at a time on the calling thread, then through
+// pipeline_builder with 1, 2, 4, ... workers up to max_threads, then with max_threads workers and
+// derivatives, and times how long a single permutation takes to become ready on first use. Each
+// run starts from an empty cache.
+void benchmark_pipeline_compilation(VkDevice logical_device, VkRenderPass render_pass, VkPipelineLayout pipeline_layout,
+    VkShaderModule vertex_shader_module, VkShaderModule fragment_shader_module, uint32_t permutation_count,
+    uint32_t max_threads, std::ostream& output);
+
+#endif
@@ -0,0 +1,194 @@
+#include "pipeline_cache.hpp"
+
+#include "sample_trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// Prefix written ahead of the driver's cache data, identifying what produced it
+struct pipeline_cache_file_header
+{
+    char magic[8];
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+    uint64_t checksum;
+};
+
+static const char pipeline_cache_magic[8] = {'V', 'K', 'P', 'C', 'A', 'C', 'H', 'E'};
+
+// FNV-1a, enough to catch truncated or corrupted files
+static uint64_t checksum(const std::vector<char>& data)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    for (char byte : data)
+    {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+static bool validate(const VkPhysicalDeviceProperties& properties, const pipeline_cache_file_header& header,
+    const std::vector<char>& data, std::string& reason)
+{
+    if (std::memcmp(header.magic, pipeline_cache_magic, sizeof(pipeline_cache_magic)) != 0)
+    {
+        reason = "unrecognized file";
+        return false;
+    }
+
+    if (header.vendor_id != properties.vendorID || header.device_id != properties.deviceID)
+    {
+        reason = "written by a different device";
+        return false;
+    }
+
+    if (header.driver_version != properties.driverVersion)
+    {
+        reason = "written by a different driver version";
+        return false;
+    }
+
+    if (std::memcmp(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        reason = "pipeline cache UUID mismatch";
+        return false;
+    }
+
+    if (data.size() != header.data_size || checksum(data) != header.checksum)
+    {
+        reason = "truncated or corrupt data";
+        return false;
+    }
+
+    // The driver's own header must agree as well, drivers are not required to reject bad data
+    VkPipelineCacheHeaderVersionOne driver_header;
+
+    if (data.size() < sizeof(driver_header))
+    {
+        reason = "missing driver header";
+        return false;
+    }
+
+    std::memcpy(&driver_header, data.data(), sizeof(driver_header));
+
+    if (driver_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        driver_header.headerSize < sizeof(driver_header) ||
+        driver_header.vendorID != properties.vendorID ||
+        driver_header.deviceID != properties.deviceID ||
+        std::memcmp(driver_header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        reason = "driver header mismatch";
+        return false;
+    }
+
+    return true;
+}
+
+VkPipelineCache load_pipeline_cache(VkPhysicalDevice physical_device, VkDevice logical_device,
+    const std::string& path, size_t& loaded_bytes)
+{
+    SAMPLE_TRACE_SCOPE("load_pipeline_cache");
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    std::vector<char> data;
+    loaded_bytes = 0;
+
+    std::ifstream cache_file(path, std::ios::binary);
+
+    if (cache_file.is_open())
+    {
+        pipeline_cache_file_header header{};
+        std::string reason;
+
+        if (cache_file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            // Bound the allocation by what is actually on disk before trusting data_size
+            const std::streamoff header_end = cache_file.tellg();
+            cache_file.seekg(0, std::ios::end);
+            const uint64_t available = static_cast<uint64_t>(cache_file.tellg() - header_end);
+            cache_file.seekg(header_end);
+
+            if (header.data_size <= available)
+            {
+                data.resize(header.data_size);
+                cache_file.read(data.data(), data.size());
+            }
+        }
+
+        if (!cache_file || !validate(properties, header, data, reason))
+        {
+            std::cerr << "Discarding pipeline cache " << path << ": " << (reason.empty() ? "truncated file" : reason) << "\n";
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo pipeline_cache_create_info{};
+    pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipeline_cache_create_info.initialDataSize = data.size();
+    pipeline_cache_create_info.pInitialData = data.empty() ? nullptr : data.data();
+
+    VkPipelineCache pipeline_cache;
+
+    if (vkCreatePipelineCache(logical_device, &pipeline_cache_create_info, nullptr, &pipeline_cache) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create pipeline cache");
+    }
+
+    loaded_bytes = data.size();
+    return pipeline_cache;
+}
+
+void save_pipeline_cache(VkPhysicalDevice physical_device, VkDevice logical_device,
+    VkPipelineCache pipeline_cache, const std::string& path)
+{
+    SAMPLE_TRACE_SCOPE("save_pipeline_cache");
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    size_t data_size = 0;
+    vkGetPipelineCacheData(logical_device, pipeline_cache, &data_size, nullptr);
+
+    std::vector<char> data(data_size);
+
+    if (vkGetPipelineCacheData(logical_device, pipeline_cache, &data_size, data.data()) != VK_SUCCESS)
+    {
+        std::cerr << "Unable to retrieve pipeline cache data\n";
+        return;
+    }
+
+    data.resize(data_size);
+
+    pipeline_cache_file_header header{};
+    std::memcpy(header.magic, pipeline_cache_magic, sizeof(pipeline_cache_magic));
+    header.vendor_id = properties.vendorID;
+    header.device_id = properties.deviceID;
+    header.driver_version = properties.driverVersion;
+    std::memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.data_size = data.size();
+    header.checksum = checksum(data);
+
+    const std::string temporary_path = path + ".tmp";
+    std::ofstream cache_file(temporary_path, std::ios::binary | std::ios::trunc);
+    cache_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    cache_file.write(data.data(), data.size());
+    cache_file.close();
+
+    if (!cache_file || std::rename(temporary_path.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Unable to write pipeline cache " << path << "\n";
+        std::remove(temporary_path.c_str());
+    }
+}
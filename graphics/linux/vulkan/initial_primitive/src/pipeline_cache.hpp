@@ -0,0 +1,19 @@
+#ifndef _PIPELINE_CACHE_HPP_
+#define _PIPELINE_CACHE_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <string>
+
+// Creates a pipeline cache seeded from path when the file was written by the same device and
+// driver, loaded_bytes is zero when the cache starts cold
+VkPipelineCache load_pipeline_cache(VkPhysicalDevice physical_device, VkDevice logical_device,
+    const std::string& path, size_t& loaded_bytes);
+
+// Writes the cache contents through a temporary file so an interrupted save never leaves a
+// partial cache behind
+void save_pipeline_cache(VkPhysicalDevice physical_device, VkDevice logical_device,
+    VkPipelineCache pipeline_cache, const std::string& path);
+
+#endif
@@ -0,0 +1,76 @@
+#include "recorded_commands.hpp"
+
+#include <stdexcept>
+
+void recorded_commands::create(VkDevice device, VkCommandPool pool, size_t count)
+{
+    logical_device = device;
+    command_pool = pool;
+    command_buffers.resize(count);
+    dirty.assign(count, true);
+
+    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocation_info.commandPool = command_pool;
+    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocation_info.commandBufferCount = static_cast<uint32_t>(count);
+
+    if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, command_buffers.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate pre-recorded command buffers");
+    }
+}
+
+void recorded_commands::destroy()
+{
+    if (!command_buffers.empty())
+    {
+        vkFreeCommandBuffers(logical_device, command_pool, static_cast<uint32_t>(command_buffers.size()), command_buffers.data());
+    }
+
+    command_buffers.clear();
+    dirty.clear();
+}
+
+void recorded_commands::invalidate_all()
+{
+    dirty.assign(dirty.size(), true);
+}
+
+void recorded_commands::invalidate(size_t index)
+{
+    dirty.at(index) = true;
+}
+
+bool recorded_commands::is_dirty(size_t index) const
+{
+    return dirty.at(index);
+}
+
+VkCommandBuffer recorded_commands::acquire(size_t index, const std::function<void(VkCommandBuffer)>& record)
+{
+    VkCommandBuffer command_buffer = command_buffers.at(index);
+
+    if (!dirty[index])
+    {
+        ++reused;
+        return command_buffer;
+    }
+
+    vkResetCommandBuffer(command_buffer, 0);
+    record(command_buffer);
+    dirty[index] = false;
+    ++recorded;
+
+    return command_buffer;
+}
+
+uint64_t recorded_commands::reused_count() const
+{
+    return reused;
+}
+
+uint64_t recorded_commands::recorded_count() const
+{
+    return recorded;
+}
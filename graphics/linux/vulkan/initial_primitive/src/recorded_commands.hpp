@@ -0,0 +1,38 @@
+#ifndef _RECORDED_COMMANDS_HPP_
+#define _RECORDED_COMMANDS_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <functional>
+#include <vector>
+
+// One command buffer per render target, recorded once and resubmitted until invalidated. Callers
+// must only acquire a buffer once the GPU has finished its previous submission.
+class recorded_commands
+{
+public:
+    void create(VkDevice logical_device, VkCommandPool command_pool, size_t count);
+    void destroy();
+
+    // Marks every buffer for re-recording, e.g. after a swapchain rebuild or a pipeline change
+    void invalidate_all();
+    void invalidate(size_t index);
+    bool is_dirty(size_t index) const;
+
+    // Returns the buffer for index, recording it first through record when it is dirty
+    VkCommandBuffer acquire(size_t index, const std::function<void(VkCommandBuffer)>& record);
+
+    uint64_t reused_count() const;
+    uint64_t recorded_count() const;
+
+private:
+    VkDevice logical_device = VK_NULL_HANDLE;
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> command_buffers;
+    std::vector<bool> dirty;
+    uint64_t reused = 0;
+    uint64_t recorded = 0;
+};
+
+#endif
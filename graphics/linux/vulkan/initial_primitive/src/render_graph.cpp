@@ -0,0 +1,1032 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+static const char* layout_name(VkImageLayout layout)
+{
+    switch (layout)
+    {
+    case VK_IMAGE_LAYOUT_UNDEFINED:
+        return "undefined";
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+        return "color attachment";
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        return "shader read only";
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        return "transfer source";
+    case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+        return "present source";
+    default:
+        return "other";
+    }
+}
+
+resource_id render_graph::import_image(const std::string& name, VkFormat format, VkImageLayout final_layout)
+{
+    resource imported;
+    imported.name = name;
+    imported.format = format;
+    imported.imported = true;
+    imported.final_layout = final_layout;
+    imported.import_index = imported_count++;
+    resources.push_back(imported);
+
+    return static_cast<resource_id>(resources.size() - 1);
+}
+
+resource_id render_graph::create_image(const std::string& name, VkFormat format)
+{
+    resource created;
+    created.name = name;
+    created.format = format;
+    resources.push_back(created);
+
+    return static_cast<resource_id>(resources.size() - 1);
+}
+
+uint32_t render_graph::add_pass(const std::string& name, const std::vector<resource_id>& color_writes,
+    const std::vector<resource_id>& input_reads, const std::vector<resource_id>& sampled_reads,
+    std::function<void(VkCommandBuffer, uint32_t)> record)
+{
+    pass added;
+    added.name = name;
+    added.color_writes = color_writes;
+    added.input_reads = input_reads;
+    added.sampled_reads = sampled_reads;
+    added.record = std::move(record);
+
+    // Each resource is used once per pass, reading and writing the same image would be a feedback loop
+    std::vector<resource_id> used = color_writes;
+    used.insert(used.end(), input_reads.begin(), input_reads.end());
+    used.insert(used.end(), sampled_reads.begin(), sampled_reads.end());
+    std::sort(used.begin(), used.end());
+
+    if (std::adjacent_find(used.begin(), used.end()) != used.end())
+    {
+        throw std::runtime_error("Render graph pass " + name + " uses an image more than once");
+    }
+
+    if (!used.empty() && used.back() >= resources.size())
+    {
+        throw std::runtime_error("Render graph pass " + name + " uses an unknown image");
+    }
+
+    passes.push_back(added);
+
+    return static_cast<uint32_t>(passes.size() - 1);
+}
+
+VkImageLayout render_graph::layout_of(access usage)
+{
+    return usage == access::color_write ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+VkPipelineStageFlags render_graph::stage_of(access usage)
+{
+    return usage == access::color_write ? VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+}
+
+VkAccessFlags render_graph::access_of(access usage)
+{
+    switch (usage)
+    {
+    case access::color_write:
+        return VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    case access::input_read:
+        return VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    case access::sampled_read:
+        return VK_ACCESS_SHADER_READ_BIT;
+    default:
+        return 0;
+    }
+}
+
+render_graph::access render_graph::usage_in(const pass& source, resource_id target) const
+{
+    if (std::find(source.color_writes.begin(), source.color_writes.end(), target) != source.color_writes.end())
+    {
+        return access::color_write;
+    }
+
+    if (std::find(source.input_reads.begin(), source.input_reads.end(), target) != source.input_reads.end())
+    {
+        return access::input_read;
+    }
+
+    if (std::find(source.sampled_reads.begin(), source.sampled_reads.end(), target) != source.sampled_reads.end())
+    {
+        return access::sampled_read;
+    }
+
+    return access::none;
+}
+
+void render_graph::compile(VkPhysicalDevice physical_device, memory_allocator& allocator, VkExtent2D target_extent,
+    uint32_t frames)
+{
+    if (passes.empty())
+    {
+        throw std::runtime_error("Render graph has no passes");
+    }
+
+    memory = &allocator;
+    logical_device = allocator.device();
+    extent = target_extent;
+    frame_count = frames;
+
+    build_groups();
+    allocate_images(physical_device);
+    build_render_passes();
+    create_descriptor_sets();
+}
+
+void render_graph::build_groups()
+{
+    std::vector<bool> written(resources.size(), false);
+
+    for (uint32_t i = 0; i < passes.size(); ++i)
+    {
+        pass& current = passes[i];
+
+        // A sampled read may touch any pixel, so the writer's render pass has to end first
+        bool split = groups.empty();
+
+        for (uint32_t j = split ? 0 : groups.back().first_pass; !split && j < i; ++j)
+        {
+            for (resource_id target : current.sampled_reads)
+            {
+                split = split || usage_in(passes[j], target) == access::color_write;
+            }
+        }
+
+        if (split)
+        {
+            group created;
+            created.first_pass = i;
+            groups.push_back(created);
+        }
+
+        current.group = static_cast<uint32_t>(groups.size() - 1);
+        current.subpass = groups.back().pass_count++;
+
+        for (resource_id target : current.input_reads)
+        {
+            resources[target].usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+        }
+
+        for (resource_id target : current.sampled_reads)
+        {
+            resources[target].usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+        }
+
+        for (resource_id target : current.color_writes)
+        {
+            resources[target].usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        }
+
+        for (resource_id target = 0; target < resources.size(); ++target)
+        {
+            const access usage = usage_in(current, target);
+
+            if (usage == access::none)
+            {
+                continue;
+            }
+
+            resource& used = resources[target];
+
+            if (usage != access::color_write && !written[target])
+            {
+                throw std::runtime_error("Render graph pass " + current.name + " reads " + used.name + " before it is written");
+            }
+
+            if (usage != access::color_write && used.imported)
+            {
+                throw std::runtime_error("Render graph pass " + current.name + " reads imported image " + used.name);
+            }
+
+            written[target] = written[target] || usage == access::color_write;
+            used.first_group = std::min(used.first_group, current.group);
+            used.last_group = std::max(used.last_group, current.group);
+        }
+    }
+
+    for (resource& candidate : resources)
+    {
+        if (candidate.imported && candidate.first_group != UINT32_MAX && candidate.first_group != candidate.last_group)
+        {
+            throw std::runtime_error("Render graph image " + candidate.name + " is imported but used by several render passes");
+        }
+
+        candidate.transient = !candidate.imported && candidate.first_group == candidate.last_group;
+    }
+}
+
+void render_graph::allocate_images(VkPhysicalDevice physical_device)
+{
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    uint32_t lazily_allocated_types = 0;
+
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+    {
+        if (memory_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+        {
+            lazily_allocated_types |= 1u << i;
+        }
+    }
+
+    // Images are assigned memory in order of first use so freed slots can be taken by later images
+    std::vector<resource_id> order(resources.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](resource_id a, resource_id b) {
+        return resources[a].first_group < resources[b].first_group;
+    });
+
+    for (resource_id target : order)
+    {
+        resource& created = resources[target];
+
+        if (created.imported || created.first_group == UINT32_MAX)
+        {
+            continue;
+        }
+
+        if (created.transient)
+        {
+            created.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        }
+
+        created.images.resize(frame_count);
+        created.views.resize(frame_count);
+        created.memory.resize(frame_count);
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            VkImageCreateInfo image_create_info{};
+            image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            image_create_info.imageType = VK_IMAGE_TYPE_2D;
+            image_create_info.format = created.format;
+            image_create_info.extent = {extent.width, extent.height, 1};
+            image_create_info.mipLevels = 1;
+            image_create_info.arrayLayers = 1;
+            image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+            image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            image_create_info.usage = created.usage;
+            image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            if (vkCreateImage(logical_device, &image_create_info, nullptr, &created.images[frame]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Unable to create render graph image " + created.name);
+            }
+        }
+
+        vkGetImageMemoryRequirements(logical_device, created.images[0], &created.requirements);
+        requested_bytes += created.requirements.size * frame_count;
+
+        // Tile based GPUs never back lazily allocated memory when the attachment stays on chip
+        if (created.transient && (created.requirements.memoryTypeBits & lazily_allocated_types) != 0)
+        {
+            created.lazily_allocated = true;
+            lazily_allocated_bytes += created.requirements.size * frame_count;
+
+            for (uint32_t frame = 0; frame < frame_count; ++frame)
+            {
+                created.memory[frame] = memory->allocate_image(created.images[frame], VK_IMAGE_TILING_OPTIMAL,
+                    VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+            }
+
+            continue;
+        }
+
+        // Share the memory of an image whose last render pass comes before this image's first
+        for (uint32_t slot = 0; slot < alias_slots.size() && created.alias_slot == UINT32_MAX; ++slot)
+        {
+            alias_slot& candidate = alias_slots[slot];
+
+            if (candidate.last_group < created.first_group &&
+                (candidate.requirements.memoryTypeBits & created.requirements.memoryTypeBits) != 0)
+            {
+                candidate.requirements.size = std::max(candidate.requirements.size, created.requirements.size);
+                candidate.requirements.alignment = std::max(candidate.requirements.alignment, created.requirements.alignment);
+                candidate.requirements.memoryTypeBits &= created.requirements.memoryTypeBits;
+                candidate.last_group = created.last_group;
+                created.alias_slot = slot;
+            }
+        }
+
+        if (created.alias_slot == UINT32_MAX)
+        {
+            alias_slot added;
+            added.requirements = created.requirements;
+            added.last_group = created.last_group;
+            alias_slots.push_back(added);
+            created.alias_slot = static_cast<uint32_t>(alias_slots.size() - 1);
+        }
+    }
+
+    for (alias_slot& slot : alias_slots)
+    {
+        slot.memory.resize(frame_count);
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            slot.memory[frame] = memory->allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, resource_kind::optimal);
+        }
+
+        allocated_bytes += slot.requirements.size * frame_count;
+    }
+
+    for (resource& created : resources)
+    {
+        for (uint32_t frame = 0; frame < created.images.size(); ++frame)
+        {
+            if (created.alias_slot != UINT32_MAX)
+            {
+                const memory_allocation& shared = alias_slots[created.alias_slot].memory[frame];
+
+                if (vkBindImageMemory(logical_device, created.images[frame], shared.memory, shared.offset) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("Unable to bind render graph image memory");
+                }
+            }
+
+            VkImageViewCreateInfo image_view_create_info{};
+            image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            image_view_create_info.image = created.images[frame];
+            image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            image_view_create_info.format = created.format;
+            image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+            image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+            image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+            image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+            image_view_create_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+            if (vkCreateImageView(logical_device, &image_view_create_info, nullptr, &created.views[frame]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Unable to create render graph image view");
+            }
+        }
+    }
+}
+
+void render_graph::build_render_passes()
+{
+    bool has_reads = false;
+
+    for (const pass& source : passes)
+    {
+        has_reads = has_reads || !source.input_reads.empty() || !source.sampled_reads.empty();
+    }
+
+    // State of every image at the end of the render passes built so far
+    std::vector<VkImageLayout> layouts(resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+    std::vector<access> last_usage(resources.size(), access::none);
+    std::vector<resource_id> slot_owners(alias_slots.size(), UINT32_MAX);
+
+    for (uint32_t group_index = 0; group_index < groups.size(); ++group_index)
+    {
+        group& current = groups[group_index];
+
+        // First and last use of every image inside the render pass
+        std::vector<access> first_usage(resources.size(), access::none);
+        std::vector<access> final_usage(resources.size(), access::none);
+        std::vector<uint32_t> first_subpass(resources.size(), 0);
+        std::vector<uint32_t> final_subpass(resources.size(), 0);
+
+        for (uint32_t i = current.first_pass; i < current.first_pass + current.pass_count; ++i)
+        {
+            for (resource_id target = 0; target < resources.size(); ++target)
+            {
+                const access usage = usage_in(passes[i], target);
+
+                if (usage == access::none)
+                {
+                    continue;
+                }
+
+                if (first_usage[target] == access::none)
+                {
+                    first_usage[target] = usage;
+                    first_subpass[target] = passes[i].subpass;
+                }
+
+                if (usage != access::sampled_read &&
+                    std::find(current.attachments.begin(), current.attachments.end(), target) == current.attachments.end())
+                {
+                    current.attachments.push_back(target);
+                }
+
+                final_usage[target] = usage;
+                final_subpass[target] = passes[i].subpass;
+            }
+        }
+
+        // Barriers against earlier render passes and against the previous image in the same memory
+        const std::vector<access> previous_usage = last_usage;
+
+        for (resource_id target = 0; target < resources.size(); ++target)
+        {
+            if (first_usage[target] == access::none)
+            {
+                continue;
+            }
+
+            const uint32_t slot = resources[target].alias_slot;
+            barrier transition;
+            transition.target = target;
+            transition.new_layout = layout_of(first_usage[target]);
+            transition.dst_stage = stage_of(first_usage[target]);
+            transition.dst_access = access_of(first_usage[target]);
+
+            if (first_usage[target] == access::color_write)
+            {
+                transition.dst_access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+            }
+
+            if (previous_usage[target] != access::none)
+            {
+                transition.old_layout = layouts[target];
+                transition.src_stage = stage_of(previous_usage[target]);
+                transition.src_access = access_of(previous_usage[target]);
+
+                // Reads after reads in the same layout need nothing
+                if (previous_usage[target] != access::color_write && first_usage[target] != access::color_write &&
+                    transition.old_layout == transition.new_layout)
+                {
+                    continue;
+                }
+            }
+            else if (slot != UINT32_MAX && slot_owners[slot] != UINT32_MAX)
+            {
+                const resource_id previous = slot_owners[slot];
+                transition.aliasing = true;
+                transition.src_stage = stage_of(last_usage[previous]);
+                transition.src_access = access_of(last_usage[previous]);
+            }
+            else
+            {
+                continue;
+            }
+
+            current.barriers.push_back(transition);
+            layouts[target] = transition.new_layout;
+        }
+
+        for (resource_id target = 0; target < resources.size(); ++target)
+        {
+            if (first_usage[target] != access::none && resources[target].alias_slot != UINT32_MAX)
+            {
+                slot_owners[resources[target].alias_slot] = target;
+            }
+        }
+
+        // Attachments, loaded when an earlier render pass wrote them and stored when a later one uses them
+        std::vector<VkAttachmentDescription> attachment_descriptions;
+
+        for (resource_id target : current.attachments)
+        {
+            const resource& attached = resources[target];
+            const bool written_before = previous_usage[target] != access::none;
+
+            VkAttachmentDescription attachment{};
+            attachment.format = attached.format;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = written_before ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachment.storeOp = attached.imported || attached.last_group > group_index
+                ? VK_ATTACHMENT_STORE_OP_STORE
+                : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = written_before ? layouts[target] : VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment.finalLayout = attached.imported ? attached.final_layout : layout_of(final_usage[target]);
+            attachment_descriptions.push_back(attachment);
+        }
+
+        for (resource_id target = 0; target < resources.size(); ++target)
+        {
+            if (first_usage[target] == access::none)
+            {
+                continue;
+            }
+
+            layouts[target] = first_usage[target] == access::sampled_read ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                : resources[target].imported ? resources[target].final_layout
+                : layout_of(final_usage[target]);
+            last_usage[target] = final_usage[target];
+        }
+
+        // Subpasses, attachments used before and after a subpass that skips them are preserved
+        std::vector<std::vector<VkAttachmentReference>> color_references(current.pass_count);
+        std::vector<std::vector<VkAttachmentReference>> input_references(current.pass_count);
+        std::vector<std::vector<uint32_t>> preserved(current.pass_count);
+        std::vector<VkSubpassDescription> subpass_descriptions(current.pass_count);
+
+        for (uint32_t subpass_index = 0; subpass_index < current.pass_count; ++subpass_index)
+        {
+            const pass& source = passes[current.first_pass + subpass_index];
+
+            for (uint32_t attachment = 0; attachment < current.attachments.size(); ++attachment)
+            {
+                const resource_id target = current.attachments[attachment];
+
+                if (usage_in(source, target) == access::none && first_subpass[target] < subpass_index &&
+                    subpass_index < final_subpass[target])
+                {
+                    preserved[subpass_index].push_back(attachment);
+                }
+            }
+
+            // References follow declaration order, which the shaders' locations and input indices rely on
+            for (resource_id target : source.color_writes)
+            {
+                const auto position = std::find(current.attachments.begin(), current.attachments.end(), target);
+                color_references[subpass_index].push_back({static_cast<uint32_t>(position - current.attachments.begin()),
+                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+            }
+
+            for (resource_id target : source.input_reads)
+            {
+                const auto position = std::find(current.attachments.begin(), current.attachments.end(), target);
+                input_references[subpass_index].push_back({static_cast<uint32_t>(position - current.attachments.begin()),
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+            }
+
+            VkSubpassDescription& description = subpass_descriptions[subpass_index];
+            description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            description.colorAttachmentCount = static_cast<uint32_t>(color_references[subpass_index].size());
+            description.pColorAttachments = color_references[subpass_index].data();
+            description.inputAttachmentCount = static_cast<uint32_t>(input_references[subpass_index].size());
+            description.pInputAttachments = input_references[subpass_index].data();
+            description.preserveAttachmentCount = static_cast<uint32_t>(preserved[subpass_index].size());
+            description.pPreserveAttachments = preserved[subpass_index].data();
+        }
+
+        // Subpass dependencies. Earlier frames' writes, and reads when the graph has any, finish before
+        // a subpass first touches an attachment, matching the single pass render pass this replaces.
+        auto add_dependency = [&](uint32_t src, uint32_t dst, VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+            VkPipelineStageFlags dst_stage, VkAccessFlags dst_access, VkDependencyFlags flags) {
+            for (VkSubpassDependency& existing : current.dependencies)
+            {
+                if (existing.srcSubpass == src && existing.dstSubpass == dst)
+                {
+                    existing.srcStageMask |= src_stage;
+                    existing.srcAccessMask |= src_access;
+                    existing.dstStageMask |= dst_stage;
+                    existing.dstAccessMask |= dst_access;
+                    return;
+                }
+            }
+
+            current.dependencies.push_back({src, dst, src_stage, dst_stage, src_access, dst_access, flags});
+        };
+
+        const VkPipelineStageFlags external_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+            (has_reads ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : 0);
+
+        std::vector<uint32_t> last_subpass(resources.size(), UINT32_MAX);
+        std::vector<access> last_subpass_usage(resources.size(), access::none);
+
+        for (uint32_t subpass_index = 0; subpass_index < current.pass_count; ++subpass_index)
+        {
+            const pass& source = passes[current.first_pass + subpass_index];
+
+            for (resource_id target : current.attachments)
+            {
+                const access usage = usage_in(source, target);
+
+                if (usage == access::none)
+                {
+                    continue;
+                }
+
+                if (last_subpass[target] == UINT32_MAX)
+                {
+                    add_dependency(VK_SUBPASS_EXTERNAL, subpass_index, external_stage, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                        stage_of(usage), access_of(usage), 0);
+                }
+                else if (usage == access::color_write || last_subpass_usage[target] == access::color_write)
+                {
+                    // Only the same pixel is read, so tile based GPUs can keep the attachment on chip
+                    add_dependency(last_subpass[target], subpass_index, stage_of(last_subpass_usage[target]),
+                        access_of(last_subpass_usage[target]), stage_of(usage), access_of(usage),
+                        VK_DEPENDENCY_BY_REGION_BIT);
+                }
+
+                last_subpass[target] = subpass_index;
+                last_subpass_usage[target] = usage;
+            }
+        }
+
+        VkRenderPassCreateInfo render_pass_create_info{};
+        render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        render_pass_create_info.attachmentCount = static_cast<uint32_t>(attachment_descriptions.size());
+        render_pass_create_info.pAttachments = attachment_descriptions.data();
+        render_pass_create_info.subpassCount = static_cast<uint32_t>(subpass_descriptions.size());
+        render_pass_create_info.pSubpasses = subpass_descriptions.data();
+        render_pass_create_info.dependencyCount = static_cast<uint32_t>(current.dependencies.size());
+        render_pass_create_info.pDependencies = current.dependencies.data();
+
+        if (vkCreateRenderPass(logical_device, &render_pass_create_info, nullptr, &current.render_pass) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create render pass");
+        }
+
+        current.framebuffers.assign(frame_count, VK_NULL_HANDLE);
+    }
+}
+
+void render_graph::create_descriptor_sets()
+{
+    uint32_t input_count = 0;
+    uint32_t sampled_count = 0;
+    uint32_t set_count = 0;
+
+    for (const pass& source : passes)
+    {
+        input_count += static_cast<uint32_t>(source.input_reads.size());
+        sampled_count += static_cast<uint32_t>(source.sampled_reads.size());
+        set_count += !source.input_reads.empty() || !source.sampled_reads.empty() ? 1 : 0;
+    }
+
+    if (set_count == 0)
+    {
+        return;
+    }
+
+    if (sampled_count > 0)
+    {
+        // Sampled reads cover the image one to one, nearest filtering keeps them exact
+        VkSamplerCreateInfo sampler_create_info{};
+        sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        sampler_create_info.magFilter = VK_FILTER_NEAREST;
+        sampler_create_info.minFilter = VK_FILTER_NEAREST;
+        sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_create_info.maxLod = 0.0f;
+
+        if (vkCreateSampler(logical_device, &sampler_create_info, nullptr, &sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create render graph sampler");
+        }
+    }
+
+    std::vector<VkDescriptorPoolSize> pool_sizes;
+
+    if (input_count > 0)
+    {
+        pool_sizes.push_back({VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, input_count * frame_count});
+    }
+
+    if (sampled_count > 0)
+    {
+        pool_sizes.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampled_count * frame_count});
+    }
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = set_count * frame_count;
+    descriptor_pool_create_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    descriptor_pool_create_info.pPoolSizes = pool_sizes.data();
+
+    if (vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &descriptor_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create render graph descriptor pool");
+    }
+
+    for (pass& reader : passes)
+    {
+        std::vector<resource_id> reads = reader.input_reads;
+        reads.insert(reads.end(), reader.sampled_reads.begin(), reader.sampled_reads.end());
+
+        if (reads.empty())
+        {
+            continue;
+        }
+
+        std::vector<VkDescriptorSetLayoutBinding> bindings(reads.size());
+
+        for (uint32_t binding = 0; binding < reads.size(); ++binding)
+        {
+            bindings[binding].binding = binding;
+            bindings[binding].descriptorType = binding < reader.input_reads.size()
+                ? VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT
+                : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            bindings[binding].descriptorCount = 1;
+            bindings[binding].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+        descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
+        descriptor_set_layout_create_info.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &reader.set_layout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create render graph descriptor set layout");
+        }
+
+        const std::vector<VkDescriptorSetLayout> set_layouts(frame_count, reader.set_layout);
+        reader.descriptor_sets.resize(frame_count);
+
+        VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptor_set_allocate_info.descriptorPool = descriptor_pool;
+        descriptor_set_allocate_info.descriptorSetCount = frame_count;
+        descriptor_set_allocate_info.pSetLayouts = set_layouts.data();
+
+        if (vkAllocateDescriptorSets(logical_device, &descriptor_set_allocate_info, reader.descriptor_sets.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to allocate render graph descriptor sets");
+        }
+
+        // Every image is read in the layout the barriers or subpass references leave it in
+        std::vector<VkDescriptorImageInfo> image_infos(reads.size() * frame_count);
+        std::vector<VkWriteDescriptorSet> writes(reads.size() * frame_count);
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            for (uint32_t binding = 0; binding < reads.size(); ++binding)
+            {
+                const uint32_t index = frame * static_cast<uint32_t>(reads.size()) + binding;
+
+                image_infos[index].sampler = binding < reader.input_reads.size() ? VK_NULL_HANDLE : sampler;
+                image_infos[index].imageView = resources[reads[binding]].views[frame];
+                image_infos[index].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+                writes[index].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[index].dstSet = reader.descriptor_sets[frame];
+                writes[index].dstBinding = binding;
+                writes[index].descriptorCount = 1;
+                writes[index].descriptorType = bindings[binding].descriptorType;
+                writes[index].pImageInfo = &image_infos[index];
+            }
+        }
+
+        vkUpdateDescriptorSets(logical_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+}
+
+void render_graph::create_framebuffers(uint32_t frame, const std::vector<VkImageView>& imported_views)
+{
+    if (imported_views.size() != imported_count)
+    {
+        throw std::runtime_error("Render graph framebuffers need a view for every imported image");
+    }
+
+    for (group& current : groups)
+    {
+        std::vector<VkImageView> attachments;
+
+        for (resource_id target : current.attachments)
+        {
+            const resource& attached = resources[target];
+            attachments.push_back(attached.imported ? imported_views[attached.import_index] : attached.views[frame]);
+        }
+
+        VkFramebufferCreateInfo framebuffer_create_info{};
+        framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_create_info.renderPass = current.render_pass;
+        framebuffer_create_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebuffer_create_info.pAttachments = attachments.data();
+        framebuffer_create_info.width = extent.width;
+        framebuffer_create_info.height = extent.height;
+        framebuffer_create_info.layers = 1;
+
+        if (vkCreateFramebuffer(logical_device, &framebuffer_create_info, nullptr, &current.framebuffers[frame]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create framebuffer");
+        }
+    }
+}
+
+void render_graph::destroy()
+{
+    for (group& current : groups)
+    {
+        for (VkFramebuffer framebuffer : current.framebuffers)
+        {
+            if (framebuffer != VK_NULL_HANDLE)
+            {
+                vkDestroyFramebuffer(logical_device, framebuffer, nullptr);
+            }
+        }
+
+        vkDestroyRenderPass(logical_device, current.render_pass, nullptr);
+    }
+
+    for (pass& reader : passes)
+    {
+        if (reader.set_layout != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(logical_device, reader.set_layout, nullptr);
+        }
+    }
+
+    if (descriptor_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(logical_device, descriptor_pool, nullptr);
+    }
+
+    if (sampler != VK_NULL_HANDLE)
+    {
+        vkDestroySampler(logical_device, sampler, nullptr);
+    }
+
+    for (resource& created : resources)
+    {
+        for (uint32_t frame = 0; frame < created.images.size(); ++frame)
+        {
+            vkDestroyImageView(logical_device, created.views[frame], nullptr);
+            vkDestroyImage(logical_device, created.images[frame], nullptr);
+            memory->free(created.memory[frame]);
+        }
+    }
+
+    for (alias_slot& slot : alias_slots)
+    {
+        for (const memory_allocation& allocation : slot.memory)
+        {
+            memory->free(allocation);
+        }
+    }
+
+    resources.clear();
+    passes.clear();
+    groups.clear();
+    alias_slots.clear();
+    imported_count = 0;
+    sampler = VK_NULL_HANDLE;
+    descriptor_pool = VK_NULL_HANDLE;
+}
+
+VkRenderPass render_graph::render_pass(uint32_t pass_index) const
+{
+    return groups[passes[pass_index].group].render_pass;
+}
+
+uint32_t render_graph::subpass(uint32_t pass_index) const
+{
+    return passes[pass_index].subpass;
+}
+
+VkFramebuffer render_graph::framebuffer(uint32_t frame, uint32_t pass_index) const
+{
+    return groups[passes[pass_index].group].framebuffers[frame];
+}
+
+uint32_t render_graph::attachment_count(uint32_t pass_index) const
+{
+    return static_cast<uint32_t>(groups[passes[pass_index].group].attachments.size());
+}
+
+VkDescriptorSetLayout render_graph::set_layout(uint32_t pass_index) const
+{
+    return passes[pass_index].set_layout;
+}
+
+VkDescriptorSet render_graph::descriptor_set(uint32_t frame, uint32_t pass_index) const
+{
+    return passes[pass_index].descriptor_sets.empty() ? VK_NULL_HANDLE : passes[pass_index].descriptor_sets[frame];
+}
+
+void render_graph::record_remaining(VkCommandBuffer command_buffer, uint32_t frame) const
+{
+    for (uint32_t group_index = 0; group_index < groups.size(); ++group_index)
+    {
+        const group& current = groups[group_index];
+
+        if (group_index > 0)
+        {
+            std::vector<VkImageMemoryBarrier> image_barriers;
+            VkPipelineStageFlags src_stage = 0;
+            VkPipelineStageFlags dst_stage = 0;
+
+            for (const barrier& transition : current.barriers)
+            {
+                VkImageMemoryBarrier image_barrier{};
+                image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                image_barrier.srcAccessMask = transition.src_access;
+                image_barrier.dstAccessMask = transition.dst_access;
+                image_barrier.oldLayout = transition.old_layout;
+                image_barrier.newLayout = transition.new_layout;
+                image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                image_barrier.image = resources[transition.target].images[frame];
+                image_barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+                image_barriers.push_back(image_barrier);
+
+                src_stage |= transition.src_stage;
+                dst_stage |= transition.dst_stage;
+            }
+
+            if (!image_barriers.empty())
+            {
+                vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr,
+                    static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+            }
+
+            const std::vector<VkClearValue> clear_values(current.attachments.size(), {{{0.0f, 0.0f, 0.0f, 1.0f}}});
+
+            VkRenderPassBeginInfo render_pass_begin_info{};
+            render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            render_pass_begin_info.renderPass = current.render_pass;
+            render_pass_begin_info.framebuffer = current.framebuffers[frame];
+            render_pass_begin_info.renderArea.offset = {0, 0};
+            render_pass_begin_info.renderArea.extent = extent;
+            render_pass_begin_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+            render_pass_begin_info.pClearValues = clear_values.data();
+
+            vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        // The caller has already recorded the first pass
+        for (uint32_t i = current.first_pass; i < current.first_pass + current.pass_count; ++i)
+        {
+            if (i == 0)
+            {
+                continue;
+            }
+
+            if (passes[i].subpass > 0)
+            {
+                vkCmdNextSubpass(command_buffer, VK_SUBPASS_CONTENTS_INLINE);
+            }
+
+            if (passes[i].record)
+            {
+                passes[i].record(command_buffer, frame);
+            }
+        }
+
+        vkCmdEndRenderPass(command_buffer);
+    }
+}
+
+void render_graph::report(std::ostream& output) const
+{
+    output << "Render graph: " << passes.size() << " passes in " << groups.size() << " render passes\n";
+
+    for (uint32_t group_index = 0; group_index < groups.size(); ++group_index)
+    {
+        const group& current = groups[group_index];
+
+        for (const barrier& transition : current.barriers)
+        {
+            output << "  Barrier: " << resources[transition.target].name << " "
+                   << (transition.aliasing ? "(aliased) " : "") << layout_name(transition.old_layout) << " -> "
+                   << layout_name(transition.new_layout) << "\n";
+        }
+
+        output << "  Render pass " << group_index << ":";
+
+        for (uint32_t i = current.first_pass; i < current.first_pass + current.pass_count; ++i)
+        {
+            output << (i == current.first_pass ? " " : ", ") << passes[i].name;
+        }
+
+        output << "\n";
+
+        for (const VkSubpassDependency& dependency : current.dependencies)
+        {
+            if (dependency.srcSubpass != VK_SUBPASS_EXTERNAL)
+            {
+                output << "    Dependency: " << passes[current.first_pass + dependency.srcSubpass].name << " -> "
+                       << passes[current.first_pass + dependency.dstSubpass].name
+                       << ((dependency.dependencyFlags & VK_DEPENDENCY_BY_REGION_BIT) ? " (by region)" : "") << "\n";
+            }
+        }
+    }
+
+    for (const resource& created : resources)
+    {
+        if (created.images.empty())
+        {
+            continue;
+        }
+
+        output << "  Image " << created.name << ": " << created.requirements.size / 1024 << " KiB per frame"
+               << (created.transient ? ", transient" : "")
+               << (created.lazily_allocated ? ", lazily allocated" : "");
+
+        if (created.alias_slot != UINT32_MAX)
+        {
+            output << ", memory slot " << created.alias_slot;
+        }
+
+        output << "\n";
+    }
+
+    if (requested_bytes > 0)
+    {
+        output << "Render graph memory: " << requested_bytes / 1024 << " KiB requested, " << allocated_bytes / 1024
+               << " KiB allocated, " << lazily_allocated_bytes / 1024 << " KiB lazily allocated, "
+               << (requested_bytes - allocated_bytes - lazily_allocated_bytes) / 1024 << " KiB saved by aliasing\n";
+    }
+}
@@ -0,0 +1,174 @@
+#ifndef _RENDER_GRAPH_HPP_
+#define _RENDER_GRAPH_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "memory_allocator.hpp"
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Frame graph of color passes. Passes declare the images they write and read, and compile derives
+// the render passes, subpass dependencies, layout transitions and barriers from those declarations.
+//
+// Consecutive passes are merged into subpasses of one render pass unless a pass samples an image
+// written in the current render pass, which needs the write to finish at every pixel first. Images
+// created by the graph and only used inside one render pass never leave tile memory, they are made
+// transient and backed by lazily allocated memory when the device has it. The other graph images
+// share memory when the render passes using them do not overlap.
+
+typedef uint32_t resource_id;
+
+class render_graph
+{
+public:
+    // Image owned by the caller, such as a swapchain image, left in final_layout after its last
+    // use. Imported images may only be used inside a single render pass, their views are given
+    // per frame to create_framebuffers.
+    resource_id import_image(const std::string& name, VkFormat format, VkImageLayout final_layout);
+
+    // Image created by the graph at the extent given to compile, one per frame
+    resource_id create_image(const std::string& name, VkFormat format);
+
+    // Passes run in the order they are added. input_reads are read as input attachments at the
+    // same pixel, sampled_reads through a combined image sampler anywhere in the image. The first
+    // pass is recorded by the caller between render pass begin and record_remaining, the others
+    // by their record callback, which is given the frame the graph images belong to.
+    uint32_t add_pass(const std::string& name, const std::vector<resource_id>& color_writes,
+        const std::vector<resource_id>& input_reads = {}, const std::vector<resource_id>& sampled_reads = {},
+        std::function<void(VkCommandBuffer, uint32_t)> record = {});
+
+    void compile(VkPhysicalDevice physical_device, memory_allocator& allocator, VkExtent2D extent, uint32_t frame_count);
+    void destroy();
+
+    // Framebuffers of every render pass for one frame, imported_views are indexed in import order
+    void create_framebuffers(uint32_t frame, const std::vector<VkImageView>& imported_views);
+
+    VkRenderPass render_pass(uint32_t pass) const;
+    uint32_t subpass(uint32_t pass) const;
+    VkFramebuffer framebuffer(uint32_t frame, uint32_t pass) const;
+    uint32_t attachment_count(uint32_t pass) const;
+
+    // Reads of the pass, input attachments first then sampled images in declaration order.
+    // VK_NULL_HANDLE when the pass reads nothing.
+    VkDescriptorSetLayout set_layout(uint32_t pass) const;
+    VkDescriptorSet descriptor_set(uint32_t frame, uint32_t pass) const;
+
+    // Ends the first render pass after the first pass and records every later pass with the
+    // barriers between render passes
+    void record_remaining(VkCommandBuffer command_buffer, uint32_t frame) const;
+
+    void report(std::ostream& output) const;
+
+private:
+    enum class access
+    {
+        none,
+        color_write,
+        input_read,
+        sampled_read
+    };
+
+    struct resource
+    {
+        std::string name;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        bool imported = false;
+        VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        uint32_t import_index = 0;
+
+        VkImageUsageFlags usage = 0;
+        uint32_t first_group = UINT32_MAX;
+        uint32_t last_group = 0;
+        bool transient = false;
+        bool lazily_allocated = false;
+
+        // Alias slot sharing memory with other resources, UINT32_MAX for dedicated memory
+        uint32_t alias_slot = UINT32_MAX;
+        VkMemoryRequirements requirements{};
+
+        // Per frame
+        std::vector<VkImage> images;
+        std::vector<VkImageView> views;
+        std::vector<memory_allocation> memory;
+    };
+
+    struct pass
+    {
+        std::string name;
+        std::vector<resource_id> color_writes;
+        std::vector<resource_id> input_reads;
+        std::vector<resource_id> sampled_reads;
+        std::function<void(VkCommandBuffer, uint32_t)> record;
+
+        uint32_t group = 0;
+        uint32_t subpass = 0;
+        VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> descriptor_sets;
+    };
+
+    // Transition of a resource between render passes, or from a previous resource sharing its memory
+    struct barrier
+    {
+        resource_id target = 0;
+        bool aliasing = false;
+        VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags src_stage = 0;
+        VkPipelineStageFlags dst_stage = 0;
+        VkAccessFlags src_access = 0;
+        VkAccessFlags dst_access = 0;
+    };
+
+    // Consecutive passes merged into one render pass
+    struct group
+    {
+        uint32_t first_pass = 0;
+        uint32_t pass_count = 0;
+        std::vector<resource_id> attachments;
+        std::vector<barrier> barriers;
+        std::vector<VkSubpassDependency> dependencies;
+        VkRenderPass render_pass = VK_NULL_HANDLE;
+        std::vector<VkFramebuffer> framebuffers;
+    };
+
+    struct alias_slot
+    {
+        VkMemoryRequirements requirements{};
+        uint32_t last_group = 0;
+        std::vector<memory_allocation> memory;
+    };
+
+    static VkImageLayout layout_of(access usage);
+    static VkPipelineStageFlags stage_of(access usage);
+    static VkAccessFlags access_of(access usage);
+    access usage_in(const pass& source, resource_id target) const;
+
+    void build_groups();
+    void build_render_passes();
+    void allocate_images(VkPhysicalDevice physical_device);
+    void create_descriptor_sets();
+
+    std::vector<resource> resources;
+    std::vector<pass> passes;
+    std::vector<group> groups;
+    std::vector<alias_slot> alias_slots;
+    uint32_t imported_count = 0;
+
+    memory_allocator* memory = nullptr;
+    VkDevice logical_device = VK_NULL_HANDLE;
+    VkExtent2D extent{};
+    uint32_t frame_count = 0;
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+
+    // Bytes the graph images would take with one allocation each, and what they were given
+    VkDeviceSize requested_bytes = 0;
+    VkDeviceSize allocated_bytes = 0;
+    VkDeviceSize lazily_allocated_bytes = 0;
+};
+
+#endif
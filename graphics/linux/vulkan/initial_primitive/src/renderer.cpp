@@ -0,0 +1,560 @@
+#include "renderer.hpp"
+
+#include "embedded_shaders.hpp"
+#include "sample_trace.h"
+
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+
+const std::vector<std::string> timed_pass_names = {"main"};
+
+std::vector<uint32_t> read_shader(const std::string& path)
+{
+    std::ifstream shader_file(path, std::ios::ate | std::ios::binary);
+
+    if (!shader_file.is_open())
+    {
+        throw std::runtime_error("Unable to read shader SPIR-V: " + path);
+    }
+
+    const size_t file_size = static_cast<size_t>(shader_file.tellg());
+
+    if (file_size == 0 || file_size % sizeof(uint32_t) != 0)
+    {
+        throw std::runtime_error("Shader SPIR-V is not a whole number of words: " + path);
+    }
+
+    // Read straight into words so the code is aligned the way vkCreateShaderModule expects
+    std::vector<uint32_t> code(file_size / sizeof(uint32_t));
+
+    shader_file.seekg(0);
+    shader_file.read(reinterpret_cast<char*>(code.data()), file_size);
+    shader_file.close();
+
+    return code;
+}
+
+VkShaderModule create_shader_module(VkDevice logical_device, const uint32_t* code, size_t size)
+{
+    VkShaderModuleCreateInfo shader_module_create_info{};
+    shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_module_create_info.codeSize = size;
+    shader_module_create_info.pCode = code;
+    VkShaderModule shader_module;
+
+    if (vkCreateShaderModule(logical_device, &shader_module_create_info, nullptr, &shader_module) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create shader module");
+    }
+
+    return shader_module;
+}
+
+VkShaderModule load_shader_module(VkDevice logical_device, const std::string& name, const std::string& shader_directory)
+{
+    SAMPLE_TRACE_SCOPE("load_shader_module");
+
+    if (!shader_directory.empty())
+    {
+        const std::vector<uint32_t> code = read_shader(shader_directory + "/" + name);
+        return create_shader_module(logical_device, code.data(), code.size() * sizeof(uint32_t));
+    }
+
+    const embedded_shader* shader = find_embedded_shader(name);
+
+    if (shader == nullptr)
+    {
+        throw std::runtime_error("No embedded shader named " + name);
+    }
+
+    return create_shader_module(logical_device, shader->code, shader->size);
+}
+
+VkPipelineLayout create_pipeline_layout(VkDevice logical_device, VkDescriptorSetLayout frame_set_layout,
+    VkDescriptorSetLayout texture_set_layout)
+{
+    const VkDescriptorSetLayout set_layouts[] = {frame_set_layout, texture_set_layout};
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(draw_constants);
+
+    VkPipelineLayout pipeline_layout;
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = texture_set_layout != VK_NULL_HANDLE ? 2 : 1;
+    pipeline_layout_create_info.pSetLayouts = set_layouts;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create pipeline layout");
+    }
+
+    return pipeline_layout;
+}
+
+VkPipeline create_graphics_pipeline(VkDevice logical_device, VkPipelineCache pipeline_cache, VkRenderPass render_pass,
+    VkPipelineLayout pipeline_layout, VkShaderModule vertex_shader_module, VkShaderModule fragment_shader_module,
+    const pipeline_specialization& specialization, const pipeline_state& state, VkPipelineCreateFlags flags,
+    VkPipeline base_pipeline)
+{
+    SAMPLE_TRACE_SCOPE("create_graphics_pipeline");
+
+    // Fragment specialization constants, constant_id 0 selects flat color and 1 to 3 hold it
+    struct
+    {
+        VkBool32 flat_color;
+        float color[3];
+    } specialization_data = {specialization.flat_color ? VK_TRUE : VK_FALSE,
+        {specialization.color[0], specialization.color[1], specialization.color[2]}};
+
+    const VkSpecializationMapEntry specialization_entries[] = {
+        {0, offsetof(decltype(specialization_data), flat_color), sizeof(VkBool32)},
+        {1, offsetof(decltype(specialization_data), color) + 0 * sizeof(float), sizeof(float)},
+        {2, offsetof(decltype(specialization_data), color) + 1 * sizeof(float), sizeof(float)},
+        {3, offsetof(decltype(specialization_data), color) + 2 * sizeof(float), sizeof(float)}
+    };
+
+    VkSpecializationInfo specialization_info{};
+    specialization_info.mapEntryCount = 4;
+    specialization_info.pMapEntries = specialization_entries;
+    specialization_info.dataSize = sizeof(specialization_data);
+    specialization_info.pData = &specialization_data;
+
+    // Shader stage creation
+    VkPipelineShaderStageCreateInfo vertex_shader_stage_creation_info{};
+    vertex_shader_stage_creation_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertex_shader_stage_creation_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertex_shader_stage_creation_info.module = vertex_shader_module;
+    vertex_shader_stage_creation_info.pName = "main";
+
+    VkPipelineShaderStageCreateInfo fragment_shader_stage_creation_info{};
+    fragment_shader_stage_creation_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragment_shader_stage_creation_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragment_shader_stage_creation_info.module = fragment_shader_module;
+    fragment_shader_stage_creation_info.pName = "main";
+    fragment_shader_stage_creation_info.pSpecializationInfo = &specialization_info;
+
+    VkPipelineShaderStageCreateInfo shader_stages[] = {vertex_shader_stage_creation_info, fragment_shader_stage_creation_info};
+
+    // Dynamic state configuration, the viewport and scissor follow the framebuffer so the pipeline
+    // survives swapchain resizes
+    std::vector<VkDynamicState> dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamic_state_create_info{};
+    dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state_create_info.dynamicStateCount = dynamic_states.size();
+    dynamic_state_create_info.pDynamicStates = dynamic_states.data();
+
+    // Vertex input, per vertex positions and per instance offset, color and scale
+    const std::vector<VkVertexInputBindingDescription> bindings = vertex_input_bindings();
+    const std::vector<VkVertexInputAttributeDescription> attributes = vertex_input_attributes();
+
+    VkPipelineVertexInputStateCreateInfo vertex_input_state_create_info{};
+    vertex_input_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input_state_create_info.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+    vertex_input_state_create_info.pVertexBindingDescriptions = bindings.data();
+    vertex_input_state_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+    vertex_input_state_create_info.pVertexAttributeDescriptions = attributes.data();
+
+    // Input assembly
+    VkPipelineInputAssemblyStateCreateInfo input_assembly_state_create_info{};
+    input_assembly_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly_state_create_info.topology = state.topology;
+    input_assembly_state_create_info.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport state, set when the draws are recorded
+    VkPipelineViewportStateCreateInfo viewport_state_create_info{};
+    viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state_create_info.viewportCount = 1;
+    viewport_state_create_info.pViewports = nullptr;
+    viewport_state_create_info.scissorCount = 1;
+    viewport_state_create_info.pScissors = nullptr;
+
+    // Rasterizer
+    VkPipelineRasterizationStateCreateInfo rasterization_state_create_info{};
+    rasterization_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization_state_create_info.depthClampEnable = VK_FALSE;
+    rasterization_state_create_info.rasterizerDiscardEnable = VK_FALSE;
+    rasterization_state_create_info.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization_state_create_info.lineWidth = 1.0f;
+    rasterization_state_create_info.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterization_state_create_info.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterization_state_create_info.depthBiasEnable = VK_FALSE;
+    rasterization_state_create_info.depthBiasConstantFactor = 0.0f;
+    rasterization_state_create_info.depthBiasClamp = 0.0f;
+    rasterization_state_create_info.depthBiasSlopeFactor = 0.0f;
+
+    // Multisampling
+    VkPipelineMultisampleStateCreateInfo multisample_state_create_info{};
+    multisample_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample_state_create_info.sampleShadingEnable = VK_FALSE;
+    multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisample_state_create_info.minSampleShading = 1.0f;
+    multisample_state_create_info.pSampleMask = nullptr;
+    multisample_state_create_info.alphaToCoverageEnable = VK_FALSE;
+    multisample_state_create_info.alphaToOneEnable = VK_FALSE;
+
+    // Blending
+    VkPipelineColorBlendAttachmentState color_blend_attachment{};
+    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    color_blend_attachment.blendEnable = state.alpha_blend ? VK_TRUE : VK_FALSE;
+    color_blend_attachment.srcColorBlendFactor = state.alpha_blend ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.dstColorBlendFactor = state.alpha_blend ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+    color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo color_blend_state_create_info{};
+    color_blend_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color_blend_state_create_info.logicOpEnable = VK_FALSE;
+    color_blend_state_create_info.logicOp = VK_LOGIC_OP_COPY;
+    color_blend_state_create_info.attachmentCount = 1;
+    color_blend_state_create_info.pAttachments = &color_blend_attachment;
+    color_blend_state_create_info.blendConstants[0] = 0.0f;
+    color_blend_state_create_info.blendConstants[1] = 0.0f;
+    color_blend_state_create_info.blendConstants[2] = 0.0f;
+    color_blend_state_create_info.blendConstants[3] = 0.0f;
+
+    // Graphics pipeline
+    VkPipeline pipeline;
+    VkGraphicsPipelineCreateInfo pipeline_create_info{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_create_info.flags = flags;
+    pipeline_create_info.stageCount = 2;
+    pipeline_create_info.pStages = shader_stages;
+    pipeline_create_info.pVertexInputState = &vertex_input_state_create_info;
+    pipeline_create_info.pInputAssemblyState = &input_assembly_state_create_info;
+    pipeline_create_info.pViewportState = &viewport_state_create_info;
+    pipeline_create_info.pRasterizationState = &rasterization_state_create_info;
+    pipeline_create_info.pMultisampleState = &multisample_state_create_info;
+    pipeline_create_info.pDepthStencilState = nullptr;
+    pipeline_create_info.pColorBlendState = &color_blend_state_create_info;
+    pipeline_create_info.pDynamicState = &dynamic_state_create_info;
+    pipeline_create_info.layout = pipeline_layout;
+    pipeline_create_info.renderPass = render_pass;
+    pipeline_create_info.subpass = 0;
+    pipeline_create_info.basePipelineHandle = base_pipeline;
+    pipeline_create_info.basePipelineIndex = -1;
+
+    if (vkCreateGraphicsPipelines(logical_device, pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create graphics pipeline");
+    }
+
+    return pipeline;
+}
+
+VkPipelineLayout create_post_pipeline_layout(VkDevice logical_device, VkDescriptorSetLayout input_set_layout)
+{
+    VkPipelineLayout pipeline_layout;
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &input_set_layout;
+
+    if (vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create post-processing pipeline layout");
+    }
+
+    return pipeline_layout;
+}
+
+VkPipeline create_post_pipeline(VkDevice logical_device, VkPipelineCache pipeline_cache, VkRenderPass render_pass,
+    uint32_t subpass, VkPipelineLayout pipeline_layout, VkShaderModule vertex_shader_module,
+    VkShaderModule fragment_shader_module)
+{
+    VkPipelineShaderStageCreateInfo shader_stages[2] = {};
+    shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shader_stages[0].module = vertex_shader_module;
+    shader_stages[0].pName = "main";
+    shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shader_stages[1].module = fragment_shader_module;
+    shader_stages[1].pName = "main";
+
+    const VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamic_state_create_info{};
+    dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state_create_info.dynamicStateCount = 2;
+    dynamic_state_create_info.pDynamicStates = dynamic_states;
+
+    // The full screen triangle is generated from the vertex index, there are no vertex buffers
+    VkPipelineVertexInputStateCreateInfo vertex_input_state_create_info{};
+    vertex_input_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly_state_create_info{};
+    input_assembly_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewport_state_create_info{};
+    viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state_create_info.viewportCount = 1;
+    viewport_state_create_info.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterization_state_create_info{};
+    rasterization_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization_state_create_info.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization_state_create_info.lineWidth = 1.0f;
+    rasterization_state_create_info.cullMode = VK_CULL_MODE_NONE;
+    rasterization_state_create_info.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisample_state_create_info{};
+    multisample_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisample_state_create_info.minSampleShading = 1.0f;
+
+    VkPipelineColorBlendAttachmentState color_blend_attachment{};
+    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    color_blend_attachment.blendEnable = VK_FALSE;
+
+    VkPipelineColorBlendStateCreateInfo color_blend_state_create_info{};
+    color_blend_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color_blend_state_create_info.attachmentCount = 1;
+    color_blend_state_create_info.pAttachments = &color_blend_attachment;
+
+    VkPipeline pipeline;
+    VkGraphicsPipelineCreateInfo pipeline_create_info{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_create_info.stageCount = 2;
+    pipeline_create_info.pStages = shader_stages;
+    pipeline_create_info.pVertexInputState = &vertex_input_state_create_info;
+    pipeline_create_info.pInputAssemblyState = &input_assembly_state_create_info;
+    pipeline_create_info.pViewportState = &viewport_state_create_info;
+    pipeline_create_info.pRasterizationState = &rasterization_state_create_info;
+    pipeline_create_info.pMultisampleState = &multisample_state_create_info;
+    pipeline_create_info.pColorBlendState = &color_blend_state_create_info;
+    pipeline_create_info.pDynamicState = &dynamic_state_create_info;
+    pipeline_create_info.layout = pipeline_layout;
+    pipeline_create_info.renderPass = render_pass;
+    pipeline_create_info.subpass = subpass;
+    pipeline_create_info.basePipelineIndex = -1;
+
+    if (vkCreateGraphicsPipelines(logical_device, pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create post-processing pipeline");
+    }
+
+    return pipeline;
+}
+
+void set_viewport(VkCommandBuffer command_buffer, VkExtent2D extent)
+{
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
+
+void record_draws(VkCommandBuffer command_buffer, VkPipeline pipeline, VkExtent2D extent, const scene_geometry& geometry,
+    uint32_t first_instance, uint32_t instance_count)
+{
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    set_viewport(command_buffer, extent);
+
+    VkBuffer vertex_buffers[] = {geometry.vertices.buffer, geometry.instances.buffer};
+    VkDeviceSize vertex_offsets[] = {0, 0};
+    vkCmdBindVertexBuffers(command_buffer, 0, 2, vertex_buffers, vertex_offsets);
+    vkCmdBindIndexBuffer(command_buffer, geometry.indices.buffer, 0, VK_INDEX_TYPE_UINT16);
+
+    // The frame set is bound at the slot's offset into the uniform ring, so the descriptor itself never changes
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, geometry.pipeline_layout, 0, 1,
+        &geometry.frame_set, 1, &geometry.frame_offset);
+
+    if (geometry.texture_set != VK_NULL_HANDLE)
+    {
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, geometry.pipeline_layout, 1, 1,
+            &geometry.texture_set, 0, nullptr);
+    }
+
+    vkCmdPushConstants(command_buffer, geometry.pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+        sizeof(geometry.constants), &geometry.constants);
+
+    if (geometry.indirect_commands != VK_NULL_HANDLE)
+    {
+        // GPU culled, one command per visible instance or a single instanced command
+        const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+        if (!geometry.draw_per_object)
+        {
+            vkCmdDrawIndexedIndirect(command_buffer, geometry.indirect_commands, 0, 1, stride);
+        }
+        else if (geometry.draw_indexed_indirect_count != nullptr)
+        {
+            geometry.draw_indexed_indirect_count(command_buffer, geometry.indirect_commands, 0, geometry.indirect_count, 0,
+                geometry.instance_count, stride);
+        }
+        else
+        {
+            // Commands past the visible count were cleared to zero instances
+            vkCmdDrawIndexedIndirect(command_buffer, geometry.indirect_commands, 0, geometry.instance_count, stride);
+        }
+    }
+    else if (geometry.draw_per_object)
+    {
+        // Baseline for draw call overhead, the same work split into one draw per instance
+        for (uint32_t i = first_instance; i < first_instance + instance_count; ++i)
+        {
+            vkCmdDrawIndexed(command_buffer, geometry.index_count, 1, 0, 0, i);
+        }
+    }
+    else
+    {
+        vkCmdDrawIndexed(command_buffer, geometry.index_count, instance_count, 0, 0, first_instance);
+    }
+}
+
+// Begins the command buffer and the render pass, with the frame's timestamp written first
+static void begin_frame(VkCommandBuffer command_buffer, VkRenderPass render_pass, VkFramebuffer framebuffer,
+    VkExtent2D extent, VkSubpassContents contents, gpu_timer* timer, uint32_t timer_slot, const render_graph* graph)
+{
+    // Command buffer recording
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = 0;
+    command_buffer_begin_info.pInheritanceInfo = nullptr;
+
+    if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to begin recording command buffer");
+    }
+
+    if (timer != nullptr)
+    {
+        timer->reset(command_buffer, timer_slot);
+        timer->begin_pass(command_buffer, timer_slot, timer_pass_main);
+    }
+
+    // Render pass start
+    VkRenderPassBeginInfo render_pass_begin_info{};
+    render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    render_pass_begin_info.renderPass = render_pass;
+    render_pass_begin_info.framebuffer = framebuffer;
+    render_pass_begin_info.renderArea.offset = {0, 0};
+    render_pass_begin_info.renderArea.extent = extent;
+
+    // Every attachment the graph clears in the first render pass starts black
+    const std::vector<VkClearValue> clear_values(graph != nullptr ? graph->attachment_count(0) : 1,
+        {{{0.0f, 0.0f, 0.0f, 1.0f}}});
+    render_pass_begin_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+    render_pass_begin_info.pClearValues = clear_values.data();
+
+    vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, contents);
+}
+
+static void record_blit(VkCommandBuffer command_buffer, const frame_blit& blit)
+{
+    VkImageMemoryBarrier image_barriers[2]{};
+
+    // The render pass already left the source in TRANSFER_SRC_OPTIMAL, only its writes need to be made visible
+    image_barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    image_barriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    image_barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    image_barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    image_barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    image_barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barriers[0].image = blit.source;
+    image_barriers[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    // The destination's previous contents are discarded, the transition waits on the acquire
+    // semaphore through the color attachment output stage the submission waits at
+    image_barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    image_barriers[1].srcAccessMask = 0;
+    image_barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    image_barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    image_barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barriers[1].image = blit.destination;
+    image_barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 2, image_barriers);
+
+    VkImageBlit region{};
+    region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.srcOffsets[1] = {static_cast<int32_t>(blit.source_extent.width), static_cast<int32_t>(blit.source_extent.height), 1};
+    region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.dstOffsets[1] = {static_cast<int32_t>(blit.destination_extent.width),
+        static_cast<int32_t>(blit.destination_extent.height), 1};
+
+    vkCmdBlitImage(command_buffer, blit.source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, blit.destination,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, blit.filter);
+
+    // Presentation waits on the frame's semaphore, which needs no access mask
+    VkImageMemoryBarrier present_barrier = image_barriers[1];
+    present_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    present_barrier.dstAccessMask = 0;
+    present_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    present_barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &present_barrier);
+}
+
+static void end_frame(VkCommandBuffer command_buffer, gpu_timer* timer, uint32_t timer_slot, const render_graph* graph,
+    uint32_t graph_frame, const frame_blit* blit)
+{
+    if (graph != nullptr)
+    {
+        graph->record_remaining(command_buffer, graph_frame);
+    }
+    else
+    {
+        vkCmdEndRenderPass(command_buffer);
+    }
+
+    if (blit != nullptr)
+    {
+        record_blit(command_buffer, *blit);
+    }
+
+    if (timer != nullptr)
+    {
+        timer->end_pass(command_buffer, timer_slot, timer_pass_main);
+    }
+
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to record command buffer");
+    }
+}
+
+void record_frame(VkCommandBuffer command_buffer, VkRenderPass render_pass, VkFramebuffer framebuffer,
+    VkExtent2D extent, VkPipeline pipeline, const scene_geometry& geometry, gpu_timer* timer, uint32_t timer_slot,
+    const render_graph* graph, uint32_t graph_frame, const frame_blit* blit)
+{
+    begin_frame(command_buffer, render_pass, framebuffer, extent, VK_SUBPASS_CONTENTS_INLINE, timer, timer_slot, graph);
+    record_draws(command_buffer, pipeline, extent, geometry, 0, geometry.instance_count);
+    end_frame(command_buffer, timer, timer_slot, graph, graph_frame, blit);
+}
+
+void record_frame(VkCommandBuffer command_buffer, VkRenderPass render_pass, VkFramebuffer framebuffer,
+    VkExtent2D extent, const std::vector<VkCommandBuffer>& secondary_command_buffers, gpu_timer* timer,
+    uint32_t timer_slot, const render_graph* graph, uint32_t graph_frame, const frame_blit* blit)
+{
+    begin_frame(command_buffer, render_pass, framebuffer, extent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+        timer, timer_slot, graph);
+    vkCmdExecuteCommands(command_buffer, static_cast<uint32_t>(secondary_command_buffers.size()),
+        secondary_command_buffers.data());
+    end_frame(command_buffer, timer, timer_slot, graph, graph_frame, blit);
+}
@@ -0,0 +1,99 @@
+#ifndef _RENDERER_HPP_
+#define _RENDERER_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "geometry.hpp"
+#include "gpu_timer.hpp"
+#include "render_graph.hpp"
+
+#include <string>
+#include <vector>
+
+// Render pass, pipeline and command recording shared by the windowed and headless paths
+
+// Passes timed by record_frame, indexed by the timer_pass constants
+extern const std::vector<std::string> timed_pass_names;
+const uint32_t timer_pass_main = 0;
+
+// Specialization constants of the graphics pipeline, matching the constant_id values in shader.frag
+struct pipeline_specialization
+{
+    // Draws every instance in color instead of its per instance color
+    bool flat_color = false;
+    float color[3] = {1.0f, 1.0f, 1.0f};
+};
+
+// Fixed function state a pipeline permutation may change besides its specialization constants
+struct pipeline_state
+{
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    // Source alpha blending instead of overwriting the color attachment
+    bool alpha_blend = false;
+};
+
+// Copy of the top left source_extent of an image the frame rendered into, left in
+// TRANSFER_SRC_OPTIMAL by the render pass, scaled to cover a presentable image
+struct frame_blit
+{
+    VkImage source = VK_NULL_HANDLE;
+    VkExtent2D source_extent{};
+    VkImage destination = VK_NULL_HANDLE;
+    VkExtent2D destination_extent{};
+    VkFilter filter = VK_FILTER_LINEAR;
+};
+
+std::vector<uint32_t> read_shader(const std::string& path);
+
+VkShaderModule create_shader_module(VkDevice logical_device, const uint32_t* code, size_t size);
+
+// Creates a module from the SPIR-V built into the executable, or from shader_directory/name when
+// a directory is given so shaders can be rebuilt without relinking
+VkShaderModule load_shader_module(VkDevice logical_device, const std::string& name, const std::string& shader_directory);
+
+// The frame uniforms are bound at set 0 and texture_set_layout, when given, at set 1 for the
+// textured pipeline. draw_constants are pushed to the fragment stage.
+VkPipelineLayout create_pipeline_layout(VkDevice logical_device, VkDescriptorSetLayout frame_set_layout,
+    VkDescriptorSetLayout texture_set_layout = VK_NULL_HANDLE);
+
+// flags and base_pipeline select pipeline derivatives, base_pipeline must have been created with
+// VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT when flags has VK_PIPELINE_CREATE_DERIVATIVE_BIT
+VkPipeline create_graphics_pipeline(VkDevice logical_device, VkPipelineCache pipeline_cache, VkRenderPass render_pass,
+    VkPipelineLayout pipeline_layout, VkShaderModule vertex_shader_module, VkShaderModule fragment_shader_module,
+    const pipeline_specialization& specialization = {}, const pipeline_state& state = {}, VkPipelineCreateFlags flags = 0,
+    VkPipeline base_pipeline = VK_NULL_HANDLE);
+
+// Post-processing passes read the previous pass through the render graph's set at set 0
+VkPipelineLayout create_post_pipeline_layout(VkDevice logical_device, VkDescriptorSetLayout input_set_layout);
+
+// Full screen triangle without vertex input, for a pass at subpass of render_pass
+VkPipeline create_post_pipeline(VkDevice logical_device, VkPipelineCache pipeline_cache, VkRenderPass render_pass,
+    uint32_t subpass, VkPipelineLayout pipeline_layout, VkShaderModule vertex_shader_module,
+    VkShaderModule fragment_shader_module);
+
+// Sets the dynamic viewport and scissor to cover extent
+void set_viewport(VkCommandBuffer command_buffer, VkExtent2D extent);
+
+// Binds the pipeline and geometry and draws a range of instances over extent, inside an already
+// begun render pass
+void record_draws(VkCommandBuffer command_buffer, VkPipeline pipeline, VkExtent2D extent, const scene_geometry& geometry,
+    uint32_t first_instance, uint32_t instance_count);
+
+// Records a full frame, from render pass begin to command buffer end, with timestamps written to
+// the timer slot when a timer is given. The draws are the first pass of graph when one is given,
+// and its remaining passes are recorded with the graph_frame images after them. A blit, when
+// given, is recorded last and leaves its destination ready to present.
+void record_frame(VkCommandBuffer command_buffer, VkRenderPass render_pass, VkFramebuffer framebuffer,
+    VkExtent2D extent, VkPipeline pipeline, const scene_geometry& geometry, gpu_timer* timer = nullptr,
+    uint32_t timer_slot = 0, const render_graph* graph = nullptr, uint32_t graph_frame = 0,
+    const frame_blit* blit = nullptr);
+
+// Same as above, with the draws recorded beforehand into secondary command buffers
+void record_frame(VkCommandBuffer command_buffer, VkRenderPass render_pass, VkFramebuffer framebuffer,
+    VkExtent2D extent, const std::vector<VkCommandBuffer>& secondary_command_buffers, gpu_timer* timer = nullptr,
+    uint32_t timer_slot = 0, const render_graph* graph = nullptr, uint32_t graph_frame = 0,
+    const frame_blit* blit = nullptr);
+
+#endif
@@ -0,0 +1,70 @@
+#include "shader_watcher.hpp"
+
+#include <sys/stat.h>
+
+void shader_watcher::create(const std::string& directory, const std::vector<std::string>& names,
+    std::chrono::milliseconds interval)
+{
+    paths.clear();
+
+    if (directory.empty())
+    {
+        return;
+    }
+
+    for (const std::string& name : names)
+    {
+        paths.push_back(directory + "/" + name);
+    }
+
+    poll_interval = interval;
+    next_poll = std::chrono::steady_clock::now() + poll_interval;
+    loaded_times = modification_times();
+    pending_times.clear();
+}
+
+bool shader_watcher::changed()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    if (paths.empty() || now < next_poll)
+    {
+        return false;
+    }
+
+    next_poll = now + poll_interval;
+    const std::vector<int64_t> times = modification_times();
+
+    if (times == loaded_times)
+    {
+        pending_times.clear();
+        return false;
+    }
+
+    // Seen for the first time, or still changing, so wait for another interval
+    if (times != pending_times)
+    {
+        pending_times = times;
+        return false;
+    }
+
+    loaded_times = times;
+    pending_times.clear();
+    return true;
+}
+
+std::vector<int64_t> shader_watcher::modification_times() const
+{
+    std::vector<int64_t> times;
+
+    for (const std::string& path : paths)
+    {
+        struct stat file_status;
+
+        times.push_back(stat(path.c_str(), &file_status) == 0
+            ? static_cast<int64_t>(file_status.st_mtim.tv_sec) * 1000000000 + file_status.st_mtim.tv_nsec
+            : -1);
+    }
+
+    return times;
+}
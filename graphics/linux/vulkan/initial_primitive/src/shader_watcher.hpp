@@ -0,0 +1,34 @@
+#ifndef _SHADER_WATCHER_HPP_
+#define _SHADER_WATCHER_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Polls the modification times of SPIR-V files in the --shader-dir directory, so the windowed
+// loop can rebuild its pipeline when they are recompiled. A change is only reported once the
+// files have stayed the same for a whole poll interval, so a file glslc is still writing is never
+// picked up half way.
+class shader_watcher
+{
+public:
+    // Watches nothing, and never reports a change, when directory is empty
+    void create(const std::string& directory, const std::vector<std::string>& names,
+        std::chrono::milliseconds interval = std::chrono::milliseconds(250));
+
+    // True once per settled change, checks the files at most once per interval
+    bool changed();
+
+private:
+    // Nanoseconds since the epoch, -1 for a file that cannot be read
+    std::vector<int64_t> modification_times() const;
+
+    std::vector<std::string> paths;
+    std::vector<int64_t> loaded_times;
+    std::vector<int64_t> pending_times;
+    std::chrono::milliseconds poll_interval{0};
+    std::chrono::steady_clock::time_point next_poll;
+};
+
+#endif
@@ -0,0 +1,14 @@
+#version 450
+
+// Previous pass of the render graph, read at the same pixel from tile memory where possible
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput previousPass;
+
+layout(location = 0) in vec2 fragPosition;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Vignette, darkening towards the corners
+    float falloff = 1.0 - 0.25 * dot(fragPosition, fragPosition);
+    outColor = vec4(subpassLoad(previousPass).rgb * falloff, 1.0);
+}
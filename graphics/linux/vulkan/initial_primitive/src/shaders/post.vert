@@ -0,0 +1,10 @@
+#version 450
+
+// Full screen triangle covering clip space, generated from the vertex index
+layout(location = 0) out vec2 fragPosition;
+
+void main() {
+    vec2 position = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2) * 2.0 - 1.0;
+    fragPosition = position;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
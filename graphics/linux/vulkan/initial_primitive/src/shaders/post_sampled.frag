@@ -0,0 +1,14 @@
+#version 450
+
+// Previous pass of the render graph, sampled after its render pass has ended
+layout(set = 0, binding = 0) uniform sampler2D previousPass;
+
+layout(location = 0) in vec2 fragPosition;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Vignette, darkening towards the corners
+    float falloff = 1.0 - 0.25 * dot(fragPosition, fragPosition);
+    outColor = vec4(texelFetch(previousPass, ivec2(gl_FragCoord.xy), 0).rgb * falloff, 1.0);
+}
@@ -1,7 +1,20 @@
 #version 450
 
+// Specialization constants, set through pipeline_specialization when the pipeline is created
+layout(constant_id = 0) const bool flatColor = false;
+layout(constant_id = 1) const float flatRed = 1.0;
+layout(constant_id = 2) const float flatGreen = 1.0;
+layout(constant_id = 3) const float flatBlue = 1.0;
+
+// Pushed per draw, see draw_constants
+layout(push_constant) uniform Draw {
+    vec4 tint;
+} draw;
+
+layout(location = 0) in vec3 fragColor;
+
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(1.0, 0.0, 0.0, 1.0);
+    outColor = vec4(flatColor ? vec3(flatRed, flatGreen, flatBlue) : fragColor, 1.0) * draw.tint;
 }
\ No newline at end of file
@@ -1,11 +1,25 @@
 #version 450
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+layout(location = 0) in vec2 inPosition;
+
+layout(location = 1) in vec2 instanceOffset;
+layout(location = 2) in vec3 instanceColor;
+layout(location = 3) in float instanceScale;
+
+// Written once per frame into the uniform ring, see frame_uniforms
+layout(set = 0, binding = 0) uniform Frame {
+    float rotation;
+} frame;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    float c = cos(frame.rotation);
+    float s = sin(frame.rotation);
+    vec2 rotated = mat2(c, s, -s, c) * inPosition;
+
+    gl_Position = vec4(rotated * instanceScale + instanceOffset, 0.0, 1.0);
+    fragColor = instanceColor;
+    fragTexCoord = inPosition + 0.5;
 }
@@ -0,0 +1,17 @@
+#version 450
+
+layout(set = 1, binding = 0) uniform sampler2D textureSampler;
+
+// Pushed per draw, see draw_constants
+layout(push_constant) uniform Draw {
+    vec4 tint;
+} draw;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(textureSampler, fragTexCoord) * vec4(fragColor, 1.0) * draw.tint;
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "swapchain.hpp"
+
+#include "sample_trace.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+VkExtent2D select_extent(VkPhysicalDevice physical_device, VkSurfaceKHR surface, GLFWwindow* window)
+{
+    VkSurfaceCapabilitiesKHR surface_capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &surface_capabilities);
+
+    if (surface_capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+    {
+        return surface_capabilities.currentExtent;
+    }
+
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+
+    if (width == 0 || height == 0)
+    {
+        return VkExtent2D{0, 0};
+    }
+
+    return VkExtent2D{
+        std::clamp(static_cast<uint32_t>(width), surface_capabilities.minImageExtent.width, surface_capabilities.maxImageExtent.width),
+        std::clamp(static_cast<uint32_t>(height), surface_capabilities.minImageExtent.height, surface_capabilities.maxImageExtent.height)
+    };
+}
+
+swapchain_context create_swapchain(const device_context& device, VkSurfaceKHR surface, const swapchain_settings& settings,
+    VkExtent2D extent, VkRenderPass render_pass, VkSwapchainKHR old_swapchain)
+{
+    SAMPLE_TRACE_SCOPE("create_swapchain");
+    VkDevice logical_device = device.logical_device;
+
+    VkSurfaceCapabilitiesKHR surface_capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.physical_device, surface, &surface_capabilities);
+
+    if ((surface_capabilities.supportedUsageFlags & settings.image_usage) != settings.image_usage)
+    {
+        throw std::runtime_error("Swapchain images do not support the requested usage");
+    }
+
+    // Swapchain creation
+    VkSwapchainCreateInfoKHR swapchain_create_info{};
+    swapchain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    swapchain_create_info.surface = surface;
+    swapchain_create_info.minImageCount = surface_capabilities.minImageCount;
+
+    if (settings.requested_images != 0)
+    {
+        const uint32_t max_image_count = surface_capabilities.maxImageCount == 0
+            ? std::numeric_limits<uint32_t>::max()
+            : surface_capabilities.maxImageCount;
+
+        swapchain_create_info.minImageCount = std::clamp(settings.requested_images, surface_capabilities.minImageCount, max_image_count);
+    }
+
+    swapchain_create_info.imageFormat = settings.surface_format.format;
+    swapchain_create_info.imageColorSpace = settings.surface_format.colorSpace;
+    swapchain_create_info.imageExtent = extent;
+    swapchain_create_info.imageArrayLayers = 1;
+    swapchain_create_info.imageUsage = settings.image_usage;
+    swapchain_create_info.preTransform = surface_capabilities.currentTransform;
+    swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    swapchain_create_info.presentMode = settings.present_mode;
+    swapchain_create_info.clipped = VK_TRUE;
+    swapchain_create_info.oldSwapchain = old_swapchain;
+
+    const uint32_t queue_family_indices[] = {device.graphics_queue_index, device.present_queue_index.value()};
+
+    if (queue_family_indices[0] == queue_family_indices[1])
+    {
+        swapchain_create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        swapchain_create_info.queueFamilyIndexCount = 0;
+        swapchain_create_info.pQueueFamilyIndices = nullptr;
+    }
+    else
+    {
+        swapchain_create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+        swapchain_create_info.queueFamilyIndexCount = 2;
+        swapchain_create_info.pQueueFamilyIndices = queue_family_indices;
+    }
+
+    swapchain_context swapchain;
+    swapchain.extent = extent;
+
+    if (vkCreateSwapchainKHR(logical_device, &swapchain_create_info, nullptr, &swapchain.swapchain) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create swapchain");
+    }
+
+    // Image retrieval
+    uint32_t image_count;
+    vkGetSwapchainImagesKHR(logical_device, swapchain.swapchain, &image_count, nullptr);
+    swapchain.images.resize(image_count);
+    vkGetSwapchainImagesKHR(logical_device, swapchain.swapchain, &image_count, swapchain.images.data());
+    swapchain.image_views.resize(image_count);
+    swapchain.framebuffers.resize(image_count);
+
+    for (uint32_t i = 0; i < image_count; ++i)
+    {
+        VkImageViewCreateInfo image_view_create_info{};
+        image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        image_view_create_info.image = swapchain.images[i];
+        image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        image_view_create_info.format = settings.surface_format.format;
+        image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        image_view_create_info.subresourceRange.baseMipLevel = 0;
+        image_view_create_info.subresourceRange.levelCount = 1;
+        image_view_create_info.subresourceRange.baseArrayLayer = 0;
+        image_view_create_info.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(logical_device, &image_view_create_info, nullptr, &swapchain.image_views[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create image view");
+        }
+
+        VkImageView attachments[] = {
+            swapchain.image_views[i]
+        };
+
+        VkFramebufferCreateInfo framebuffer_create_info{};
+        framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_create_info.renderPass = render_pass;
+        framebuffer_create_info.attachmentCount = 1;
+        framebuffer_create_info.pAttachments = attachments;
+        framebuffer_create_info.width = extent.width;
+        framebuffer_create_info.height = extent.height;
+        framebuffer_create_info.layers = 1;
+
+        if (vkCreateFramebuffer(logical_device, &framebuffer_create_info, nullptr, &swapchain.framebuffers[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create framebuffer");
+        }
+    }
+
+    return swapchain;
+}
+
+void destroy_swapchain(VkDevice logical_device, swapchain_context& swapchain)
+{
+    for (VkFramebuffer framebuffer : swapchain.framebuffers)
+    {
+        vkDestroyFramebuffer(logical_device, framebuffer, nullptr);
+    }
+
+    for (VkImageView image_view : swapchain.image_views)
+    {
+        vkDestroyImageView(logical_device, image_view, nullptr);
+    }
+
+    vkDestroySwapchainKHR(logical_device, swapchain.swapchain, nullptr);
+    swapchain = swapchain_context{};
+}
@@ -0,0 +1,47 @@
+#ifndef _SWAPCHAIN_HPP_
+#define _SWAPCHAIN_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+
+#include <vector>
+
+// Swapchain with a view and framebuffer per image, created at startup and again on every resize
+struct swapchain_context
+{
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    VkExtent2D extent{};
+    std::vector<VkImage> images;
+    std::vector<VkImageView> image_views;
+    std::vector<VkFramebuffer> framebuffers;
+};
+
+// Surface properties fixed for the lifetime of the window
+struct swapchain_settings
+{
+    VkSurfaceFormatKHR surface_format{};
+    VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+
+    // Requested minImageCount, zero uses the surface minimum
+    uint32_t requested_images = 0;
+
+    // Usage of the swapchain images, TRANSFER_DST when frames are blitted into them
+    VkImageUsageFlags image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+};
+
+// The surface's current extent, or the window's framebuffer size clamped to what the surface
+// allows when the surface leaves the extent to the swapchain. Zero while the window is minimized.
+VkExtent2D select_extent(VkPhysicalDevice physical_device, VkSurfaceKHR surface, GLFWwindow* window);
+
+// Creates the swapchain, views and framebuffers for extent. old_swapchain, when given, is handed to
+// the presentation engine so it can reuse resources and keep presenting while the new images are
+// created. It is retired either way and must be destroyed by the caller.
+swapchain_context create_swapchain(const device_context& device, VkSurfaceKHR surface, const swapchain_settings& settings,
+    VkExtent2D extent, VkRenderPass render_pass, VkSwapchainKHR old_swapchain);
+
+// Destroys the framebuffers, views and swapchain, none of which may still be in use
+void destroy_swapchain(VkDevice logical_device, swapchain_context& swapchain);
+
+#endif
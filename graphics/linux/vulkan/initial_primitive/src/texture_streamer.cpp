@@ -0,0 +1,612 @@
+#include "texture_streamer.hpp"
+#include "frame_statistics.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Multiple of 4 and of every texel or block size up to 16 bytes, including 3, 6 and 12 byte
+// formats, as vkCmdCopyBufferToImage requires of bufferOffset
+static const VkDeviceSize staging_alignment = 48;
+
+static const unsigned char ktx2_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// Header fields following the identifier and the data format and key/value offsets of the index.
+// The supercompression global data offsets come next and are unused without supercompression.
+struct ktx2_header
+{
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+};
+
+// The level index follows the identifier, header and index
+static const size_t ktx2_level_index_offset = 80;
+
+struct ktx2_level_index
+{
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+};
+
+// Texel block of a format, one texel for uncompressed formats, zero bytes when unknown
+struct texel_block
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytes;
+};
+
+// Relies on the core formats being numbered in the order of the specification
+static texel_block format_texel_block(VkFormat format)
+{
+    const auto in = [format](VkFormat first, VkFormat last) { return format >= first && format <= last; };
+
+    if (format == VK_FORMAT_R4G4_UNORM_PACK8 || in(VK_FORMAT_R8_UNORM, VK_FORMAT_R8_SRGB))
+    {
+        return {1, 1, 1};
+    }
+
+    if (in(VK_FORMAT_R4G4B4A4_UNORM_PACK16, VK_FORMAT_A1R5G5B5_UNORM_PACK16) || in(VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8_SRGB) ||
+        in(VK_FORMAT_R16_UNORM, VK_FORMAT_R16_SFLOAT))
+    {
+        return {1, 1, 2};
+    }
+
+    if (in(VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_B8G8R8_SRGB))
+    {
+        return {1, 1, 3};
+    }
+
+    if (in(VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_A2B10G10R10_SINT_PACK32) || in(VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16_SFLOAT) ||
+        in(VK_FORMAT_R32_UINT, VK_FORMAT_R32_SFLOAT) || in(VK_FORMAT_B10G11R11_UFLOAT_PACK32, VK_FORMAT_E5B9G9R9_UFLOAT_PACK32))
+    {
+        return {1, 1, 4};
+    }
+
+    if (in(VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16_SFLOAT))
+    {
+        return {1, 1, 6};
+    }
+
+    if (in(VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT) || in(VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32_SFLOAT))
+    {
+        return {1, 1, 8};
+    }
+
+    if (in(VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32_SFLOAT))
+    {
+        return {1, 1, 12};
+    }
+
+    if (in(VK_FORMAT_R32G32B32A32_UINT, VK_FORMAT_R32G32B32A32_SFLOAT))
+    {
+        return {1, 1, 16};
+    }
+
+    if (in(VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGBA_SRGB_BLOCK) || in(VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_BC4_SNORM_BLOCK) ||
+        in(VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK) ||
+        in(VK_FORMAT_EAC_R11_UNORM_BLOCK, VK_FORMAT_EAC_R11_SNORM_BLOCK))
+    {
+        return {4, 4, 8};
+    }
+
+    if (in(VK_FORMAT_BC2_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK) || in(VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK) ||
+        in(VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK) ||
+        in(VK_FORMAT_EAC_R11G11_UNORM_BLOCK, VK_FORMAT_EAC_R11G11_SNORM_BLOCK))
+    {
+        return {4, 4, 16};
+    }
+
+    // ASTC formats come in UNORM and SRGB pairs, one pair per block size
+    if (in(VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_12x12_SRGB_BLOCK))
+    {
+        static const uint32_t astc_blocks[][2] = {
+            {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8}, {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12}
+        };
+        const uint32_t* block = astc_blocks[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+
+        return {block[0], block[1], 16};
+    }
+
+    return {0, 0, 0};
+}
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkDescriptorSetLayout create_texture_set_layout(VkDevice logical_device)
+{
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = 1;
+    descriptor_set_layout_create_info.pBindings = &binding;
+
+    VkDescriptorSetLayout set_layout;
+
+    if (vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &set_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create texture descriptor set layout");
+    }
+
+    return set_layout;
+}
+
+void texture_streamer::map_file(const std::string& path)
+{
+    const int descriptor = open(path.c_str(), O_RDONLY);
+
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("Unable to open texture: " + path);
+    }
+
+    struct stat file_status;
+
+    if (fstat(descriptor, &file_status) != 0 || file_status.st_size == 0)
+    {
+        close(descriptor);
+        throw std::runtime_error("Unable to read texture size: " + path);
+    }
+
+    file_size = static_cast<size_t>(file_status.st_size);
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+    // The mapping keeps its own reference to the file
+    close(descriptor);
+
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Unable to map texture: " + path);
+    }
+
+    // KTX2 stores the smallest level first, so streaming coarsest first walks the file forwards
+    madvise(mapping, file_size, MADV_SEQUENTIAL);
+    file_data = static_cast<const unsigned char*>(mapping);
+}
+
+void texture_streamer::parse_header()
+{
+    ktx2_header header;
+    const size_t level_index_offset = ktx2_level_index_offset;
+
+    if (file_size < level_index_offset || std::memcmp(file_data, ktx2_identifier, sizeof(ktx2_identifier)) != 0)
+    {
+        throw std::runtime_error("Texture is not a KTX2 file");
+    }
+
+    // Copied out, the mapping gives no alignment guarantees for the fields
+    std::memcpy(&header, file_data + sizeof(ktx2_identifier), sizeof(header));
+
+    if (header.vk_format == VK_FORMAT_UNDEFINED || header.supercompression_scheme != 0)
+    {
+        throw std::runtime_error("Only KTX2 textures without supercompression are supported");
+    }
+
+    if (header.pixel_height == 0 || header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1)
+    {
+        throw std::runtime_error("Only single 2D KTX2 textures are supported");
+    }
+
+    if (header.level_count == 0)
+    {
+        throw std::runtime_error("KTX2 texture must contain precomputed mip levels");
+    }
+
+    if (file_size < level_index_offset + header.level_count * sizeof(ktx2_level_index))
+    {
+        throw std::runtime_error("KTX2 level index is truncated");
+    }
+
+    format = static_cast<VkFormat>(header.vk_format);
+    const texel_block block = format_texel_block(format);
+
+    if (block.bytes == 0)
+    {
+        throw std::runtime_error("KTX2 texture format " + std::to_string(header.vk_format) + " is not supported");
+    }
+
+    levels.resize(header.level_count);
+
+    for (uint32_t i = 0; i < header.level_count; ++i)
+    {
+        ktx2_level_index level_index;
+        std::memcpy(&level_index, file_data + level_index_offset + i * sizeof(level_index), sizeof(level_index));
+
+        if (level_index.byte_length == 0 || level_index.byte_offset > file_size ||
+            level_index.byte_length > file_size - level_index.byte_offset)
+        {
+            throw std::runtime_error("KTX2 level " + std::to_string(i) + " lies outside the file");
+        }
+
+        levels[i].offset = level_index.byte_offset;
+        levels[i].size = level_index.byte_length;
+        levels[i].width = std::max(1u, header.pixel_width >> i);
+        levels[i].height = std::max(1u, header.pixel_height >> i);
+
+        // Copies are tightly packed, a level of any other size would be read past its staging segment
+        const uint64_t expected_size = uint64_t{(levels[i].width + block.width - 1) / block.width} *
+            ((levels[i].height + block.height - 1) / block.height) * block.bytes;
+
+        if (level_index.byte_length != expected_size)
+        {
+            throw std::runtime_error("KTX2 level " + std::to_string(i) + " holds " + std::to_string(level_index.byte_length) +
+                " bytes, its extent and format need " + std::to_string(expected_size));
+        }
+    }
+}
+
+void texture_streamer::create(const device_context& device, memory_allocator& memory, const std::string& path,
+    VkDescriptorSetLayout set_layout, uint32_t slot_count, VkDeviceSize budget)
+{
+    load_start = std::chrono::steady_clock::now();
+    allocator = &memory;
+    logical_device = device.logical_device;
+    frame_budget = budget;
+
+    map_file(path);
+    parse_header();
+
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(device.physical_device, format, &format_properties);
+
+    if (!(format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+    {
+        throw std::runtime_error("Texture format cannot be sampled on this device");
+    }
+
+    const bool linear_filtering = format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    const uint32_t level_count = static_cast<uint32_t>(levels.size());
+
+    // Image with every level, each level is undefined until its upload transitions it
+    VkImageCreateInfo image_create_info{};
+    image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_create_info.imageType = VK_IMAGE_TYPE_2D;
+    image_create_info.format = format;
+    image_create_info.extent = {levels[0].width, levels[0].height, 1};
+    image_create_info.mipLevels = level_count;
+    image_create_info.arrayLayers = 1;
+    image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_create_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(logical_device, &image_create_info, nullptr, &image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create texture image");
+    }
+
+    image_memory = memory.allocate_image(image, image_create_info.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkSamplerCreateInfo sampler_create_info{};
+    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_create_info.magFilter = linear_filtering ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+    sampler_create_info.minFilter = sampler_create_info.magFilter;
+    sampler_create_info.mipmapMode = linear_filtering ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.minLod = 0.0f;
+    sampler_create_info.maxLod = static_cast<float>(level_count);
+
+    if (vkCreateSampler(logical_device, &sampler_create_info, nullptr, &sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create texture sampler");
+    }
+
+    // One view and descriptor set per possible finest resident level
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_size.descriptorCount = level_count;
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = level_count;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &descriptor_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create texture descriptor pool");
+    }
+
+    views.resize(level_count);
+    descriptor_sets.resize(level_count);
+
+    for (uint32_t level = 0; level < level_count; ++level)
+    {
+        VkImageViewCreateInfo image_view_create_info{};
+        image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        image_view_create_info.image = image;
+        image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        image_view_create_info.format = format;
+        image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        image_view_create_info.subresourceRange.baseMipLevel = level;
+        image_view_create_info.subresourceRange.levelCount = level_count - level;
+        image_view_create_info.subresourceRange.baseArrayLayer = 0;
+        image_view_create_info.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(logical_device, &image_view_create_info, nullptr, &views[level]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to create texture image view");
+        }
+
+        VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptor_set_allocate_info.descriptorPool = descriptor_pool;
+        descriptor_set_allocate_info.descriptorSetCount = 1;
+        descriptor_set_allocate_info.pSetLayouts = &set_layout;
+
+        if (vkAllocateDescriptorSets(logical_device, &descriptor_set_allocate_info, &descriptor_sets[level]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to allocate texture descriptor set");
+        }
+
+        // Written once, sets are never updated while a command buffer may reference them
+        VkDescriptorImageInfo image_info{};
+        image_info.sampler = sampler;
+        image_info.imageView = views[level];
+        image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptor_sets[level];
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &image_info;
+
+        vkUpdateDescriptorSets(logical_device, 1, &write, 0, nullptr);
+    }
+
+    // Staging ring, a segment always fits the budget and the largest level
+    VkDeviceSize largest_level = 0;
+
+    for (const mip_level& level : levels)
+    {
+        largest_level = std::max(largest_level, level.size);
+    }
+
+    segment_size = align_up(std::max(frame_budget, largest_level), staging_alignment);
+    staging = create_buffer(memory, segment_size * slot_count, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    command_pool_create_info.queueFamilyIndex = device.graphics_queue_index;
+
+    if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create texture upload command pool");
+    }
+
+    slots.resize(slot_count);
+
+    for (slot_state& slot : slots)
+    {
+        VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+        command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        command_buffer_allocation_info.commandPool = command_pool;
+        command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        command_buffer_allocation_info.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, &slot.command_buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Unable to allocate texture upload command buffer");
+        }
+    }
+
+    pending_levels = level_count;
+}
+
+void texture_streamer::destroy()
+{
+    // Destroying the pools frees the command buffers and descriptor sets
+    vkDestroyCommandPool(logical_device, command_pool, nullptr);
+    vkDestroyDescriptorPool(logical_device, descriptor_pool, nullptr);
+
+    for (VkImageView view : views)
+    {
+        vkDestroyImageView(logical_device, view, nullptr);
+    }
+
+    vkDestroySampler(logical_device, sampler, nullptr);
+    vkDestroyImage(logical_device, image, nullptr);
+    allocator->free(image_memory);
+    destroy_buffer(*allocator, staging);
+
+    if (file_data != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(file_data), file_size);
+    }
+
+    views.clear();
+    descriptor_sets.clear();
+    slots.clear();
+    levels.clear();
+    file_data = nullptr;
+    command_pool = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer texture_streamer::stream(uint32_t slot)
+{
+    if (pending_levels == 0)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    slot_state& state = slots[slot];
+    const auto copy_start = std::chrono::steady_clock::now();
+
+    if (pending_levels == levels.size())
+    {
+        upload_start = copy_start;
+    }
+
+    // Copy whole levels from the mapping into the slot's segment until the budget is spent
+    unsigned char* segment = static_cast<unsigned char*>(staging.allocation.mapped) + slot * segment_size;
+    const uint32_t finest_pending = pending_levels;
+    std::vector<VkBufferImageCopy> regions;
+    VkDeviceSize used = 0;
+    VkDeviceSize copied = 0;
+
+    while (pending_levels > 0)
+    {
+        const uint32_t level_index = pending_levels - 1;
+        const mip_level& level = levels[level_index];
+        const VkDeviceSize offset = align_up(used, staging_alignment);
+
+        if (!regions.empty() && offset + level.size > frame_budget)
+        {
+            break;
+        }
+
+        std::memcpy(segment + offset, file_data + level.offset, level.size);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = slot * segment_size + offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level_index;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {level.width, level.height, 1};
+
+        regions.push_back(region);
+        used = offset + level.size;
+        copied += level.size;
+        --pending_levels;
+    }
+
+    copy_milliseconds += milliseconds_between(copy_start, std::chrono::steady_clock::now());
+    state.bytes_in_flight = copied;
+
+    // Record the copies between layout transitions of the levels they fill
+    vkResetCommandBuffer(state.command_buffer, 0);
+
+    VkCommandBufferBeginInfo command_buffer_begin_info{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(state.command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to begin recording texture upload command buffer");
+    }
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = pending_levels;
+    barrier.subresourceRange.levelCount = finest_pending - pending_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(state.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkCmdCopyBufferToImage(state.command_buffer, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(regions.size()), regions.data());
+
+    // Frames submitted after this buffer sample the new levels in their fragment shaders
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    vkCmdPipelineBarrier(state.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    if (vkEndCommandBuffer(state.command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to record texture upload command buffer");
+    }
+
+    return state.command_buffer;
+}
+
+void texture_streamer::collect(uint32_t slot)
+{
+    if (slot >= slots.size() || slots[slot].bytes_in_flight == 0)
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    bytes_completed += slots[slot].bytes_in_flight;
+    slots[slot].bytes_in_flight = 0;
+    last_level_done = now;
+
+    if (!first_frame_seen)
+    {
+        first_frame_done = now;
+        first_frame_seen = true;
+    }
+}
+
+VkDescriptorSet texture_streamer::descriptor_set() const
+{
+    return descriptor_sets[std::min<size_t>(pending_levels, descriptor_sets.size() - 1)];
+}
+
+void texture_streamer::report(std::ostream& output) const
+{
+    VkDeviceSize total_bytes = 0;
+
+    for (const mip_level& level : levels)
+    {
+        total_bytes += level.size;
+    }
+
+    output << "Texture: " << levels[0].width << "x" << levels[0].height << ", " << levels.size() << " levels, "
+           << bytes_completed / 1024 << " of " << total_bytes / 1024 << " KiB uploaded, "
+           << copy_milliseconds << " ms copying from the mapping\n";
+
+    if (first_frame_seen)
+    {
+        output << "Texture time to first frame: " << milliseconds_between(load_start, first_frame_done) << " ms\n";
+    }
+
+    if (bytes_completed == total_bytes)
+    {
+        const double upload_milliseconds = milliseconds_between(upload_start, last_level_done);
+
+        output << "Texture fully resident after " << milliseconds_between(load_start, last_level_done) << " ms, "
+               << (upload_milliseconds > 0.0 ? total_bytes / (1024.0 * 1024.0) / (upload_milliseconds / 1000.0) : 0.0)
+               << " MiB/s upload bandwidth\n";
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef _TEXTURE_STREAMER_HPP_
+#define _TEXTURE_STREAMER_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+#include "geometry.hpp"
+#include "memory_allocator.hpp"
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Layout of the descriptor sets texture_streamer hands out, a combined image sampler at binding 0
+// read by textured.frag
+VkDescriptorSetLayout create_texture_set_layout(VkDevice logical_device);
+
+// Streams the precomputed mip levels of a KTX2 file into a sampled image. The file is mapped
+// rather than read, and each level is copied once, straight from the mapping into the frame
+// slot's part of a persistently mapped staging ring. Levels go up coarsest first, so the first
+// frame already samples a small mip and finer levels fill in over the following frames.
+class texture_streamer
+{
+public:
+    // frame_budget caps the bytes uploaded per frame, although a level larger than the budget
+    // is still uploaded whole
+    void create(const device_context& device, memory_allocator& allocator, const std::string& path,
+        VkDescriptorSetLayout set_layout, uint32_t slot_count, VkDeviceSize frame_budget);
+    void destroy();
+
+    // Copies the next levels and returns the command buffer uploading them, VK_NULL_HANDLE once
+    // every level is resident. It must be submitted ahead of the frame in the same batch.
+    VkCommandBuffer stream(uint32_t slot);
+
+    // Marks the slot's last upload as complete, called once the fence of its frame has signalled
+    void collect(uint32_t slot);
+
+    // Samples every level uploaded so far, valid after the first stream call
+    VkDescriptorSet descriptor_set() const;
+
+    // Upload bandwidth and time to the first textured frame and to the last level
+    void report(std::ostream& output) const;
+
+private:
+    struct mip_level
+    {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    struct slot_state
+    {
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkDeviceSize bytes_in_flight = 0;
+    };
+
+    void map_file(const std::string& path);
+    void parse_header();
+
+    memory_allocator* allocator = nullptr;
+    VkDevice logical_device = VK_NULL_HANDLE;
+
+    // Read only mapping of the whole file
+    const unsigned char* file_data = nullptr;
+    size_t file_size = 0;
+
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    std::vector<mip_level> levels;
+
+    VkImage image = VK_NULL_HANDLE;
+    memory_allocation image_memory;
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+
+    // Indexed by the finest resident level, each view starts at that level so nothing samples a
+    // level that has not arrived yet
+    std::vector<VkImageView> views;
+    std::vector<VkDescriptorSet> descriptor_sets;
+
+    // Staging ring, one segment per frame slot
+    gpu_buffer staging;
+    VkDeviceSize segment_size = 0;
+    VkDeviceSize frame_budget = 0;
+
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    std::vector<slot_state> slots;
+
+    // Levels not uploaded yet, always the finest ones, so this is also the finest resident level
+    uint32_t pending_levels = 0;
+
+    // Completion is only observed when a slot is collected, so the times are rounded up to the
+    // frame that reuses the slot
+    std::chrono::steady_clock::time_point load_start;
+    std::chrono::steady_clock::time_point upload_start;
+    std::chrono::steady_clock::time_point first_frame_done;
+    std::chrono::steady_clock::time_point last_level_done;
+    VkDeviceSize bytes_completed = 0;
+    double copy_milliseconds = 0.0;
+    bool first_frame_seen = false;
+};
+
+#endif
@@ -0,0 +1,365 @@
+#include "uniform_ring.hpp"
+
+#include "frame_statistics.hpp"
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+// Frames recorded and submitted per method by benchmark_uniform_updates
+static const uint32_t benchmark_frames = 20;
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkDescriptorSetLayout create_uniform_set_layout(VkDevice logical_device)
+{
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = 1;
+    descriptor_set_layout_create_info.pBindings = &binding;
+
+    VkDescriptorSetLayout set_layout;
+
+    if (vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &set_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create uniform descriptor set layout");
+    }
+
+    return set_layout;
+}
+
+void uniform_ring::create(const device_context& device, memory_allocator& memory, VkDescriptorSetLayout set_layout,
+    uint32_t slot_count, uint32_t slot_allocations, VkDeviceSize range)
+{
+    allocator = &memory;
+    logical_device = device.logical_device;
+    allocation_range = range;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.physical_device, &properties);
+
+    if (range > properties.limits.maxUniformBufferRange)
+    {
+        throw std::runtime_error("Uniform ring range exceeds maxUniformBufferRange");
+    }
+
+    offset_alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    segment_size = align_up(range, offset_alignment) * slot_allocations;
+    heads.assign(slot_count, 0);
+
+    // Coherent, so writes through the mapping need no flush before the frame is submitted
+    ring = create_buffer(memory, segment_size * slot_count, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    pool_size.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = 1;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &descriptor_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create uniform descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = 1;
+    descriptor_set_allocate_info.pSetLayouts = &set_layout;
+
+    if (vkAllocateDescriptorSets(logical_device, &descriptor_set_allocate_info, &set) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate uniform descriptor set");
+    }
+
+    // Written once, the dynamic offset selects the allocation when the set is bound
+    VkDescriptorBufferInfo buffer_info{};
+    buffer_info.buffer = ring.buffer;
+    buffer_info.offset = 0;
+    buffer_info.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo = &buffer_info;
+
+    vkUpdateDescriptorSets(logical_device, 1, &write, 0, nullptr);
+}
+
+void uniform_ring::destroy()
+{
+    // Destroying the pool frees the descriptor set
+    vkDestroyDescriptorPool(logical_device, descriptor_pool, nullptr);
+    destroy_buffer(*allocator, ring);
+
+    heads.clear();
+    descriptor_pool = VK_NULL_HANDLE;
+    set = VK_NULL_HANDLE;
+}
+
+void uniform_ring::reset(uint32_t slot)
+{
+    heads[slot] = 0;
+}
+
+void* uniform_ring::allocate(uint32_t slot, VkDeviceSize size, uint32_t& dynamic_offset)
+{
+    if (size > allocation_range)
+    {
+        throw std::runtime_error("Uniform allocation is larger than the ring's range");
+    }
+
+    const VkDeviceSize offset = align_up(heads[slot], offset_alignment);
+
+    // The descriptor reads a whole range from the offset, which has to stay inside the buffer
+    if (offset + allocation_range > segment_size)
+    {
+        throw std::runtime_error("Uniform ring slot is full");
+    }
+
+    heads[slot] = offset + size;
+
+    const VkDeviceSize ring_offset = slot * segment_size + offset;
+    dynamic_offset = static_cast<uint32_t>(ring_offset);
+
+    return static_cast<unsigned char*>(ring.allocation.mapped) + ring_offset;
+}
+
+VkDescriptorSet uniform_ring::descriptor_set() const
+{
+    return set;
+}
+
+VkBuffer uniform_ring::buffer() const
+{
+    return ring.buffer;
+}
+
+void benchmark_uniform_updates(const device_context& device, memory_allocator& allocator, VkRenderPass render_pass,
+    VkFramebuffer framebuffer, VkExtent2D extent, VkPipeline pipeline, VkPipelineLayout pipeline_layout,
+    VkDescriptorSetLayout set_layout, const scene_geometry& geometry, uint32_t draw_count, std::ostream& output)
+{
+    VkDevice logical_device = device.logical_device;
+
+    // Command buffer and fence reused by every frame, each frame is waited on before the next is recorded
+    VkCommandPool command_pool;
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    command_pool_create_info.queueFamilyIndex = device.graphics_queue_index;
+
+    if (vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create benchmark command pool");
+    }
+
+    VkCommandBuffer command_buffer;
+    VkCommandBufferAllocateInfo command_buffer_allocation_info{};
+    command_buffer_allocation_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocation_info.commandPool = command_pool;
+    command_buffer_allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocation_info.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocation_info, &command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate benchmark command buffer");
+    }
+
+    VkFence fence;
+    VkFenceCreateInfo fence_create_info{};
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(logical_device, &fence_create_info, nullptr, &fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create benchmark fence");
+    }
+
+    // Room for the frame's uniforms and one allocation per draw
+    uniform_ring ring;
+    ring.create(device, allocator, set_layout, 1, draw_count + 1, sizeof(frame_uniforms));
+
+    // One set per draw for the rewriting method, a set must not be updated once a command buffer
+    // being recorded has bound it
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    pool_size.descriptorCount = draw_count;
+
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.maxSets = draw_count;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &descriptor_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to create benchmark descriptor pool");
+    }
+
+    std::vector<VkDescriptorSet> draw_sets(draw_count);
+    std::vector<VkDescriptorSetLayout> draw_set_layouts(draw_count, set_layout);
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = draw_count;
+    descriptor_set_allocate_info.pSetLayouts = draw_set_layouts.data();
+
+    if (vkAllocateDescriptorSets(logical_device, &descriptor_set_allocate_info, draw_sets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Unable to allocate benchmark descriptor sets");
+    }
+
+    const uint32_t instance_count = std::max(geometry.instance_count, 1u);
+    const VkDescriptorSet ring_set = ring.descriptor_set();
+
+    // Records and submits benchmark_frames frames with record_draw called for every draw, after
+    // the pipeline, geometry and an unrotated frame set are bound
+    auto run = [&](const char* method, auto record_draw) {
+        double recording_milliseconds = 0.0;
+        double gpu_milliseconds = 0.0;
+
+        for (uint32_t frame = 0; frame < benchmark_frames; ++frame)
+        {
+            const auto record_start = std::chrono::steady_clock::now();
+            vkResetCommandPool(logical_device, command_pool, 0);
+            ring.reset(0);
+
+            VkCommandBufferBeginInfo command_buffer_begin_info{};
+            command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+            if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Unable to begin recording benchmark command buffer");
+            }
+
+            VkRenderPassBeginInfo render_pass_begin_info{};
+            render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            render_pass_begin_info.renderPass = render_pass;
+            render_pass_begin_info.framebuffer = framebuffer;
+            render_pass_begin_info.renderArea.offset = {0, 0};
+            render_pass_begin_info.renderArea.extent = extent;
+
+            VkClearValue clear_color = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+            render_pass_begin_info.clearValueCount = 1;
+            render_pass_begin_info.pClearValues = &clear_color;
+
+            vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            set_viewport(command_buffer, extent);
+
+            VkBuffer vertex_buffers[] = {geometry.vertices.buffer, geometry.instances.buffer};
+            VkDeviceSize vertex_offsets[] = {0, 0};
+            vkCmdBindVertexBuffers(command_buffer, 0, 2, vertex_buffers, vertex_offsets);
+            vkCmdBindIndexBuffer(command_buffer, geometry.indices.buffer, 0, VK_INDEX_TYPE_UINT16);
+
+            uint32_t frame_offset;
+            *static_cast<frame_uniforms*>(ring.allocate(0, sizeof(frame_uniforms), frame_offset)) = frame_uniforms{};
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1,
+                &ring_set, 1, &frame_offset);
+
+            const draw_constants constants;
+            vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+
+            for (uint32_t draw = 0; draw < draw_count; ++draw)
+            {
+                record_draw(draw);
+                vkCmdDrawIndexed(command_buffer, geometry.index_count, 1, 0, 0, draw % instance_count);
+            }
+
+            vkCmdEndRenderPass(command_buffer);
+
+            if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Unable to record benchmark command buffer");
+            }
+
+            const auto submit_start = std::chrono::steady_clock::now();
+
+            VkSubmitInfo submit_info{};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &command_buffer;
+
+            if (vkQueueSubmit(device.graphics_queue, 1, &submit_info, fence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Unable to submit benchmark command buffer");
+            }
+
+            vkWaitForFences(logical_device, 1, &fence, VK_TRUE, UINT64_MAX);
+            vkResetFences(logical_device, 1, &fence);
+
+            const auto submit_end = std::chrono::steady_clock::now();
+            recording_milliseconds += milliseconds_between(record_start, submit_start);
+            gpu_milliseconds += milliseconds_between(submit_start, submit_end);
+        }
+
+        output << "Per draw updates through " << method << ": " << recording_milliseconds / benchmark_frames
+               << " ms recording, " << gpu_milliseconds / benchmark_frames << " ms submit to fence per frame\n";
+    };
+
+    output << "Uniform update benchmark, " << draw_count << " draws per frame\n";
+
+    // Data travels inside the command buffer, nothing is written to memory
+    run("push constants", [&](uint32_t draw) {
+        draw_constants constants;
+        constants.tint[1] = static_cast<float>(draw % 256) / 255.0f;
+        vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+    });
+
+    // Data is written to the ring and the one set is rebound at a new offset
+    run("dynamic uniform offsets", [&](uint32_t draw) {
+        uint32_t offset;
+        static_cast<frame_uniforms*>(ring.allocate(0, sizeof(frame_uniforms), offset))->rotation = 0.01f * draw;
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1,
+            &ring_set, 1, &offset);
+    });
+
+    // Data is written to the ring and a set is rewritten to point at it, the baseline the ring avoids
+    run("descriptor rewrites", [&](uint32_t draw) {
+        uint32_t offset;
+        static_cast<frame_uniforms*>(ring.allocate(0, sizeof(frame_uniforms), offset))->rotation = 0.01f * draw;
+
+        VkDescriptorBufferInfo buffer_info{};
+        buffer_info.buffer = ring.buffer();
+        buffer_info.offset = offset;
+        buffer_info.range = sizeof(frame_uniforms);
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = draw_sets[draw];
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        write.pBufferInfo = &buffer_info;
+
+        vkUpdateDescriptorSets(logical_device, 1, &write, 0, nullptr);
+
+        const uint32_t no_offset = 0;
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1,
+            &draw_sets[draw], 1, &no_offset);
+    });
+
+    vkDestroyDescriptorPool(logical_device, descriptor_pool, nullptr);
+    ring.destroy();
+    vkDestroyFence(logical_device, fence, nullptr);
+    vkDestroyCommandPool(logical_device, command_pool, nullptr);
+}
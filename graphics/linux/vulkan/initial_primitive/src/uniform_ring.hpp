@@ -0,0 +1,63 @@
+#ifndef _UNIFORM_RING_HPP_
+#define _UNIFORM_RING_HPP_
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+#include "geometry.hpp"
+#include "memory_allocator.hpp"
+
+#include <ostream>
+#include <vector>
+
+// Layout of the ring's descriptor set, a dynamic uniform buffer at binding 0 read by the vertex shader
+VkDescriptorSetLayout create_uniform_set_layout(VkDevice logical_device);
+
+// Host visible, persistently mapped uniform buffer split into one segment per frame slot. Data is
+// bump allocated from the slot's segment and bound through a single descriptor set with a
+// dynamic offset, so nothing is written to descriptors per frame. A slot must only be reset once
+// the GPU has finished the submission that last read it.
+class uniform_ring
+{
+public:
+    // range is the most bytes a single allocation may hold, as seen through the descriptor, and
+    // each slot has room for slot_allocations of them
+    void create(const device_context& device, memory_allocator& allocator, VkDescriptorSetLayout set_layout,
+        uint32_t slot_count, uint32_t slot_allocations, VkDeviceSize range);
+    void destroy();
+
+    void reset(uint32_t slot);
+
+    // Returns where to write size bytes, dynamic_offset is the offset to bind the set with. Throws
+    // when size exceeds the range or the slot is full.
+    void* allocate(uint32_t slot, VkDeviceSize size, uint32_t& dynamic_offset);
+
+    VkDescriptorSet descriptor_set() const;
+    VkBuffer buffer() const;
+
+private:
+    memory_allocator* allocator = nullptr;
+    VkDevice logical_device = VK_NULL_HANDLE;
+    gpu_buffer ring;
+
+    // Dynamic offsets are multiples of minUniformBufferOffsetAlignment
+    VkDeviceSize offset_alignment = 1;
+    VkDeviceSize segment_size = 0;
+    VkDeviceSize allocation_range = 0;
+
+    // Next free byte of each slot's segment, relative to the segment
+    std::vector<VkDeviceSize> heads;
+
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+};
+
+// Records draw_count single instance draws, updating per draw data through push constants, a
+// dynamic uniform buffer offset and a rewritten descriptor set in turn, and prints the recording
+// and GPU time of each. pipeline_layout must have the uniform set at set 0 and the draw constants.
+void benchmark_uniform_updates(const device_context& device, memory_allocator& allocator, VkRenderPass render_pass,
+    VkFramebuffer framebuffer, VkExtent2D extent, VkPipeline pipeline, VkPipelineLayout pipeline_layout,
+    VkDescriptorSetLayout set_layout, const scene_geometry& geometry, uint32_t draw_count, std::ostream& output);
+
+#endif
@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern int add(int, int);
+extern int64_t sum_array(const int64_t*, size_t);
+
+// Trivial calls are chained through their result, so each one waits for the previous
+#define CALLS 100000000
+#define BULK_BYTES (64 << 20)
+#define BULK_REPEATS 20
+
+static uint64_t now_ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+	int result = 0;
+	uint64_t start = now_ns();
+
+	for (int i = 0; i < CALLS; ++i)
+	{
+		result = add(result, 1);
+	}
+
+	const double call_ns = (double) (now_ns() - start) / CALLS;
+
+	const size_t count = BULK_BYTES / sizeof(int64_t);
+	int64_t* values = malloc(BULK_BYTES);
+
+	if (values == NULL || result != CALLS)
+	{
+		fprintf(stderr, "Unable to run benchmark\n");
+		return 1;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		values[i] = (int64_t) i;
+	}
+
+	// Best of several passes, the first also faults the pages in
+	double best_ns = 0.0;
+
+	for (int repeat = 0; repeat < BULK_REPEATS; ++repeat)
+	{
+		start = now_ns();
+		const int64_t sum = sum_array(values, count);
+		const double elapsed_ns = (double) (now_ns() - start);
+
+		if (sum != (int64_t) (count * (count - 1) / 2))
+		{
+			fprintf(stderr, "sum_array returned %lld\n", (long long) sum);
+			return 1;
+		}
+
+		if (repeat == 0 || elapsed_ns < best_ns)
+		{
+			best_ns = elapsed_ns;
+		}
+	}
+
+	free(values);
+
+	printf("C -> asm: %.2f ns/call, %.2f GB/s\n", call_ns, BULK_BYTES / best_ns);
+	printf("RESULT\tC -> asm\t%.3f\t%.3f\n", call_ns, BULK_BYTES / best_ns);
+
+	return 0;
+}
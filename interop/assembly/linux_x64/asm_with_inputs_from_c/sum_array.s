@@ -0,0 +1,27 @@
+.text
+.global sum_array
+.type sum_array, @function
+
+# int64_t sum_array(const int64_t* values, size_t count), two accumulators so consecutive adds
+# do not wait on each other
+sum_array:
+	xorq %rax, %rax
+	xorq %rdx, %rdx
+	movq %rsi, %rcx
+	shrq $1, %rcx
+	jz 2f
+1:
+	addq (%rdi), %rax
+	addq 8(%rdi), %rdx
+	addq $16, %rdi
+	decq %rcx
+	jnz 1b
+2:
+	testq $1, %rsi
+	jz 3f
+	addq (%rdi), %rax
+3:
+	addq %rdx, %rax
+	ret
+
+.section .note.GNU-stack,"",@progbits
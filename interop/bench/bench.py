@@ -0,0 +1,115 @@
+#! /usr/bin/env python3
+
+"""Builds and runs the call overhead benchmark of every interop mechanism and prints them side by side.
+
+Each variant calls add(int, int) in a chain, timing the average cost of one call, and passes a 64 MiB
+array of 64 bit integers to sum_array without copying it, timing the best of several passes. A variant
+prints a "RESULT<tab>mechanism<tab>ns per call<tab>GB/s" line, which is all this driver reads.
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+
+INTEROP_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Name, tools that have to be on PATH, directories built with make in order, directory run in, command
+VARIANTS = [
+    ("asm", [], ["assembly/linux_x64/asm_with_inputs_from_c"], "assembly/linux_x64/asm_with_inputs_from_c",
+        ["make", "bench"], ["./bench"]),
+    ("rust", ["cargo"], ["rust/rust_from_c"], "rust/rust_from_c", ["make", "bench"], ["./bench"]),
+    ("ctypes", [], ["python/ctypes"], "python/ctypes", ["make"], [sys.executable, "bench.py"]),
+    ("cffi", [], ["python/ctypes"], "python/ffi", ["make"], [sys.executable, "bench.py"]),
+    ("embedded", ["python3.9-config"], ["python/extend_embedded_cpython"], "python/extend_embedded_cpython",
+        ["make"], ["./main", "bench.py"]),
+]
+
+# Exit status a variant uses when a dependency it needs is missing
+SKIPPED = 77
+
+
+def run_variant(tools, build_directories, run_directory, build_command, command, timeout):
+    """Returns the variant's (mechanism, ns per call, GB/s) results, or None when a dependency is missing,
+    raises RuntimeError on failure"""
+    if not all(shutil.which(tool) for tool in tools):
+        return None
+
+    for directory in build_directories:
+        process = subprocess.run(build_command, cwd=os.path.join(INTEROP_DIR, directory), stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT, universal_newlines=True)
+
+        if process.returncode != 0:
+            raise RuntimeError("build failed in %s:\n%s" % (directory, process.stdout))
+
+    process = subprocess.run(command, cwd=os.path.join(INTEROP_DIR, run_directory), stdout=subprocess.PIPE,
+        stderr=subprocess.STDOUT, timeout=timeout, universal_newlines=True)
+
+    if process.returncode == SKIPPED:
+        return None
+
+    if process.returncode != 0:
+        raise RuntimeError("exited with status %d:\n%s" % (process.returncode, process.stdout))
+
+    results = []
+
+    for line in process.stdout.splitlines():
+        fields = line.split("\t")
+
+        if len(fields) == 4 and fields[0] == "RESULT":
+            results.append((fields[1], float(fields[2]), float(fields[3])))
+
+    if not results:
+        raise RuntimeError("printed no RESULT line:\n%s" % process.stdout)
+
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("variants", nargs="*", help="variants to run, all of them by default")
+    parser.add_argument("--timeout", type=float, default=300.0, help="seconds a single variant may run")
+    arguments = parser.parse_args()
+
+    known = {variant[0]: variant for variant in VARIANTS}
+    selected = arguments.variants or [variant[0] for variant in VARIANTS]
+
+    for name in selected:
+        if name not in known:
+            parser.error("unknown variant %s, expected one of %s" % (name, ", ".join(known)))
+
+    rows = []
+    failures = 0
+
+    for name in selected:
+        _, tools, build_directories, run_directory, build_command, command = known[name]
+
+        try:
+            results = run_variant(tools, build_directories, run_directory, build_command, command,
+                arguments.timeout)
+        except (OSError, RuntimeError, subprocess.TimeoutExpired) as error:
+            print("%s: %s" % (name, error), file=sys.stderr)
+            rows.append((name, "failed"))
+            failures += 1
+            continue
+
+        if results is None:
+            rows.append((name, "skipped, a dependency is missing"))
+            continue
+
+        rows.extend(results)
+
+    print("\n%-36s %12s %10s" % ("mechanism", "ns/call", "GB/s"))
+
+    for row in rows:
+        if len(row) == 2:
+            print("%-36s %s" % row)
+        else:
+            print("%-36s %12.2f %10.2f" % row)
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
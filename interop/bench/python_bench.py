@@ -0,0 +1,39 @@
+"""Timing loop shared by the Python variants of the call overhead benchmark, see README.md"""
+
+import array
+import time
+
+# Far fewer calls than the native benchmarks, each one crosses the interpreter
+CALLS = 2000000
+BULK_BYTES = 64 << 20
+BULK_REPEATS = 20
+
+
+def run(mechanism, add, sum_array, wrap_values):
+    """Times a chain of add(int, int) calls and the best pass of sum_array over BULK_BYTES of int64,
+    then prints the RESULT line bench.py reads. wrap_values turns the array.array("q") into the
+    arguments of sum_array once, before any pass is timed."""
+    result = 0
+    start = time.perf_counter_ns()
+
+    for _ in range(CALLS):
+        result = add(result, 1)
+
+    call_ns = (time.perf_counter_ns() - start) / CALLS
+    assert result == CALLS
+
+    count = BULK_BYTES // 8
+    values = array.array("q", range(count))
+    arguments = wrap_values(values)
+    best_ns = None
+
+    for _ in range(BULK_REPEATS):
+        start = time.perf_counter_ns()
+        total = sum_array(*arguments)
+        elapsed_ns = time.perf_counter_ns() - start
+
+        assert total == count * (count - 1) // 2
+        best_ns = elapsed_ns if best_ns is None else min(best_ns, elapsed_ns)
+
+    print("%s: %.2f ns/call, %.2f GB/s" % (mechanism, call_ns, BULK_BYTES / best_ns))
+    print("RESULT\t%s\t%.3f\t%.3f" % (mechanism, call_ns, BULK_BYTES / best_ns))
@@ -0,0 +1,27 @@
+#! /usr/bin/env python3
+
+"""Call overhead of add and throughput of sum_array through ctypes, see interop/bench"""
+
+import ctypes
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "bench"))
+
+import python_bench
+
+if __name__ == "__main__":
+    so = ctypes.cdll.LoadLibrary("./libffi.so")
+
+    # Declared types let ctypes skip guessing the conversions on every call
+    add = so.add
+    add.argtypes = (ctypes.c_int, ctypes.c_int)
+    add.restype = ctypes.c_int
+
+    sum_array = so.sum_array
+    sum_array.argtypes = (ctypes.POINTER(ctypes.c_int64), ctypes.c_size_t)
+    sum_array.restype = ctypes.c_int64
+
+    # The buffer is passed by pointer, nothing is copied across the boundary
+    python_bench.run("Python -> C (ctypes)", add, sum_array,
+        lambda values: ((ctypes.c_int64 * len(values)).from_buffer(values), len(values)))
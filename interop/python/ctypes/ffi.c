@@ -1,6 +1,22 @@
+#include <stdint.h>
+#include <stddef.h>
 #include <stdio.h>
 
 void print_hello(void) {
 	printf("Hello from C!\n");
 }
 
+int add(int a, int b) {
+	return a + b;
+}
+
+int64_t sum_array(const int64_t* values, size_t count) {
+	int64_t sum = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		sum += values[i];
+	}
+
+	return sum;
+}
+
@@ -0,0 +1,16 @@
+#!/usr/bin/env python3
+
+"""Call overhead of add and throughput of sum_array through an extension module of an embedding
+program, run as ./main bench.py, see interop/bench"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "bench"))
+
+import embed
+import python_bench
+
+if __name__ == "__main__":
+    # The module reads the array through the buffer protocol, nothing is copied
+    python_bench.run("Python -> C (embedded extension)", embed.add, embed.sum_array, lambda values: (values,))
@@ -1,6 +1,7 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
 static PyObject* embed_say_hello(PyObject* self, PyObject* args)
@@ -9,8 +10,50 @@ static PyObject* embed_say_hello(PyObject* self, PyObject* args)
 	Py_RETURN_NONE;
 }
 
+static PyObject* embed_add(PyObject* self, PyObject* args)
+{
+	int a, b;
+
+	if (!PyArg_ParseTuple(args, "ii", &a, &b))
+	{
+		return NULL;
+	}
+
+	return PyLong_FromLong((long) a + b);
+}
+
+// Sums any contiguous buffer of 64 bit integers in place, such as an array.array("q")
+static PyObject* embed_sum_array(PyObject* self, PyObject* args)
+{
+	Py_buffer buffer;
+
+	if (!PyArg_ParseTuple(args, "y*", &buffer))
+	{
+		return NULL;
+	}
+
+	const int64_t* values = buffer.buf;
+	const Py_ssize_t count = buffer.len / (Py_ssize_t) sizeof(int64_t);
+	int64_t sum = 0;
+
+	// The interpreter is not touched while summing, so other threads may run
+	Py_BEGIN_ALLOW_THREADS
+
+	for (Py_ssize_t i = 0; i < count; ++i)
+	{
+		sum += values[i];
+	}
+
+	Py_END_ALLOW_THREADS
+
+	PyBuffer_Release(&buffer);
+	return PyLong_FromLongLong(sum);
+}
+
 static PyMethodDef EmbedMethods[] = {
 	{"say_hello", embed_say_hello, METH_VARARGS, "Says hello"},
+	{"add", embed_add, METH_VARARGS, "Adds two integers"},
+	{"sum_array", embed_sum_array, METH_VARARGS, "Sums a buffer of 64 bit integers"},
 	{NULL, NULL, 0, NULL}
 };
 
@@ -26,22 +69,24 @@ static PyObject* PyInit_embed(void)
 
 int main(int argc, char** argv)
 {
-	FILE* script = fopen("main.py", "r");
+	// Runs main.py unless another script is named, such as bench.py
+	const char* script_path = argc > 1 ? argv[1] : "main.py";
+	FILE* script = fopen(script_path, "r");
 
 	if (script == NULL)
 	{
 		exit(1);
 	}
 
-
 	PyImport_AppendInittab("embed", &PyInit_embed);
 	Py_Initialize();
-	PyRun_SimpleFileEx(script, "main.py", true);
+	// The traceback of an uncaught exception has been printed, the exit status reports it
+	const int status = PyRun_SimpleFileEx(script, script_path, true) == 0 ? 0 : 1;
 
 	if (Py_FinalizeEx() < 0)
 	{
 		exit(120);
 	}
 
-	return 0;
+	return status;
 }
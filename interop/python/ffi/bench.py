@@ -0,0 +1,30 @@
+#!/usr/bin/env  python3
+
+"""Call overhead of add and throughput of sum_array through cffi, see interop/bench"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "bench"))
+
+import python_bench
+
+try:
+    import cffi
+except ImportError:
+    print("cffi is not installed, see requirements.txt", file=sys.stderr)
+    sys.exit(77)
+
+if __name__ == "__main__":
+    ffi = cffi.FFI()
+    ffi.cdef("""
+        int add(int a, int b);
+        int64_t sum_array(const int64_t* values, size_t count);
+    """)
+
+    # ABI mode against the library the ctypes sample builds, so both call the same code
+    C = ffi.dlopen("../ctypes/libffi.so")
+
+    # from_buffer hands over a pointer to the array's storage without copying it
+    python_bench.run("Python -> C (cffi)", C.add, C.sum_array,
+        lambda values: (ffi.from_buffer("int64_t[]", values), len(values)))
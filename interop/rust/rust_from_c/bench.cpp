@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+extern "C" int add(int a, int b);
+extern "C" int64_t sum_array(const int64_t* values, size_t count);
+
+// Trivial calls are chained through their result, so each one waits for the previous
+static const int calls = 100000000;
+static const size_t bulk_bytes = 64 << 20;
+static const int bulk_repeats = 20;
+
+static double nanoseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    int result = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < calls; ++i)
+    {
+        result = add(result, 1);
+    }
+
+    const double call_ns = nanoseconds_since(start) / calls;
+
+    if (result != calls)
+    {
+        std::fprintf(stderr, "add returned %d\n", result);
+        return 1;
+    }
+
+    std::vector<int64_t> values(bulk_bytes / sizeof(int64_t));
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] = static_cast<int64_t>(i);
+    }
+
+    // Best of several passes
+    double best_ns = 0.0;
+
+    for (int repeat = 0; repeat < bulk_repeats; ++repeat)
+    {
+        start = std::chrono::steady_clock::now();
+        const int64_t sum = sum_array(values.data(), values.size());
+        const double elapsed_ns = nanoseconds_since(start);
+
+        if (sum != static_cast<int64_t>(values.size() * (values.size() - 1) / 2))
+        {
+            std::fprintf(stderr, "sum_array returned %lld\n", static_cast<long long>(sum));
+            return 1;
+        }
+
+        if (repeat == 0 || elapsed_ns < best_ns)
+        {
+            best_ns = elapsed_ns;
+        }
+    }
+
+    std::printf("C++ -> Rust: %.2f ns/call, %.2f GB/s\n", call_ns, bulk_bytes / best_ns);
+    std::printf("RESULT\tC++ -> Rust\t%.3f\t%.3f\n", call_ns, bulk_bytes / best_ns);
+
+    return 0;
+}
@@ -2,3 +2,18 @@
 pub extern "C" fn say_hello() {
     println!("Hello from Rust!");
 }
+
+#[no_mangle]
+pub extern "C" fn add(a: i32, b: i32) -> i32 {
+    a.wrapping_add(b)
+}
+
+/// # Safety
+///
+/// `values` must point to `count` initialized values.
+#[no_mangle]
+pub unsafe extern "C" fn sum_array(values: *const i64, count: usize) -> i64 {
+    std::slice::from_raw_parts(values, count)
+        .iter()
+        .fold(0i64, |sum, value| sum.wrapping_add(*value))
+}
@@ -4,9 +4,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "sample_trace.h"
+
 int main(int argc, char** argv)
 {
+    sample_trace_start(NULL);
+
+    /* Ends in both processes, the child's span shows how long fork took to return there */
+    uint64_t trace_start = sample_trace_begin();
     pid_t forked_pid = fork();
+    sample_trace_end("fork", trace_start);
 
     if (forked_pid == 0)
     {
@@ -18,6 +25,7 @@ int main(int argc, char** argv)
         printf("PARENT: Waiting on process (%d)...\n", forked_pid);
         
         int status;
+        trace_start = sample_trace_begin();
 
         if (waitpid(forked_pid, &status, 0) == -1)
         {
@@ -25,6 +33,8 @@ int main(int argc, char** argv)
             exit(EXIT_FAILURE);
         }
 
+        sample_trace_end("waitpid", trace_start);
+
         printf("PARENT: Child exited successfully\n");
         exit(EXIT_SUCCESS);
     }
@@ -5,9 +5,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "sample_trace.h"
+
 int main(int argc, char** argv)
 {
+    sample_trace_start(NULL);
+
+    uint64_t trace_start = sample_trace_begin();
     DIR* dir = opendir(".");
+    sample_trace_end("opendir", trace_start);
 
     if (!dir)
     {
@@ -20,7 +26,9 @@ int main(int argc, char** argv)
     for (;;)
     {
         errno = 0;
+        trace_start = sample_trace_begin();
         struct dirent* result = readdir(dir);
+        sample_trace_end("readdir", trace_start);
 
         if (!result)
         {
@@ -5,9 +5,14 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "sample_trace.h"
+
 int main(int argc, char** argv)
 {
+    sample_trace_start(NULL);
+
     int pipe_fds[2];
+    uint64_t trace_start = sample_trace_begin();
 
     if (pipe(pipe_fds) == -1)
     {
@@ -15,7 +20,11 @@ int main(int argc, char** argv)
         exit(EXIT_FAILURE);
     }
 
+    sample_trace_end("pipe", trace_start);
+
+    trace_start = sample_trace_begin();
     pid_t child_pid = fork();
+    sample_trace_end("fork", trace_start);
 
     if (child_pid == -1)
     {
@@ -31,11 +40,15 @@ int main(int argc, char** argv)
         printf("CHILD: Received data - ");
         fflush(stdout);
 
+        trace_start = sample_trace_begin();
+
         while (read(pipe_fds[0], &received_char, 1) > 0)
         {
             write(STDOUT_FILENO, &received_char, 1);
         }
 
+        sample_trace_end("read_pipe", trace_start);
+
         write(STDOUT_FILENO, "\n", 1);
         close(pipe_fds[0]);
         exit(EXIT_SUCCESS);
@@ -46,11 +59,14 @@ int main(int argc, char** argv)
 
         printf("PARENT: Writing to pipe...\n");
         char* msg = "Hello from parent!";
+        trace_start = sample_trace_begin();
         write(pipe_fds[1], msg, strlen(msg));
+        sample_trace_end("write_pipe", trace_start);
 
         close(pipe_fds[1]);
         
         int status;
+        trace_start = sample_trace_begin();
         
         if (waitpid(child_pid, &status, 0) == -1)
         {
@@ -58,6 +74,8 @@ int main(int argc, char** argv)
             exit(EXIT_FAILURE);
         }
 
+        sample_trace_end("waitpid", trace_start);
+
         exit(EXIT_SUCCESS);
     }
 }
\ No newline at end of file